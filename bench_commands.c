@@ -0,0 +1,141 @@
+/**
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @copyright   Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @file    bench_commands.c
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @brief
+ * Host microbenchmark of the driver command path (no modem needed).
+ *
+ * A fake HAL answers each AT+CPIN? with "+CPIN: READY" and OK after a number of
+ * empty 1 ms polls, and delay() returns at once, so the time measured is the
+ * driver work per command: TX formatting, RX polls, response parsing and buffer
+ * handling. Build it with several RX buffer sizes: the time per command must not
+ * grow with the buffer capacity.
+ *
+ *   gcc -O2 -Isrc -o bench bench_commands.c src/bc66_drv.c && ./bench
+ *   gcc -O2 -Isrc -DBC66_RX_BUFFER_SIZE=8192 -o bench bench_commands.c src/bc66_drv.c && ./bench
+ *   ./bench <commands> <empty polls per command>
+ *
+ * Only the HAL fields every driver version has are set, so the same program
+ * also builds against older sources to compare them.
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @date    10/17/2026
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @author    Eng. Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @version    1.0.0
+ *
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bc66_drv.h"
+
+//*****************************************************************************
+// fake HAL: the answer comes after some empty polls
+
+static const char answer[] = "\r\n+CPIN: READY\r\n\r\nOK\r\n";
+static unsigned empty_polls = 20;
+static unsigned polls_left;
+static size_t answer_pos = sizeof(answer) - 1;
+
+static void hal_init( void ) {}
+static void hal_delay( uint32_t t ) { (void)t; }
+static void hal_pin( size_t value ) { (void)value; }
+
+static int hal_write_bytes( uint8_t * txc, uint16_t len )
+{
+	(void)txc;
+	polls_left = empty_polls;
+	answer_pos = 0;
+	return len;
+}
+
+static int hal_read_bytes( uint8_t * rxc, uint16_t size )
+{
+	size_t len = sizeof(answer) - 1 - answer_pos;
+
+	if( polls_left ) {
+		polls_left--;
+		return 0;
+	}
+	if( len > size ) {
+		len = size;
+	}
+	memcpy( rxc, &answer[answer_pos], len );
+	answer_pos += len;
+	return (int)len;
+}
+
+//*****************************************************************************
+static double now_ns( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main( int argc, char ** argv )
+{
+	static bc66_obj_t modem = {
+		.func_init_ptr = hal_init,
+		.func_delay = hal_delay,
+		.func_w_bytes_ptr = hal_write_bytes,
+		.func_r_bytes_ptr = hal_read_bytes,
+		.control_lines = { hal_pin, hal_pin, hal_pin, NULL },
+	};
+	unsigned long commands = (argc > 1) ? strtoul( argv[1], NULL, 0 ) : 200000;
+	unsigned long failed = 0;
+	double start;
+
+	if( argc > 2 ) {
+		empty_polls = (unsigned)strtoul( argv[2], NULL, 0 );
+	}
+	if( bc66_init( &modem ) != bc66_ret_success ) {
+		fprintf( stderr, "bc66_init failed\n" );
+		return 1;
+	}
+
+	start = now_ns();
+	for( unsigned long i = 0; i < commands; i++ ) {
+		if( bc66_send_at_command( BC66_CMD_READ, bc66_cmd_list_CPIN, "+CPIN:", NULL ) != bc66_ret_success ) {
+			failed++;
+		}
+	}
+	printf( "RX buffer %d bytes, %u empty polls: %.0f ns per command (%lu commands, %lu failed)\n",
+			BC66_RX_BUFFER_SIZE, empty_polls, (now_ns() - start) / (double)commands, commands, failed );
+	return failed ? 1 : 0;
+}
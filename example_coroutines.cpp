@@ -0,0 +1,206 @@
+/**
+ *
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @copyright   Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @file    example_coroutines.cpp
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @brief
+ * One thread driving many modules with C++20 coroutines (see src/bc66_coro.hpp).
+ *
+ * Modules are simulated: each one answers AT+QMTPUB after a fixed network latency.
+ * The scheduler is a plain loop calling process() on every module, as a gateway
+ * would do when epoll/select reports their UARTs readable. Publishes per second
+ * are reported for 1, 10, 100 and 1000 modules.
+ *
+ * gcc -O2 -c src/bc66_drv.c && g++ -std=c++20 -O2 example_coroutines.cpp bc66_drv.o -o example_coroutines
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @date    10/17/2026
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @author    Eng. Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @version    1.0.0
+ *
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "src/bc66_coro.hpp"
+
+static const uint32_t SIM_LATENCY_MS = 5;		///< simulated network round trip
+static const uint32_t RUN_TIME_MS = 2000;		///< benchmark time per fleet size
+
+//*****************************************************************************
+// Simulated module (HAL)
+
+struct SimModem {
+	bc66_obj_t obj;
+	char rsp[64];
+	size_t rsp_len;
+	size_t rsp_pos;
+	uint32_t ready_at;
+	unsigned long published;
+};
+
+static uint32_t get_tick( void )
+{
+	using namespace std::chrono;
+	static const steady_clock::time_point t0 = steady_clock::now();
+	return (uint32_t)duration_cast<milliseconds>( steady_clock::now() - t0 ).count();
+}
+
+static SimModem * sim( void )
+{
+	return static_cast<SimModem *>( bc66_selected()->user_ctx );
+}
+
+static void sim_init( void ) {}
+static void sim_delay( uint32_t t ) { (void)t; }
+static void sim_pin( size_t pin_value ) { (void)pin_value; }
+
+static int sim_write_bytes( uint8_t * b, uint16_t len )
+{
+	SimModem * m = sim();
+	unsigned int msg_id = 0;
+
+	// answer publishes after the network latency, anything else at once
+	if( sscanf( (const char *)b, "AT+QMTPUB=0,%u,", &msg_id ) == 1 ) {
+		m->rsp_len = snprintf( m->rsp, sizeof(m->rsp), "\r\nOK\r\n\r\n+QMTPUB: 0,%u,0\r\n", msg_id );
+		m->ready_at = get_tick() + SIM_LATENCY_MS;
+	} else {
+		m->rsp_len = snprintf( m->rsp, sizeof(m->rsp), "\r\nOK\r\n" );
+		m->ready_at = get_tick();
+	}
+	m->rsp_pos = 0;
+	return len;
+}
+
+static int sim_read_bytes( uint8_t * b, uint16_t size )
+{
+	SimModem * m = sim();
+	size_t n = m->rsp_len - m->rsp_pos;
+
+	if( (n == 0) || ((int32_t)(get_tick() - m->ready_at) < 0) ) {
+		return 0;
+	}
+	if( n > size ) {
+		n = size;
+	}
+	memcpy( b, m->rsp + m->rsp_pos, n );
+	m->rsp_pos += n;
+	return (int)n;
+}
+
+//*****************************************************************************
+// Application
+
+static bool running;
+
+/// Publish until the benchmark ends.
+static bc66::Task<> publisher( bc66::AsyncModem modem, SimModem & m )
+{
+	static const char payload[] = "{\"temp\":21.5}";
+	while( running ) {
+		auto ret = co_await modem.publish( "sensors/temp", payload, 1 );
+		if( !ret ) {
+			printf( "publish error %d\n", (int)ret.error() );
+			co_return;
+		}
+		m.published ++;
+	}
+}
+
+static void run( size_t modems )
+{
+	std::vector<std::unique_ptr<SimModem>> fleet;
+	std::vector<bc66::Task<>> tasks;
+	unsigned long published = 0;
+
+	for( size_t i = 0; i < modems; i++ ) {
+		fleet.emplace_back( new SimModem() );
+		SimModem & m = *fleet.back();
+		m.obj.func_init_ptr = &sim_init;
+		m.obj.func_delay = &sim_delay;
+		m.obj.func_w_bytes_ptr = &sim_write_bytes;
+		m.obj.func_r_bytes_ptr = &sim_read_bytes;
+		m.obj.control_lines.MDM_PSM_EINT_N = &sim_pin;
+		m.obj.control_lines.MDM_PWRKEY_N = &sim_pin;
+		m.obj.control_lines.MDM_RESET_N = &sim_pin;
+		m.obj.func_get_tick = &get_tick;
+		m.obj.user_ctx = &m;
+		bc66_init( &m.obj );
+	}
+
+	running = true;
+	for( auto & m : fleet ) {
+		tasks.push_back( publisher( bc66::AsyncModem( m->obj ), *m ) );
+		tasks.back().start();
+	}
+
+	// scheduler: a single thread polls every module
+	uint32_t start = get_tick();
+	bool pending = true;
+	while( pending ) {
+		if( running && (get_tick() - start >= RUN_TIME_MS) ) {
+			running = false;
+		}
+		pending = false;
+		for( size_t i = 0; i < fleet.size(); i++ ) {
+			if( !tasks[i].done() ) {
+				bc66::AsyncModem( fleet[i]->obj ).process();
+				pending = true;
+			}
+		}
+	}
+	uint32_t elapsed = get_tick() - start;
+
+	for( auto & m : fleet ) {
+		published += m->published;
+		bc66_deinit( &m->obj );
+	}
+	printf( "%5zu modems: %8lu publishes in %u ms, %10.0f publishes/s\n",
+			modems, published, elapsed, published * 1000.0 / elapsed );
+}
+
+int main( int argc, char const *argv[] )
+{
+	(void)argc;
+	(void)argv;
+	printf( "BC66 coroutines demonstration, %u ms simulated latency\n", SIM_LATENCY_MS );
+	for( size_t modems : { 1, 10, 100, 1000 } ) {
+		run( modems );
+	}
+	return 0;
+}
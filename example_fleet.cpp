@@ -0,0 +1,471 @@
+/**
+ *
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @copyright   Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @file    example_fleet.cpp
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @brief
+ * Fleet capacity harness: thousands of simulated modules publishing on a
+ * work-stealing thread pool.
+ *
+ * - Modules are split in chunks. A chunk is a task that advances the state
+ *   machine of its modules (bc66_process() or a new asynchronous publish) and is
+ *   queued again, so a module is only run by one worker at a time.
+ * - Each worker pops its own deque and, when empty, steals from workers of its
+ *   NUMA node first and then from the other nodes.
+ * - Workers are pinned to the allowed CPUs, filling one NUMA node before the
+ *   next one (/sys/devices/system/node). Each worker initializes its own chunks,
+ *   so their memory is placed on its node (first touch).
+ * - Publish latency is measured from the start of the command to its done
+ *   callback. Aggregate publishes/s and p50/p99/p99.9 latency are reported for
+ *   1, 2, 4 ... workers up to the CPU count.
+ *
+ * The driver selection must be per thread:
+ *   gcc -O2 -DBC66_THREAD_LOCAL=_Thread_local -c src/bc66_drv.c
+ *   g++ -std=c++20 -O2 -DBC66_THREAD_LOCAL=thread_local example_fleet.cpp bc66_drv.o -o example_fleet -pthread
+ *   ./example_fleet [modules] [latency ms] [seconds]
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @date    10/17/2026
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @author    Eng. Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @version    1.0.0
+ *
+ */
+
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "src/bc66_drv.h"
+
+using Clock = std::chrono::steady_clock;
+
+static const size_t CHUNK_SIZE = 64;				///< modules per task
+static const uint32_t HIST_BUCKET_US = 10;			///< latency histogram resolution
+static const size_t HIST_BUCKETS = 100000;			///< up to 1 s
+
+static uint32_t sim_latency_ms = 2;
+
+//*****************************************************************************
+// Simulated module (HAL)
+
+struct Module {
+	bc66_obj_t obj;
+	char rsp[48];
+	size_t rsp_len;
+	size_t rsp_pos;
+	Clock::time_point ready_at;
+	Clock::time_point sent_at;
+};
+
+static uint32_t get_tick( void )
+{
+	using namespace std::chrono;
+	static const Clock::time_point t0 = Clock::now();
+	return (uint32_t)duration_cast<milliseconds>( Clock::now() - t0 ).count();
+}
+
+static Module * sim( void )
+{
+	return static_cast<Module *>( bc66_selected()->user_ctx );
+}
+
+static void sim_init( void ) {}
+static void sim_delay( uint32_t t ) { (void)t; }
+static void sim_pin( size_t pin_value ) { (void)pin_value; }
+
+static int sim_write_bytes( uint8_t * b, uint16_t len )
+{
+	Module * m = sim();
+	unsigned int msg_id = 0;
+
+	if( sscanf( (const char *)b, "AT+QMTPUB=0,%u,", &msg_id ) == 1 ) {
+		m->rsp_len = snprintf( m->rsp, sizeof(m->rsp), "\r\nOK\r\n\r\n+QMTPUB: 0,%u,0\r\n", msg_id );
+		m->ready_at = Clock::now() + std::chrono::milliseconds( sim_latency_ms );
+	} else {
+		m->rsp_len = snprintf( m->rsp, sizeof(m->rsp), "\r\nOK\r\n" );
+		m->ready_at = Clock::now();
+	}
+	m->rsp_pos = 0;
+	return len;
+}
+
+static int sim_read_bytes( uint8_t * b, uint16_t size )
+{
+	Module * m = sim();
+	size_t n = m->rsp_len - m->rsp_pos;
+
+	if( (n == 0) || (Clock::now() < m->ready_at) ) {
+		return 0;
+	}
+	if( n > size ) {
+		n = size;
+	}
+	memcpy( b, m->rsp + m->rsp_pos, n );
+	m->rsp_pos += n;
+	return (int)n;
+}
+
+//*****************************************************************************
+// CPU topology
+
+struct Cpu {
+	int id;
+	int node;
+};
+
+/// Parse a sysfs cpu list, i.e. "0-3,8-11".
+static std::vector<int> parse_cpulist( const std::string & list )
+{
+	std::vector<int> cpus;
+	size_t pos = 0;
+	while( pos < list.size() ) {
+		int first = 0, last = 0, n = 0;
+		if( sscanf( list.c_str() + pos, "%d%n", &first, &n ) != 1 ) {
+			break;
+		}
+		pos += n;
+		last = first;
+		if( pos < list.size() && list[pos] == '-' ) {
+			pos ++;
+			if( sscanf( list.c_str() + pos, "%d%n", &last, &n ) != 1 ) {
+				break;
+			}
+			pos += n;
+		}
+		for( int c = first; c <= last; c++ ) {
+			cpus.push_back( c );
+		}
+		if( pos < list.size() && list[pos] == ',' ) {
+			pos ++;
+		} else {
+			break;
+		}
+	}
+	return cpus;
+}
+
+/// Allowed CPUs ordered by NUMA node.
+static std::vector<Cpu> topology( int & nodes )
+{
+	cpu_set_t allowed;
+	std::vector<Cpu> cpus;
+
+	CPU_ZERO( &allowed );
+	sched_getaffinity( 0, sizeof(allowed), &allowed );
+
+	nodes = 0;
+	for( int node = 0; node < 1024; node++ ) {
+		std::ifstream f( "/sys/devices/system/node/node" + std::to_string( node ) + "/cpulist" );
+		std::string list;
+		if( !f || !std::getline( f, list ) ) {
+			if( node > 0 ) {
+				break;
+			}
+			continue;
+		}
+		nodes ++;
+		for( int c : parse_cpulist( list ) ) {
+			if( CPU_ISSET( c, &allowed ) ) {
+				cpus.push_back( { c, node } );
+			}
+		}
+	}
+	// no NUMA information: one node 
+	if( cpus.empty() ) {
+		nodes = 1;
+		for( int c = 0; c < CPU_SETSIZE; c++ ) {
+			if( CPU_ISSET( c, &allowed ) ) {
+				cpus.push_back( { c, 0 } );
+			}
+		}
+	}
+	return cpus;
+}
+
+//*****************************************************************************
+// Work-stealing pool
+
+struct Chunk {
+	std::vector<Module> modules;
+};
+
+struct Worker {
+	std::mutex lock;
+	std::deque<Chunk *> tasks;
+	Cpu cpu;
+	std::vector<uint32_t> hist;
+	uint64_t published = 0;
+	uint64_t steals = 0;
+
+	/// Run again after the other tasks of the worker (round robin).
+	void push( Chunk * c ) {
+		std::lock_guard<std::mutex> g( lock );
+		tasks.push_back( c );
+	}
+	Chunk * pop() {
+		std::lock_guard<std::mutex> g( lock );
+		if( tasks.empty() ) {
+			return nullptr;
+		}
+		Chunk * c = tasks.front();
+		tasks.pop_front();
+		return c;
+	}
+	/// Take the task this worker would run last.
+	Chunk * steal() {
+		std::lock_guard<std::mutex> g( lock );
+		if( tasks.empty() ) {
+			return nullptr;
+		}
+		Chunk * c = tasks.back();
+		tasks.pop_back();
+		return c;
+	}
+};
+
+static thread_local Worker * current;
+static std::atomic<bool> measuring;
+
+/// Publish end: record latency and publish again.
+static void publish_done( bc66_ret_t ret_code, void * arg );
+
+static void publish_start( Module & m )
+{
+	static const char topic[] = "fleet/telemetry";
+	static const char payload[] = "{\"temp\":21.5,\"hum\":40}";
+	m.sent_at = Clock::now();
+	bc66_publish_msg_mqtt_start( publish_done, &m, topic, sizeof(topic) - 1, payload, sizeof(payload) - 1, 1 );
+}
+
+static void publish_done( bc66_ret_t ret_code, void * arg )
+{
+	Module & m = *static_cast<Module *>( arg );
+	if( ret_code == bc66_ret_success && measuring.load( std::memory_order_relaxed ) ) {
+		auto us = std::chrono::duration_cast<std::chrono::microseconds>( Clock::now() - m.sent_at ).count();
+		size_t bucket = std::min<size_t>( us / HIST_BUCKET_US, HIST_BUCKETS - 1 );
+		current->hist[bucket] ++;
+		current->published ++;
+	}
+	publish_start( m );
+}
+
+/// Advance the modules of a chunk.
+static void run_chunk( Chunk & c )
+{
+	for( Module & m : c.modules ) {
+		bc66_select( &m.obj );
+		if( bc66_cmd_busy() ) {
+			bc66_process();
+		} else {
+			publish_start( m );
+		}
+	}
+}
+
+static Chunk * find_task( std::vector<std::unique_ptr<Worker>> & workers, Worker & self, std::minstd_rand & rnd )
+{
+	Chunk * c = self.pop();
+	if( c ) {
+		return c;
+	}
+	// steal: same node first, then any node, starting at a random victim 
+	size_t n = workers.size();
+	for( int pass = 0; pass < 2; pass++ ) {
+		size_t first = rnd() % n;
+		for( size_t i = 0; i < n; i++ ) {
+			Worker & victim = *workers[(first + i) % n];
+			if( &victim == &self || (pass == 0 && victim.cpu.node != self.cpu.node) ) {
+				continue;
+			}
+			if( (c = victim.steal()) ) {
+				self.steals ++;
+				return c;
+			}
+		}
+	}
+	return nullptr;
+}
+
+//*****************************************************************************
+// Benchmark
+
+struct Result {
+	double publishes_s;
+	double p50_ms, p99_ms, p999_ms;
+	uint64_t steals;
+};
+
+static double percentile( const std::vector<uint64_t> & hist, uint64_t total, double p )
+{
+	uint64_t target = (uint64_t)( total * p ), acc = 0;
+	for( size_t i = 0; i < hist.size(); i++ ) {
+		acc += hist[i];
+		if( acc > target ) {
+			return ( i + 0.5 ) * HIST_BUCKET_US / 1000.0;
+		}
+	}
+	return 0;
+}
+
+static Result run( size_t modules, const std::vector<Cpu> & cpus, size_t threads, double seconds )
+{
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::unique_ptr<Chunk>> chunks( ( modules + CHUNK_SIZE - 1 ) / CHUNK_SIZE );
+	std::atomic<bool> stop{ false };
+	std::barrier start( threads + 1 );
+	std::vector<std::thread> pool;
+
+	for( size_t w = 0; w < threads; w++ ) {
+		workers.emplace_back( new Worker() );
+		workers.back()->cpu = cpus[w % cpus.size()];
+		workers.back()->hist.assign( HIST_BUCKETS, 0 );
+	}
+
+	for( size_t w = 0; w < threads; w++ ) {
+		pool.emplace_back( [&, w]() {
+			Worker & self = *workers[w];
+			std::minstd_rand rnd( (unsigned)w + 1 );
+			cpu_set_t set;
+
+			CPU_ZERO( &set );
+			CPU_SET( self.cpu.id, &set );
+			pthread_setaffinity_np( pthread_self(), sizeof(set), &set );
+			current = &self;
+
+			// first touch: chunks of this worker are allocated and initialized here 
+			for( size_t c = w; c < chunks.size(); c += threads ) {
+				size_t count = std::min( CHUNK_SIZE, modules - c * CHUNK_SIZE );
+				chunks[c].reset( new Chunk() );
+				chunks[c]->modules.resize( count );
+				for( Module & m : chunks[c]->modules ) {
+					m.obj.func_init_ptr = &sim_init;
+					m.obj.func_delay = &sim_delay;
+					m.obj.func_w_bytes_ptr = &sim_write_bytes;
+					m.obj.func_r_bytes_ptr = &sim_read_bytes;
+					m.obj.control_lines.MDM_PSM_EINT_N = &sim_pin;
+					m.obj.control_lines.MDM_PWRKEY_N = &sim_pin;
+					m.obj.control_lines.MDM_RESET_N = &sim_pin;
+					m.obj.func_get_tick = &get_tick;
+					m.obj.user_ctx = &m;
+					bc66_init( &m.obj );
+				}
+				self.push( chunks[c].get() );
+			}
+			start.arrive_and_wait();
+
+			while( !stop.load( std::memory_order_relaxed ) ) {
+				Chunk * c = find_task( workers, self, rnd );
+				if( c == nullptr ) {
+					std::this_thread::yield();
+					continue;
+				}
+				run_chunk( *c );
+				self.push( c );
+			}
+		} );
+	}
+
+	start.arrive_and_wait();
+	// warm up, then measure 
+	std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+	measuring = true;
+	auto t0 = Clock::now();
+	std::this_thread::sleep_for( std::chrono::duration<double>( seconds ) );
+	measuring = false;
+	double elapsed = std::chrono::duration<double>( Clock::now() - t0 ).count();
+	stop = true;
+	for( auto & t : pool ) {
+		t.join();
+	}
+
+	std::vector<uint64_t> hist( HIST_BUCKETS, 0 );
+	uint64_t total = 0;
+	Result r{};
+	for( auto & w : workers ) {
+		for( size_t i = 0; i < HIST_BUCKETS; i++ ) {
+			hist[i] += w->hist[i];
+		}
+		total += w->published;
+		r.steals += w->steals;
+	}
+	for( auto & c : chunks ) {
+		for( Module & m : c->modules ) {
+			bc66_deinit( &m.obj );
+		}
+	}
+	r.publishes_s = total / elapsed;
+	r.p50_ms = percentile( hist, total, 0.50 );
+	r.p99_ms = percentile( hist, total, 0.99 );
+	r.p999_ms = percentile( hist, total, 0.999 );
+	return r;
+}
+
+int main( int argc, char const *argv[] )
+{
+	size_t modules = ( argc > 1 ) ? strtoul( argv[1], NULL, 0 ) : 10000;
+	double seconds = ( argc > 3 ) ? atof( argv[3] ) : 2.0;
+	int nodes = 0;
+
+	if( argc > 2 ) {
+		sim_latency_ms = strtoul( argv[2], NULL, 0 );
+	}
+	std::vector<Cpu> cpus = topology( nodes );
+
+	printf( "BC66 fleet: %zu modules, %u ms simulated latency, %zu CPUs on %d NUMA nodes\n",
+			modules, sim_latency_ms, cpus.size(), nodes );
+	printf( "threads  publishes/s    p50 ms    p99 ms  p99.9 ms    steals\n" );
+	for( size_t threads = 1; ; threads *= 2 ) {
+		threads = std::min( threads, cpus.size() );
+		Result r = run( modules, cpus, threads, seconds );
+		printf( "%7zu %12.0f %9.3f %9.3f %9.3f %9llu\n", threads, r.publishes_s, r.p50_ms, r.p99_ms, r.p999_ms, (unsigned long long)r.steals );
+		if( threads == cpus.size() ) {
+			break;
+		}
+	}
+	return 0;
+}
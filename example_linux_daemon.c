@@ -0,0 +1,1049 @@
+/**
+ *
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @copyright   Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @file    example_linux_daemon.c
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @brief
+ * Reference Linux daemon serving several BC66 modules from one thread.
+ *
+ * - Each module is a tty (i.e. USB-serial /dev/ttyUSB0) opened non-blocking and
+ *   bound to its own bc66_obj_t. The tty is found from the HAL functions through
+ *   bc66_selected()->user_ctx.
+ * - One epoll loop waits on every tty and on the API socket. A readable tty runs
+ *   bc66_process() for its module only, which reads the new chars (URCs too while
+ *   idle) and ends the running command. Modules are swept on a timer only while
+ *   a command, a retry or an update needs its time checked.
+ * - Writes never block the loop: what the tty does not take is queued and sent
+ *   when the tty is writable again.
+ * - Modules are brought up (AT, ATE0, AT+QMTOPEN, AT+QMTCONN) and publish with
+ *   the asynchronous commands, so no module blocks the others.
+ * - Local API, UNIX stream socket, one request per line:
+ *       PUB <module> <qos> <topic> <payload>\n	->	OK <module>\n | ERR <module> <bc66_ret_t>\n
+ *       FOTA <module> <image size> <url>\n		->	OK <module>\n | ERR <module> <bc66_ret_t>\n
+ *       LIST\n									->	<module> <tty> <state> [fota <phase> <progress>%]\n ... END\n
+ * - Firmware updates (DFOTA) are driven with bc66_fota_poll(). With -p <dir> the
+ *   update state is saved there and resumed when the daemon starts again.
+ * - With -s <n> the daemon creates n pty-backed simulated modules and serves them
+ *   in the same loop, to test it without hardware. A simulated module downloads
+ *   the DFOTA image with a plain HTTP GET (IPv4 address URLs only).
+ *
+ *   gcc -O2 -o bc66d example_linux_daemon.c src/bc66_drv.c
+ *   ./bc66d -a /tmp/bc66.sock -b broker.local:1883 /dev/ttyUSB0 /dev/ttyUSB1
+ *   ./bc66d -a /tmp/bc66.sock -s 4
+ *   echo 'PUB 0 1 sensors/temp 21.5' | socat - UNIX-CONNECT:/tmp/bc66.sock
+ *
+ *   head -c 300000 /dev/urandom > /tmp/fw/image.bin && python3 -m http.server -d /tmp/fw 8000 &
+ *   ./bc66d -a /tmp/bc66.sock -s 1 -p /tmp
+ *   echo 'FOTA 0 300000 http://127.0.0.1:8000/image.bin' | socat - UNIX-CONNECT:/tmp/bc66.sock
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @date    10/17/2026
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @author    Eng. Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @version    1.0.0
+ *
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "src/bc66_drv.h"
+
+#define MAX_MODULES			64
+#define MAX_CLIENTS			16
+#define PUB_QUEUE_SIZE		8							///< pending publishes per module
+#define CLIENT_LINE_SIZE	( BC66_MQTT_TOPIC_MAX_LEN + BC66_MQTT_PUBLISH_MAX_LEN + 32 )
+#define RETRY_TIME_MS		5000						///< bring up retry time after a failure
+#define POLL_TIME_MS		10							///< timeouts check period while a command runs
+
+/// epoll data tags (fd kind in high bits, index in low bits)
+#define TAG_LISTEN			0x10000u
+#define TAG_CLIENT			0x20000u
+#define TAG_MODULE			0x30000u
+#define TAG_SIM				0x40000u
+#define TAG_HTTP			0x50000u
+#define TAG_KIND(t)			( (t) & 0xF0000u )
+#define TAG_INDEX(t)		( (t) & 0x0FFFFu )
+
+//*****************************************************************************
+// Types
+
+/// Module bring up and publish states.
+typedef enum {
+	ST_SYNC,				///< AT
+	ST_ECHO,				///< ATE0
+	ST_OPEN,				///< AT+QMTOPEN
+	ST_CONN,				///< AT+QMTCONN
+	ST_READY,				///< connected, publishing queued messages
+	ST_FAILED				///< waiting to retry bring up
+} module_state_t ;
+
+static const char * const state_names[] = { "sync", "echo", "open", "conn", "ready", "failed" };
+static const char * const fota_names[] = { "idle", "download", "update", "verify", "done", "failed" };
+
+/// Publish request from a client.
+typedef struct {
+	int client;								///< client slot
+	unsigned int client_gen;				///< client slot generation, reply is dropped if it changed
+	int qos;
+	char topic[BC66_MQTT_TOPIC_MAX_LEN + 1];
+	char msg[BC66_MQTT_PUBLISH_MAX_LEN + 1];
+} pub_req_t ;
+
+/// Module served by the daemon.
+typedef struct {
+	bc66_obj_t obj;							///< driver object, user_ctx points here
+	int fd;									///< tty
+	int index;
+	char path[64];
+	module_state_t state;
+	uint32_t retry_at;						///< tick to retry bring up
+	pub_req_t queue[PUB_QUEUE_SIZE];		///< pending publishes, queue[head] is running when busy
+	unsigned int head;
+	unsigned int count;
+	bool publishing;
+	bool fota;								///< firmware update running
+	uint8_t out[BC66_TX_BUFFER_SIZE + BC66_MQTT_DATA_MODE_MAX_LEN];	///< bytes the tty did not take yet
+	size_t out_len;
+} module_t ;
+
+/// API socket client.
+typedef struct {
+	int fd;									///< -1 if slot is free
+	unsigned int gen;
+	char line[CLIENT_LINE_SIZE];
+	size_t len;
+} client_t ;
+
+/// pty simulated module (the module side of the tty).
+typedef struct {
+	int fd;									///< pty master
+	int index;
+	char line[BC66_TX_BUFFER_SIZE];
+	size_t len;
+	char revision[24];						///< firmware revision, changed by an update
+	int http;								///< DFOTA image download socket, -1 if none
+	char http_hdr[512];						///< HTTP response header
+	size_t http_hdr_len;
+	bool http_body;							///< header received
+	size_t http_size;						///< Content-Length, 0 if not given
+	size_t http_got;						///< body bytes received
+	int http_pct;							///< last DOWNLOADING percent reported
+} sim_t ;
+
+//*****************************************************************************
+// Data
+
+static module_t modules[MAX_MODULES];
+static int modules_count;
+static client_t clients[MAX_CLIENTS];
+static sim_t sims[MAX_MODULES];
+static int sims_count;
+static int epfd = -1;
+static volatile sig_atomic_t running = 1;
+static const char * broker_host = "127.0.0.1";
+static uint16_t broker_port = 1883;
+static const char * state_dir = NULL;
+
+//*****************************************************************************
+// HAL: the selected module gives the tty
+
+static uint32_t hal_get_tick( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint32_t)( ts.tv_sec * 1000u + ts.tv_nsec / 1000000u );
+}
+
+static void hal_delay( uint32_t t )
+{
+	usleep( t * 1000u );
+}
+
+static void hal_init( void ) {}
+static void hal_pin( size_t pin_value ) { (void)pin_value; }
+
+static void module_watch_out( module_t * m, bool out );
+
+static int hal_write_bytes( uint8_t * b, uint16_t len )
+{
+	module_t * m = bc66_selected()->user_ctx;
+	size_t sent = 0;
+	size_t take;
+
+	// queued bytes go first 
+	if( m->out_len == 0 ) {
+		ssize_t n;
+		while( ((n = write( m->fd, b, len )) < 0) && (errno == EINTR) ) {
+		}
+		if( n > 0 ) {
+			sent = n;
+		} else if( (n < 0) && (errno != EAGAIN) ) {
+			return 0;
+		}
+	}
+	if( sent < len ) {
+		// tty output full: queue the rest, it is sent when the tty is writable 
+		take = len - sent;
+		if( take > sizeof(m->out) - m->out_len ) {
+			take = sizeof(m->out) - m->out_len;
+		}
+		memcpy( m->out + m->out_len, b + sent, take );
+		m->out_len += take;
+		sent += take;
+		module_watch_out( m, true );
+	}
+	return (int)sent;
+}
+
+static int hal_read_bytes( uint8_t * b, uint16_t size )
+{
+	module_t * m = bc66_selected()->user_ctx;
+	ssize_t n = read( m->fd, b, size );
+	return ( n > 0 ) ? (int)n : 0;
+}
+
+//*****************************************************************************
+// Helpers
+
+static int tty_open( const char * path )
+{
+	struct termios tio;
+	int fd = open( path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC );
+
+	if( fd < 0 ) {
+		return -1;
+	}
+	if( tcgetattr( fd, &tio ) == 0 ) {
+		cfmakeraw( &tio );
+		cfsetispeed( &tio, B115200 );
+		cfsetospeed( &tio, B115200 );
+		tio.c_cflag |= CLOCAL | CREAD;
+		tcsetattr( fd, TCSANOW, &tio );
+	}
+	return fd;
+}
+
+static int epoll_add( int fd, uint32_t tag )
+{
+	struct epoll_event ev = { .events = EPOLLIN, .data.u32 = tag };
+	return epoll_ctl( epfd, EPOLL_CTL_ADD, fd, &ev );
+}
+
+/// Wait the module tty writable too while bytes are queued.
+static void module_watch_out( module_t * m, bool out )
+{
+	struct epoll_event ev = { .events = EPOLLIN | ( out ? EPOLLOUT : 0 ), .data.u32 = TAG_MODULE | m->index };
+	epoll_ctl( epfd, EPOLL_CTL_MOD, m->fd, &ev );
+}
+
+/// Send queued bytes, the tty is writable.
+static void module_flush( module_t * m )
+{
+	ssize_t n;
+
+	while( m->out_len ) {
+		if( (n = write( m->fd, m->out, m->out_len )) > 0 ) {
+			memmove( m->out, m->out + n, m->out_len - n );
+			m->out_len -= n;
+		} else if( (n < 0) && (errno == EINTR) ) {
+			continue;
+		} else if( (n < 0) && (errno == EAGAIN) ) {
+			return;
+		} else {
+			// tty gone: drop them, the running command times out 
+			m->out_len = 0;
+		}
+	}
+	module_watch_out( m, false );
+}
+
+static void client_reply( int slot, unsigned int gen, const char * fmt, ... )
+{
+	char buf[96];
+	va_list args;
+	int len;
+
+	if( (slot < 0) || (clients[slot].fd < 0) || (clients[slot].gen != gen) ) {
+		return;
+	}
+	va_start( args, fmt );
+	len = vsnprintf( buf, sizeof(buf), fmt, args );
+	va_end( args );
+	// short replies, drop them if the client does not read 
+	if( send( clients[slot].fd, buf, len, MSG_NOSIGNAL | MSG_DONTWAIT ) < 0 ) {
+		// client is gone, its hang up is handled by epoll 
+	}
+}
+
+//*****************************************************************************
+// Firmware update state files
+
+static void fota_path( const module_t * m, char * path, size_t size )
+{
+	snprintf( path, size, "%s/bc66d-fota-%d", state_dir, m->index );
+}
+
+/// DFOTA save hook: write a temporary file and rename it, so a crash keeps the last state.
+static void fota_save( const bc66_fota_state_t * state, void * arg )
+{
+	module_t * m = arg;
+	char path[256];
+	char tmp[264];
+	FILE * f;
+
+	fota_path( m, path, sizeof(path) );
+	snprintf( tmp, sizeof(tmp), "%s.tmp", path );
+	if( (f = fopen( tmp, "wb" )) == NULL ) {
+		return;
+	}
+	if( fwrite( state, sizeof(*state), 1, f ) == 1 && fclose( f ) == 0 ) {
+		rename( tmp, path );
+	} else {
+		unlink( tmp );
+	}
+}
+
+/// Resume an update left running by a previous daemon.
+static void fota_load( module_t * m )
+{
+	bc66_fota_state_t state;
+	char path[256];
+	FILE * f;
+
+	fota_path( m, path, sizeof(path) );
+	if( (f = fopen( path, "rb" )) == NULL ) {
+		return;
+	}
+	if( fread( &state, sizeof(state), 1, f ) == 1 && state.phase > bc66_fota_idle && state.phase < bc66_fota_done && 
+		bc66_fota_resume( &state, fota_save, m ) == bc66_ret_success ) {
+		m->fota = true;
+		printf( "bc66d: module %d resumes firmware update (%s, attempt %u)\n", m->index, fota_names[state.phase], state.attempts );
+	}
+	fclose( f );
+}
+
+/// Update ended: report it, the module restarted so bring it up again.
+static void fota_end( module_t * m, bc66_ret_t ret_code )
+{
+	bc66_fota_state_t st;
+	uint32_t throughput = 0;
+
+	bc66_fota_get_state( &st );
+	bc66_fota_get_throughput( &throughput );
+	printf( "bc66d: module %d firmware update %s (err %d): download %u ms (%u attempts, %u B/s), update %u ms, verify %u ms\n", 
+		m->index, ret_code == bc66_ret_success ? "done" : "failed", st.err, 
+		(unsigned)st.phase_time[bc66_fota_download], st.attempts, (unsigned)throughput, 
+		(unsigned)st.phase_time[bc66_fota_update], (unsigned)st.phase_time[bc66_fota_verify] );
+	m->fota = false;
+	m->state = ST_SYNC;
+}
+
+//*****************************************************************************
+// Modules
+
+static void module_step( module_t * m );
+
+/// Asynchronous command end, see bc66_cmd_start(...).
+static void module_done( bc66_ret_t ret_code, void * arg )
+{
+	module_t * m = arg;
+	const char * rsp = bc66_get_last_response();
+
+	if( m->publishing ) {
+		pub_req_t * req = &m->queue[m->head];
+		if( ret_code == bc66_ret_success ) {
+			client_reply( req->client, req->client_gen, "OK %d\n", m->index );
+		} else {
+			client_reply( req->client, req->client_gen, "ERR %d %d\n", m->index, (int)ret_code );
+		}
+		m->publishing = false;
+		m->head = ( m->head + 1 ) % PUB_QUEUE_SIZE;
+		m->count --;
+		// a timeout may be a lost connection: bring up again 
+		if( ret_code == bc66_ret_timeout ) {
+			m->state = ST_SYNC;
+		}
+	} else if( ret_code != bc66_ret_success ) {
+		m->state = ST_FAILED;
+		m->retry_at = hal_get_tick() + RETRY_TIME_MS;
+	} else if( m->state == ST_OPEN ) {
+		// +QMTOPEN: 0,<result> 
+		m->state = strstr( rsp, ",0" ) ? ST_CONN : ST_FAILED;
+	} else if( m->state == ST_CONN ) {
+		// +QMTCONN: 0,<result>,<ret_code> 
+		m->state = strstr( rsp, ",0,0" ) ? ST_READY : ST_FAILED;
+		if( m->state == ST_READY ) {
+			printf( "bc66d: module %d (%s) connected\n", m->index, m->path );
+		}
+	} else {
+		m->state ++;
+	}
+	if( m->state == ST_FAILED ) {
+		m->retry_at = hal_get_tick() + RETRY_TIME_MS;
+		fprintf( stderr, "bc66d: module %d (%s) bring up failed: %s\n", m->index, m->path, rsp );
+	}
+	// next command (module is selected by bc66_process) 
+	module_step( m );
+}
+
+/// Start the next command of the module, if it is idle.
+static void module_step( module_t * m )
+{
+	bc66_ret_t ret_code = bc66_ret_success;
+	char client_id[24];
+
+	if( m->fota || bc66_select( &m->obj ) != bc66_ret_success || bc66_cmd_busy() ) {
+		return;
+	}
+	switch( m->state ) {
+		case ST_SYNC:
+			ret_code = bc66_cmd_start( module_done, m, BC66_CMD_EXE, bc66_cmd_list_AT, NULL, NULL );
+			break;
+		case ST_ECHO:
+			ret_code = bc66_cmd_start( module_done, m, BC66_CMD_EXE, bc66_cmd_list_ATE, NULL, "0" );
+			break;
+		case ST_OPEN:
+			ret_code = bc66_cmd_start( module_done, m, BC66_CMD_WRITE, bc66_cmd_list_QMTOPEN, "+QMTOPEN: 0,", "0,\"%s\",%u", broker_host, broker_port );
+			break;
+		case ST_CONN:
+			snprintf( client_id, sizeof(client_id), "bc66d-%d", m->index );
+			ret_code = bc66_cmd_start( module_done, m, BC66_CMD_WRITE, bc66_cmd_list_QMTCONN, "+QMTCONN: 0,", "0,\"%s\"", client_id );
+			break;
+		case ST_READY:
+			if( m->count ) {
+				pub_req_t * req = &m->queue[m->head];
+				m->publishing = true;
+				ret_code = bc66_publish_msg_mqtt_start( module_done, m, req->topic, strlen(req->topic), req->msg, strlen(req->msg), req->qos );
+				if( ret_code == bc66_ret_busy ) {
+					// resync after a timeout: sent by module_poll() once idle 
+					m->publishing = false;
+					return;
+				}
+				if( ret_code != bc66_ret_success ) {
+					// not sent: answer now and keep going with the next one 
+					m->publishing = false;
+					client_reply( req->client, req->client_gen, "ERR %d %d\n", m->index, (int)ret_code );
+					m->head = ( m->head + 1 ) % PUB_QUEUE_SIZE;
+					m->count --;
+					module_step( m );
+					return;
+				}
+			}
+			break;
+		case ST_FAILED:
+			if( (int32_t)( hal_get_tick() - m->retry_at ) >= 0 ) {
+				m->state = ST_SYNC;
+				module_step( m );
+			}
+			return;
+	}
+	if( (ret_code != bc66_ret_success) && (ret_code != bc66_ret_busy) ) {
+		m->state = ST_FAILED;
+		m->retry_at = hal_get_tick() + RETRY_TIME_MS;
+	}
+}
+
+/// Read the module tty (a chunk each call, the level triggered tty fires again) and check timeouts.
+static void module_poll( module_t * m )
+{
+	bc66_select( &m->obj );
+	if( m->fota ) {
+		bc66_ret_t ret_code = bc66_fota_poll();
+		if( ret_code != bc66_ret_busy ) {
+			fota_end( m, ret_code );
+			module_step( m );
+		}
+	} else {
+		// drains URCs while idle, a command end calls module_done() 
+		bc66_process();
+		// a command refused during a resync is started once the module is idle 
+		module_step( m );
+	}
+}
+
+static int module_add( const char * path )
+{
+	module_t * m;
+
+	if( modules_count >= MAX_MODULES ) {
+		return -1;
+	}
+	m = &modules[modules_count];
+	memset( m, 0, sizeof(*m) );
+	m->fd = tty_open( path );
+	if( m->fd < 0 ) {
+		fprintf( stderr, "bc66d: %s: %s\n", path, strerror(errno) );
+		return -1;
+	}
+	m->index = modules_count;
+	snprintf( m->path, sizeof(m->path), "%s", path );
+	m->obj.func_init_ptr = &hal_init;
+	m->obj.func_delay = &hal_delay;
+	m->obj.func_w_bytes_ptr = &hal_write_bytes;
+	m->obj.func_r_bytes_ptr = &hal_read_bytes;
+	m->obj.control_lines.MDM_PSM_EINT_N = &hal_pin;
+	m->obj.control_lines.MDM_PWRKEY_N = &hal_pin;
+	m->obj.control_lines.MDM_RESET_N = &hal_pin;
+	m->obj.func_get_tick = &hal_get_tick;
+	m->obj.user_ctx = m;
+	m->state = ST_SYNC;
+
+	if( bc66_init( &m->obj ) != bc66_ret_success || epoll_add( m->fd, TAG_MODULE | m->index ) < 0 ) {
+		close( m->fd );
+		return -1;
+	}
+	modules_count ++;
+	if( state_dir ) {
+		fota_load( m );
+	}
+	return m->index;
+}
+
+//*****************************************************************************
+// API clients
+
+static void client_request( int slot, char * line )
+{
+	client_t * c = &clients[slot];
+	char * save = NULL;
+	char * cmd = strtok_r( line, " ", &save );
+
+	if( cmd == NULL ) {
+		return;
+	}
+	if( strcmp( cmd, "LIST" ) == 0 ) {
+		for( int i = 0; i < modules_count; i++ ) {
+			bc66_fota_state_t st;
+			bc66_select( &modules[i].obj );
+			if( bc66_fota_get_state( &st ) == bc66_ret_success && st.phase != bc66_fota_idle ) {
+				client_reply( slot, c->gen, "%d %s %s fota %s %u%%\n", i, modules[i].path, state_names[modules[i].state], fota_names[st.phase], st.progress );
+			} else {
+				client_reply( slot, c->gen, "%d %s %s\n", i, modules[i].path, state_names[modules[i].state] );
+			}
+		}
+		client_reply( slot, c->gen, "END\n" );
+	} else if( strcmp( cmd, "PUB" ) == 0 ) {
+		char * idx = strtok_r( NULL, " ", &save );
+		char * qos = strtok_r( NULL, " ", &save );
+		char * topic = strtok_r( NULL, " ", &save );
+		char * msg = save;		// rest of the line
+		int i = idx ? atoi( idx ) : -1;
+		module_t * m;
+		pub_req_t * req;
+
+		if( !idx || !qos || !topic || !msg || (i < 0) || (i >= modules_count) ) {
+			client_reply( slot, c->gen, "ERR %d %d\n", i, (int)bc66_ret_out_of_range );
+			return;
+		}
+		m = &modules[i];
+		if( (m->count == PUB_QUEUE_SIZE) || (strlen(topic) > BC66_MQTT_TOPIC_MAX_LEN) || (strlen(msg) > BC66_MQTT_PUBLISH_MAX_LEN) ) {
+			client_reply( slot, c->gen, "ERR %d %d\n", i, (int)( (m->count == PUB_QUEUE_SIZE) ? bc66_ret_busy : bc66_ret_out_of_range ) );
+			return;
+		}
+		req = &m->queue[( m->head + m->count ) % PUB_QUEUE_SIZE];
+		req->client = slot;
+		req->client_gen = c->gen;
+		req->qos = atoi( qos );
+		strcpy( req->topic, topic );
+		strcpy( req->msg, msg );
+		m->count ++;
+		module_step( m );
+	} else if( strcmp( cmd, "FOTA" ) == 0 ) {
+		char * idx = strtok_r( NULL, " ", &save );
+		char * size = strtok_r( NULL, " ", &save );
+		char * url = strtok_r( NULL, " ", &save );
+		int i = idx ? atoi( idx ) : -1;
+		bc66_ret_t ret_code;
+
+		if( !idx || !size || !url || (i < 0) || (i >= modules_count) ) {
+			client_reply( slot, c->gen, "ERR %d %d\n", i, (int)bc66_ret_out_of_range );
+			return;
+		}
+		bc66_select( &modules[i].obj );
+		ret_code = bc66_fota_start( url, (uint32_t)strtoul( size, NULL, 10 ), state_dir ? fota_save : NULL, &modules[i] );
+		if( ret_code == bc66_ret_success ) {
+			modules[i].fota = true;
+			client_reply( slot, c->gen, "OK %d\n", i );
+		} else {
+			client_reply( slot, c->gen, "ERR %d %d\n", i, (int)ret_code );
+		}
+	} else {
+		client_reply( slot, c->gen, "ERR -1 %d\n", (int)bc66_ret_no_cmd_implemented );
+	}
+}
+
+static void client_close( int slot )
+{
+	epoll_ctl( epfd, EPOLL_CTL_DEL, clients[slot].fd, NULL );
+	close( clients[slot].fd );
+	clients[slot].fd = -1;
+	clients[slot].gen ++;
+}
+
+static void client_readable( int slot )
+{
+	client_t * c = &clients[slot];
+	ssize_t n = read( c->fd, c->line + c->len, sizeof(c->line) - 1 - c->len );
+	char * eol;
+
+	if( n <= 0 ) {
+		if( (n == 0) || (errno != EAGAIN) ) {
+			client_close( slot );
+		}
+		return;
+	}
+	c->len += n;
+	c->line[c->len] = '\0';
+	while( (eol = memchr( c->line, '\n', c->len )) ) {
+		size_t used = eol - c->line + 1;
+		*eol = '\0';
+		if( (eol > c->line) && (eol[-1] == '\r') ) {
+			eol[-1] = '\0';
+		}
+		client_request( slot, c->line );
+		memmove( c->line, c->line + used, c->len - used );
+		c->len -= used;
+		c->line[c->len] = '\0';
+	}
+	// line too long 
+	if( c->len == sizeof(c->line) - 1 ) {
+		client_close( slot );
+	}
+}
+
+static void client_accept( int lfd )
+{
+	int fd = accept4( lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC );
+
+	if( fd < 0 ) {
+		return;
+	}
+	for( int i = 0; i < MAX_CLIENTS; i++ ) {
+		if( clients[i].fd < 0 ) {
+			clients[i].fd = fd;
+			clients[i].len = 0;
+			if( epoll_add( fd, TAG_CLIENT | i ) == 0 ) {
+				return;
+			}
+			clients[i].fd = -1;
+			break;
+		}
+	}
+	close( fd );
+}
+
+static int api_listen( const char * path )
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int fd = socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+
+	if( fd < 0 || strlen( path ) >= sizeof(addr.sun_path) ) {
+		return -1;
+	}
+	strcpy( addr.sun_path, path );
+	unlink( path );
+	if( bind( fd, (struct sockaddr *)&addr, sizeof(addr) ) < 0 || listen( fd, MAX_CLIENTS ) < 0 ) {
+		close( fd );
+		return -1;
+	}
+	return fd;
+}
+
+//*****************************************************************************
+// pty simulated modules: answer the commands used by the daemon
+
+static void sim_write( sim_t * s, const char * rsp )
+{
+	if( write( s->fd, rsp, strlen( rsp ) ) < 0 ) {
+		// module side full, the driver will time out 
+	}
+}
+
+/// Start the DFOTA image download: GET http://<IPv4>[:port]/<path>.
+static bool sim_http_get( sim_t * s, const char * url )
+{
+	struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons( 80 ) };
+	char host[64];
+	char req[BC66_FOTA_URL_SIZE + 64];
+	const char * path;
+	char * port;
+	size_t len;
+	int fd;
+
+	if( strncmp( url, "http://", 7 ) ) {
+		return false;
+	}
+	url += 7;
+	path = strchr( url, '/' );
+	len = path ? (size_t)( path - url ) : strlen( url );
+	if( len >= sizeof(host) ) {
+		return false;
+	}
+	memcpy( host, url, len );
+	host[len] = '\0';
+	if( (port = strchr( host, ':' )) ) {
+		*port = '\0';
+		addr.sin_port = htons( (uint16_t)atoi( port + 1 ) );
+	}
+	if( inet_pton( AF_INET, host, &addr.sin_addr ) != 1 ) {
+		return false;
+	}
+	// local stand-in server: a blocking connect is short 
+	if( (fd = socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 )) < 0 ) {
+		return false;
+	}
+	snprintf( req, sizeof(req), "GET %s HTTP/1.0\r\nHost: %s\r\n\r\n", path ? path : "/", host );
+	if( connect( fd, (struct sockaddr *)&addr, sizeof(addr) ) < 0 || write( fd, req, strlen( req ) ) < 0 ||
+		fcntl( fd, F_SETFL, O_NONBLOCK ) < 0 || epoll_add( fd, TAG_HTTP | s->index ) < 0 ) {
+		close( fd );
+		return false;
+	}
+	s->http = fd;
+	s->http_hdr_len = 0;
+	s->http_body = false;
+	s->http_size = 0;
+	s->http_got = 0;
+	s->http_pct = 0;
+	return true;
+}
+
+/// Download ended: write the "new firmware" (the edition number goes up).
+static void sim_http_end( sim_t * s )
+{
+	char rsp[64];
+	bool ok = s->http_body && s->http_got && ( !s->http_size || (s->http_got == s->http_size) );
+	size_t len = strlen( s->revision );
+
+	epoll_ctl( epfd, EPOLL_CTL_DEL, s->http, NULL );
+	close( s->http );
+	s->http = -1;
+	snprintf( rsp, sizeof(rsp), "\r\n+QIND: \"FOTA\",\"HTTPEND\",%d\r\n", ok ? 0 : 601 );
+	sim_write( s, rsp );
+	if( !ok ) {
+		return;
+	}
+	sim_write( s, "\r\n+QIND: \"FOTA\",\"START\"\r\n" );
+	sim_write( s, "\r\n+QIND: \"FOTA\",\"UPDATING\",50%\r\n" );
+	sim_write( s, "\r\n+QIND: \"FOTA\",\"UPDATING\",100%\r\n" );
+	if( len && s->revision[len - 1] < '9' ) {
+		s->revision[len - 1] ++;
+	}
+	sim_write( s, "\r\n+QIND: \"FOTA\",\"END\",0\r\n" );
+	// restart with the new firmware 
+	sim_write( s, "\r\nRDY\r\n" );
+}
+
+static void sim_http_readable( sim_t * s )
+{
+	char buf[4096];
+	bool refused = false;
+	ssize_t n;
+
+	while( (n = read( s->http, buf, sizeof(buf) )) > 0 ) {
+		char * body = buf;
+		int pct;
+
+		if( !s->http_body ) {
+			// header may come in several reads 
+			size_t take = (size_t)n < sizeof(s->http_hdr) - 1 - s->http_hdr_len ? (size_t)n : sizeof(s->http_hdr) - 1 - s->http_hdr_len;
+			char * eoh;
+			char * cl;
+
+			memcpy( s->http_hdr + s->http_hdr_len, buf, take );
+			s->http_hdr_len += take;
+			s->http_hdr[s->http_hdr_len] = '\0';
+			if( (eoh = strstr( s->http_hdr, "\r\n\r\n" )) == NULL ) {
+				continue;
+			}
+			if( strncmp( s->http_hdr + 8, " 200", 4 ) ) {
+				refused = true;
+				break;
+			}
+			if( (cl = strcasestr( s->http_hdr, "Content-Length:" )) ) {
+				s->http_size = strtoul( cl + 15, NULL, 10 );
+			}
+			s->http_body = true;
+			// body starts after the header end, in this read 
+			body = buf + ( eoh + 4 - s->http_hdr ) - ( s->http_hdr_len - take );
+		}
+		s->http_got += buf + n - body;
+		pct = s->http_size ? (int)( s->http_got * 100 / s->http_size ) : 0;
+		if( pct / 10 > s->http_pct / 10 ) {
+			char rsp[64];
+			snprintf( rsp, sizeof(rsp), "\r\n+QIND: \"FOTA\",\"DOWNLOADING\",%d%%\r\n", pct );
+			sim_write( s, rsp );
+			s->http_pct = pct;
+		}
+	}
+	if( refused || (n == 0) || ((n < 0) && (errno != EAGAIN)) ) {
+		sim_http_end( s );
+	}
+}
+
+static void sim_answer( sim_t * s, const char * line )
+{
+	char rsp[96];
+	unsigned int msg_id;
+	const char * fmt = "\r\nOK\r\n";
+
+	if( strcmp( line, "ATI" ) == 0 ) {
+		snprintf( rsp, sizeof(rsp), "\r\nQuectel_Ltd\r\nQuectel_BC66\r\nRevision: %s\r\n\r\nOK\r\n", s->revision );
+		fmt = rsp;
+	} else if( strncmp( line, "AT+QFOTADL=\"", 12 ) == 0 ) {
+		char url[BC66_FOTA_URL_SIZE];
+		snprintf( url, sizeof(url), "%s", line + 12 );
+		url[strcspn( url, "\"" )] = '\0';
+		if( s->http >= 0 ) {
+			fmt = "\r\nERROR\r\n";
+		} else if( sim_http_get( s, url ) ) {
+			fmt = "\r\nOK\r\n\r\n+QIND: \"FOTA\",\"HTTPSTART\"\r\n";
+		} else {
+			fmt = "\r\nOK\r\n\r\n+QIND: \"FOTA\",\"HTTPEND\",601\r\n";
+		}
+	} else if( strncmp( line, "AT+QMTOPEN=", 11 ) == 0 ) {
+		fmt = "\r\nOK\r\n\r\n+QMTOPEN: 0,0\r\n";
+	} else if( strncmp( line, "AT+QMTCONN=", 11 ) == 0 ) {
+		fmt = "\r\nOK\r\n\r\n+QMTCONN: 0,0,0\r\n";
+	} else if( sscanf( line, "AT+QMTPUB=0,%u,", &msg_id ) == 1 ) {
+		snprintf( rsp, sizeof(rsp), "\r\nOK\r\n\r\n+QMTPUB: 0,%u,0\r\n", msg_id );
+		fmt = rsp;
+	}
+	sim_write( s, fmt );
+}
+
+static void sim_readable( sim_t * s )
+{
+	ssize_t n = read( s->fd, s->line + s->len, sizeof(s->line) - 1 - s->len );
+	char * eol;
+
+	if( n <= 0 ) {
+		return;
+	}
+	s->len += n;
+	s->line[s->len] = '\0';
+	while( (eol = memchr( s->line, '\r', s->len )) ) {
+		size_t used = eol - s->line + 1;
+		*eol = '\0';
+		if( s->line[0] == '\n' ) {
+			sim_answer( s, s->line + 1 );
+		} else {
+			sim_answer( s, s->line );
+		}
+		memmove( s->line, s->line + used, s->len - used );
+		s->len -= used;
+	}
+	if( s->len == sizeof(s->line) - 1 ) {
+		s->len = 0;
+	}
+}
+
+static const char * sim_add( void )
+{
+	sim_t * s = &sims[sims_count];
+	struct termios tio;
+	int fd = posix_openpt( O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC );
+
+	if( fd < 0 || grantpt( fd ) < 0 || unlockpt( fd ) < 0 ) {
+		return NULL;
+	}
+	// raw line: no echo nor <CR><LF> translation 
+	if( tcgetattr( fd, &tio ) == 0 ) {
+		cfmakeraw( &tio );
+		tcsetattr( fd, TCSANOW, &tio );
+	}
+	s->fd = fd;
+	s->index = sims_count;
+	s->len = 0;
+	s->http = -1;
+	snprintf( s->revision, sizeof(s->revision), "BC66NBR01A07" );
+	if( epoll_add( fd, TAG_SIM | sims_count ) < 0 ) {
+		close( fd );
+		return NULL;
+	}
+	sims_count ++;
+	return ptsname( fd );
+}
+
+//*****************************************************************************
+// Main loop
+
+static void on_signal( int sig )
+{
+	(void)sig;
+	running = 0;
+}
+
+static void usage( const char * name )
+{
+	fprintf( stderr, "usage: %s -a <api socket> [-b <host:port>] [-p <state dir>] [-s <simulated modules>] [tty ...]\n", name );
+}
+
+int main( int argc, char * argv[] )
+{
+	const char * api_path = NULL;
+	int sim_modules = 0;
+	int lfd;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "a:b:p:s:" )) != -1 ) {
+		switch( opt ) {
+			case 'a':
+				api_path = optarg;
+				break;
+			case 'b': {
+				char * port = strrchr( optarg, ':' );
+				if( port ) {
+					*port = '\0';
+					broker_port = (uint16_t)atoi( port + 1 );
+				}
+				broker_host = optarg;
+				break;
+			}
+			case 'p':
+				state_dir = optarg;
+				break;
+			case 's':
+				sim_modules = atoi( optarg );
+				break;
+			default:
+				usage( argv[0] );
+				return 1;
+		}
+	}
+	if( api_path == NULL || (optind == argc && sim_modules <= 0) ) {
+		usage( argv[0] );
+		return 1;
+	}
+
+	setvbuf( stdout, NULL, _IOLBF, 0 );
+	signal( SIGINT, on_signal );
+	signal( SIGTERM, on_signal );
+	for( int i = 0; i < MAX_CLIENTS; i++ ) {
+		clients[i].fd = -1;
+	}
+
+	epfd = epoll_create1( EPOLL_CLOEXEC );
+	lfd = api_listen( api_path );
+	if( epfd < 0 || lfd < 0 || epoll_add( lfd, TAG_LISTEN ) < 0 ) {
+		perror( "bc66d" );
+		return 1;
+	}
+
+	for( int i = 0; i < sim_modules && i < MAX_MODULES; i++ ) {
+		const char * path = sim_add();
+		if( path == NULL || module_add( path ) < 0 ) {
+			fprintf( stderr, "bc66d: can not create simulated module %d\n", i );
+		}
+	}
+	for( int i = optind; i < argc; i++ ) {
+		module_add( argv[i] );
+	}
+	printf( "bc66d: %d modules, API on %s\n", modules_count, api_path );
+
+	for( int i = 0; i < modules_count; i++ ) {
+		module_step( &modules[i] );
+	}
+
+	while( running ) {
+		struct epoll_event events[32];
+		bool waiting = false;
+		int n;
+
+		// a running command needs its timeout checked, a failed module its retry 
+		for( int i = 0; i < modules_count && !waiting; i++ ) {
+			bc66_select( &modules[i].obj );
+			waiting = bc66_cmd_busy() || modules[i].state == ST_FAILED || modules[i].fota;
+		}
+		n = epoll_wait( epfd, events, 32, waiting ? POLL_TIME_MS : -1 );
+
+		for( int e = 0; e < n; e++ ) {
+			uint32_t tag = events[e].data.u32;
+			switch( TAG_KIND( tag ) ) {
+				case TAG_LISTEN:
+					client_accept( lfd );
+					break;
+				case TAG_CLIENT:
+					client_readable( TAG_INDEX( tag ) );
+					break;
+				case TAG_SIM:
+					sim_readable( &sims[TAG_INDEX( tag )] );
+					break;
+				case TAG_HTTP:
+					sim_http_readable( &sims[TAG_INDEX( tag )] );
+					break;
+				case TAG_MODULE:
+					if( events[e].events & EPOLLOUT ) {
+						module_flush( &modules[TAG_INDEX( tag )] );
+					}
+					if( events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR) ) {
+						module_poll( &modules[TAG_INDEX( tag )] );
+					}
+					break;
+			}
+		}
+
+		// timeouts, retries and updates: only the modules that are waiting 
+		for( int i = 0; i < modules_count; i++ ) {
+			module_t * m = &modules[i];
+			bc66_select( &m->obj );
+			if( m->fota || bc66_cmd_busy() ) {
+				module_poll( m );
+			} else if( m->state == ST_FAILED ) {
+				module_step( m );
+			}
+		}
+	}
+
+	for( int i = 0; i < modules_count; i++ ) {
+		bc66_deinit( &modules[i].obj );
+		close( modules[i].fd );
+	}
+	close( lfd );
+	unlink( api_path );
+	return 0;
+}
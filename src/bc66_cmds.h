@@ -0,0 +1,129 @@
+/**
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @copyright   Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @file    bc66_cmds.h
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @brief
+ * BC66 implemented commands table.
+ *
+ * The table is written once as an X-macro and expanded where it is needed:
+ * the command list enum (bc66_drv.h), the driver command table (bc66_drv.c)
+ * and the constexpr C++ table (bc66_cmds.hpp). To add a command, add its row.
+ *
+ * Row: X( name, command text, possibilities flags, response timeout [ms] )
+ * All commands end with the OK final result code.
+ *
+ * The driver response patterns follow the same way: their enum and the
+ * per-module compiled patterns (bc66_drv.h), their sources (bc66_drv.c).
+ *
+ * Row: X( name, pattern source )
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @date    10/17/2026
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @author    Eng. Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @version    1.0.0
+ *
+ */
+
+#ifndef BC66_CMDS_H_
+#define BC66_CMDS_H_
+
+//*****************************************************************************
+/// Command possibilities indicator flags. 
+typedef enum { 
+	BC66_CMD_FLAG_TEST	= 0x1,				///< Command has test posibility
+	BC66_CMD_FLAG_READ 	= 0x2,				///< Command has read posibility
+	BC66_CMD_FLAG_WRITE = 0x4,				///< Command has write posibility
+	BC66_CMD_FLAG_EXE 	= 0x8,				///< Command has execute posibility
+	BC66_CMD_FLAG_CFG 	= 0x10				///< Write/execute is a setting, replayed after a module restart
+} bc66_cmd_flags_t ;
+
+//*****************************************************************************
+/// Implemented commands. Order gives \p bc66_cmd_list_t values.
+#define BC66_CMDS_TABLE(X) \
+	/* 1- AT command */ \
+	X( AT,			"",				BC66_CMD_FLAG_EXE,																300 	)	/* AT command. Use to sync baud rate. */ \
+	/* 2- Product Information Query Commands */ \
+	X( ATI,			"I",			BC66_CMD_FLAG_EXE,																300 	)	/* Display Product Identification Information */ \
+	X( CGMR,		"+CGMR",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_EXE,											300 	)	/* Request Manufacturer Revision */ \
+	/* 3- UART function commands */ \
+	X( ATE,			"E",			BC66_CMD_FLAG_EXE | BC66_CMD_FLAG_CFG,											300 	)	/* Set Command Echo Mode */ \
+	/* 4- Network State Query Commands */ \
+	X( CEREG,		"+CEREG",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE | BC66_CMD_FLAG_CFG,	300 	)	/* EPS Network Registration Status */ \
+	X( CESQ,		"+CESQ",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_EXE,											300 	)	/* Extended Signal Quality */ \
+	X( COPS,		"+COPS",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE,					180000 	)	/* Operator Selection */ \
+	X( CGATT,		"+CGATT",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE,					85000 	)	/* PS Attachment or Detachment */ \
+	X( CGACT,		"+CGACT",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE,					150000 	)	/* PDP Context Activate or Deactivate */ \
+	X( CGPADDR,		"+CGPADDR",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE | BC66_CMD_FLAG_EXE,	300 	)	/* Show PDP Addresses */ \
+	/* 5- PDN and APN Commands */ \
+	X( QCGDEFCONT,	"+QCGDEFCONT",	BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE | BC66_CMD_FLAG_CFG,	300 	)	/* Set Default PSD Connection Settings */ \
+	/* 6- Other Network Commands */ \
+	X( QENG,		"+QENG",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_WRITE,										300 	)	/* Engineering Mode */ \
+	X( QLOCKF,		"+QLOCKF",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE,					300 	)	/* Lock NB-IoT Frequency */ \
+	X( QBAND,		"+QBAND",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE | BC66_CMD_FLAG_CFG,	300 	)	/* Get and Set Mobile Operation Band */ \
+	/* 7- USIM Related Commands */ \
+	X( CIMI,		"+CIMI",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_EXE,											300 	)	/* Request International Mobile Subscriber Identity */ \
+	X( QCCID,		"+QCCID",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_EXE,											300 	)	/* USIM Card Identification */ \
+	X( CPIN,		"+CPIN",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE,					5000 	)	/* Enter PIN */ \
+	/* 8- Power Consumption Commands */ \
+	X( CPSMS,		"+CPSMS",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE | BC66_CMD_FLAG_CFG,	300 	)	/* Power Saving Mode Setting */ \
+	X( QNBIOTEVENT,	"+QNBIOTEVENT",	BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE | BC66_CMD_FLAG_CFG,	300 	)	/* Enable/Disable NB-IoT Related Event Report */ \
+	X( QNBIOTRAI,	"+QNBIOTRAI",	BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE,					300 	)	/* Configure NB-IoT Release Assistance Indication */ \
+	X( QSCLK,		"+QSCLK",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE | BC66_CMD_FLAG_CFG,	300 	)	/* Configure Sleep Mode */ \
+	/* 9- Platform Related Commands */ \
+	X( QFOTADL,		"+QFOTADL",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_WRITE,										300 	)	/* Firmware Upgrade via DFOTA. Progress is reported by +QIND: "FOTA" URCs */ \
+	/* 10- Time-related Commands */ \
+	X( CCLK,		"+CCLK",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ,										300 	)	/* Return Current Date and Time */ \
+	X( CTZR,		"+CTZR",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE | BC66_CMD_FLAG_CFG,	300 	)	/* Time Zone Reporting */ \
+	/* 11- Other Related Commands */ \
+	X( QMTCFG,		"+QMTCFG",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_WRITE | BC66_CMD_FLAG_CFG,					300 	)	/* Configure Optional Parameters of MQTT */ \
+	X( QMTOPEN,		"+QMTOPEN",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE,					75000 	)	/* Open a Network for MQTT Client */ \
+	X( QMTCLOSE,	"+QMTCLOSE",	BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_WRITE,										300 	)	/* Close a Network for MQTT Client */ \
+	X( QMTCONN,		"+QMTCONN",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_READ | BC66_CMD_FLAG_WRITE,					10000 	)	/* Connect a Client to MQTT Server. <pkt_timeout> (default 10 s), determined by network */ \
+	X( QMTDISC,		"+QMTDISC",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_WRITE,										300 	)	/* Disconnect a Client from MQTT Server */ \
+	X( QMTSUB,		"+QMTSUB",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_WRITE,										40000 	)	/* Subscribe to Topics. <pkt_timeout> + <pkt_timeout> x <retry_times> (default 40 s) */ \
+	X( QMTUNS,		"+QMTUNS",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_WRITE,										40000 	)	/* Unsubscribe from Topics. Same timeout as +QMTSUB */ \
+	X( QMTPUB,		"+QMTPUB",		BC66_CMD_FLAG_TEST | BC66_CMD_FLAG_WRITE,										40000 	)	/* Publish Messages. Same timeout as +QMTSUB */
+
+//*****************************************************************************
+/// Driver response patterns (see \p bc66_pattern_compile(...)).
+#define BC66_RSP_PATTERNS(X) \
+	X( QMTOPEN,		"+QMTOPEN: 0,%d"		)	/* <TCP_connectID>,<result> */ \
+	X( QMTCLOSE,	"+QMTCLOSE: 0,%d"		)	/* <TCP_connectID>,<result> */ \
+	X( QMTCONN,		"+QMTCONN: 0,%d[,%d]"	)	/* <TCP_connectID>,<result>[,<ret_code>] */ \
+	X( QMTSUB,		"+QMTSUB: 0,%d,%d[,%d]"	)	/* <TCP_connectID>,<msgID>,<result>[,<value>] */ \
+	X( QMTUNS,		"+QMTUNS: 0,%d,%d"		)	/* <TCP_connectID>,<msgID>,<result> */ \
+	X( QMTPUB,		"+QMTPUB: 0,%d,%d[,%d]"	)	/* <TCP_connectID>,<msgID>,<result>[,<value>] */
+
+#endif /* BC66_CMDS_H_ */
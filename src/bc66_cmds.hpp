@@ -0,0 +1,313 @@
+/**
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @copyright   Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @file    bc66_cmds.hpp
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @brief
+ * C++20 compile-time checked commands.
+ *
+ * - bc66::cmd_table is the constexpr view of the commands table (bc66_cmds.h).
+ * - bc66::send<Cmd, Type>(fmt, args...) does not compile when \p Cmd has no \p Type
+ *   possibility or when \p args do not match the printf-like \p fmt.
+ * - The command line start ("AT+QMTPUB=") is built at compile time and copied to
+ *   the TX buffer as is, see \p bc66_send_at_prefixed(...).
+ *
+ * Commands are sent to the selected module, as with the C functions.
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @date    10/17/2026
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @author    Eng. Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @version    1.0.0
+ *
+ */
+
+#ifndef BC66_CMDS_HPP_
+#define BC66_CMDS_HPP_
+
+#if __cplusplus < 202002L
+#error "bc66_cmds.hpp needs C++20"
+#endif
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "bc66_drv.hpp"
+
+namespace bc66 {
+
+//*****************************************************************************
+/// Command table entry.
+struct CmdInfo {
+	std::string_view text;		///< command text, i.e. "+QMTPUB"
+	unsigned int flags;			///< bc66_cmd_flags_t possibilities
+	std::uint32_t timeout;		///< response timeout [ms]
+};
+
+#define BC66_CMD_INFO( name, text, flags, timeout )		CmdInfo{ text, flags, timeout },
+/// Commands table, indexed by bc66_cmd_list_t.
+inline constexpr CmdInfo cmd_table[] = { BC66_CMDS_TABLE( BC66_CMD_INFO ) };
+#undef BC66_CMD_INFO
+
+static_assert( std::size( cmd_table ) == bc66_cmd_list_size, "cmd_table does not match bc66_cmd_list_t" );
+
+/// Possibility flag of a command type.
+constexpr unsigned int type_flag( bc66_cmd_type_t type )
+{
+	switch( type ) {
+		case BC66_CMD_TEST:		return BC66_CMD_FLAG_TEST;
+		case BC66_CMD_READ:		return BC66_CMD_FLAG_READ;
+		case BC66_CMD_WRITE:	return BC66_CMD_FLAG_WRITE;
+		case BC66_CMD_EXE:		return BC66_CMD_FLAG_EXE;
+	}
+	return 0;
+}
+
+/// Command \p Cmd has \p Type possibility.
+template <bc66_cmd_list_t Cmd, bc66_cmd_type_t Type>
+inline constexpr bool supports = ( Cmd < bc66_cmd_list_size ) && ( cmd_table[Cmd].flags & type_flag( Type ) );
+
+namespace detail {
+
+//*****************************************************************************
+/// Command line start of \p Cmd as \p Type, i.e. "AT+QMTPUB=" (not null terminated).
+template <bc66_cmd_list_t Cmd, bc66_cmd_type_t Type>
+consteval auto make_prefix()
+{
+	constexpr std::string_view text = cmd_table[Cmd].text;
+	constexpr std::string_view suffix = ( Type == BC66_CMD_TEST ) ? "=?" : ( Type == BC66_CMD_READ ) ? "?" : ( Type == BC66_CMD_WRITE ) ? "=" : "";
+	std::array<char, 2 + text.size() + suffix.size()> line{};
+	std::size_t len = 0;
+	line[len++] = 'A';
+	line[len++] = 'T';
+	for( char c : text ) {
+		line[len++] = c;
+	}
+	for( char c : suffix ) {
+		line[len++] = c;
+	}
+	return line;
+}
+
+template <bc66_cmd_list_t Cmd, bc66_cmd_type_t Type>
+inline constexpr auto prefix = make_prefix<Cmd, Type>();
+
+//*****************************************************************************
+// Format check. Calls to these (not constexpr) functions stop the compilation
+// and their names are shown by the compiler.
+void format_error_too_few_arguments();
+void format_error_too_many_arguments();
+void format_error_argument_type_mismatch();
+void format_error_unknown_conversion();
+
+/// Argument class, as seen by printf.
+struct ArgKind {
+	bool integral;
+	bool floating;
+	bool cstring;
+	std::size_t size;
+};
+
+template <class T>
+constexpr ArgKind arg_kind()
+{
+	using U = std::remove_cv_t<T>;
+	if constexpr( std::is_enum_v<U> ) {
+		return { true, false, false, sizeof( std::underlying_type_t<U> ) };
+	} else {
+		return { std::is_integral_v<U>, std::is_floating_point_v<U>,
+				 std::is_same_v<U, const char *> || std::is_same_v<U, char *>, sizeof( U ) };
+	}
+}
+
+/// Integral argument matching the length modifier (promoted to int when shorter).
+consteval void check_integral( const ArgKind & arg, std::string_view length )
+{
+	bool ok = arg.integral;
+	if( length == "l" ) {
+		ok = ok && arg.size == sizeof( long );
+	} else if( length == "ll" ) {
+		ok = ok && arg.size == sizeof( long long );
+	} else if( length == "z" ) {
+		ok = ok && arg.size == sizeof( std::size_t );
+	} else {
+		ok = ok && arg.size <= sizeof( int );
+	}
+	if( !ok ) {
+		format_error_argument_type_mismatch();
+	}
+}
+
+/// Check printf-like format against the argument types.
+template <class... Args>
+consteval void check_format( std::string_view fmt )
+{
+	constexpr std::array<ArgKind, sizeof...( Args )> args{ arg_kind<Args>()... };
+	std::size_t n = 0;
+
+	auto next = [&]() -> const ArgKind & {
+		if( n >= args.size() ) {
+			format_error_too_few_arguments();
+		}
+		return args[n++];
+	};
+
+	for( std::size_t i = 0; i < fmt.size(); i++ ) {
+		if( fmt[i] != '%' ) {
+			continue;
+		}
+		if( ++i < fmt.size() && fmt[i] == '%' ) {
+			continue;
+		}
+		// flags 
+		while( i < fmt.size() && std::string_view( "-+ #0" ).find( fmt[i] ) != std::string_view::npos ) {
+			i++;
+		}
+		// width and precision, '*' takes an int argument 
+		for( int field = 0; field < 2; field++ ) {
+			if( field == 1 ) {
+				if( i >= fmt.size() || fmt[i] != '.' ) {
+					break;
+				}
+				i++;
+			}
+			if( i < fmt.size() && fmt[i] == '*' ) {
+				check_integral( next(), "" );
+				i++;
+			} else {
+				while( i < fmt.size() && fmt[i] >= '0' && fmt[i] <= '9' ) {
+					i++;
+				}
+			}
+		}
+		// length modifier 
+		std::size_t start = i;
+		while( i < fmt.size() && std::string_view( "hlz" ).find( fmt[i] ) != std::string_view::npos ) {
+			i++;
+		}
+		std::string_view length = fmt.substr( start, i - start );
+		if( i >= fmt.size() ) {
+			format_error_unknown_conversion();
+		}
+		switch( fmt[i] ) {
+			case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+				check_integral( next(), length );
+				break;
+			case 's':
+				if( !next().cstring ) {
+					format_error_argument_type_mismatch();
+				}
+				break;
+			case 'f': case 'e': case 'g':
+				if( !next().floating ) {
+					format_error_argument_type_mismatch();
+				}
+				break;
+			default:
+				format_error_unknown_conversion();
+		}
+	}
+	if( n != args.size() ) {
+		format_error_too_many_arguments();
+	}
+}
+
+} // namespace detail
+
+//*****************************************************************************
+/**
+ * @brief
+ * Arguments format checked at compile time against the argument types.
+ */
+template <class... Args>
+class Format {
+public:
+	template <std::size_t N>
+	consteval Format( const char ( &fmt )[N] ) : str_( fmt ) {
+		detail::check_format<Args...>( std::string_view( fmt, N - 1 ) );
+	}
+	constexpr const char * c_str() const noexcept { return str_; }
+
+private:
+	const char * str_;
+};
+
+/// Format of arguments \p Args (not deduced from the format).
+template <class... Args>
+using FormatFor = Format<std::type_identity_t<std::decay_t<Args>>...>;
+
+//*****************************************************************************
+/**
+ * @brief
+ * Send \p Cmd as \p Type without arguments and wait its response.
+ */
+template <bc66_cmd_list_t Cmd, bc66_cmd_type_t Type>
+Result<void> send( const char * exp_rsp = nullptr )
+{
+	static_assert( supports<Cmd, Type>, "bc66: command does not implement this command type" );
+	constexpr auto & line = detail::prefix<Cmd, Type>;
+	return check( bc66_send_at_prefixed( Type, Cmd, line.data(), line.size(), exp_rsp, nullptr ) );
+}
+
+/**
+ * @brief
+ * Send \p Cmd as \p Type (write or execution) with arguments and wait its response.
+ */
+template <bc66_cmd_list_t Cmd, bc66_cmd_type_t Type, class... Args>
+Result<void> send( FormatFor<Args...> fmt, Args... args )
+{
+	static_assert( supports<Cmd, Type>, "bc66: command does not implement this command type" );
+	static_assert( Type == BC66_CMD_WRITE || Type == BC66_CMD_EXE, "bc66: only write and execution commands take arguments" );
+	constexpr auto & line = detail::prefix<Cmd, Type>;
+	return check( bc66_send_at_prefixed( Type, Cmd, line.data(), line.size(), nullptr, fmt.c_str(), args... ) );
+}
+
+/**
+ * @brief
+ * Same as send<Cmd, Type>(fmt, args...), waiting \p exp_rsp instead of the command response.
+ */
+template <bc66_cmd_list_t Cmd, bc66_cmd_type_t Type, class... Args>
+Result<void> send_expect( const char * exp_rsp, FormatFor<Args...> fmt, Args... args )
+{
+	static_assert( supports<Cmd, Type>, "bc66: command does not implement this command type" );
+	static_assert( Type == BC66_CMD_WRITE || Type == BC66_CMD_EXE, "bc66: only write and execution commands take arguments" );
+	constexpr auto & line = detail::prefix<Cmd, Type>;
+	return check( bc66_send_at_prefixed( Type, Cmd, line.data(), line.size(), exp_rsp, fmt.c_str(), args... ) );
+}
+
+} // namespace bc66
+
+#endif /* BC66_CMDS_HPP_ */
@@ -0,0 +1,328 @@
+/**
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @copyright   Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @file    bc66_config.h
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @brief
+ * BC66 driver compile-time configuration.
+ *
+ * Every working buffer of the driver is sized here. All values can be overridden
+ * from the compiler command line (-DBC66_RX_BUFFER_SIZE=2048) or from a project
+ * file selected with -DBC66_CONFIG_FILE=\"my_bc66_config.h\".
+ *
+ * Buffers are checked at build time against the command limits they must hold.
+ * Define BC66_RAM_REPORT to print the driver buffer RAM while compiling, and
+ * BC66_OBJ_RAM_MAX to fail the build when sizeof(bc66_obj_t) goes over it.
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @date    10/17/2026
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @author    Eng. Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @version    1.0.0
+ *
+ */
+
+#ifndef BC66_CONFIG_H_
+#define BC66_CONFIG_H_
+
+#if defined(BC66_CONFIG_FILE)
+#include BC66_CONFIG_FILE
+#endif
+
+//*****************************************************************************
+// BC66 command limits (see Quectel BC66 AT commands manual)
+
+#ifndef BC66_MQTT_TOPIC_MAX_LEN
+#define BC66_MQTT_TOPIC_MAX_LEN			255		///< MQTT topic max length.
+#endif
+
+#ifndef BC66_MQTT_PUBLISH_MAX_LEN
+#define BC66_MQTT_PUBLISH_MAX_LEN		700		///< MQTT message max length (command mode).
+#endif
+
+#ifndef BC66_MQTT_DATA_MODE_MAX_LEN
+#define BC66_MQTT_DATA_MODE_MAX_LEN		1024	///< MQTT message max length (data mode, after '>').
+#endif
+
+#ifndef BC66_MQTT_CLIENT_ID_MAX_LEN
+#define BC66_MQTT_CLIENT_ID_MAX_LEN		128		///< MQTT client identifier max length.
+#endif
+
+#ifndef BC66_MQTT_USER_MAX_LEN
+#define BC66_MQTT_USER_MAX_LEN			256		///< MQTT user name max length.
+#endif
+
+#ifndef BC66_MQTT_PASS_MAX_LEN
+#define BC66_MQTT_PASS_MAX_LEN			256		///< MQTT password max length.
+#endif
+
+#ifndef BC66_MQTT_SERVER_MAX_LEN
+#define BC66_MQTT_SERVER_MAX_LEN		149		///< MQTT server address max length.
+#endif
+
+#ifndef BC66_APN_MAX_LEN
+#define BC66_APN_MAX_LEN				99		///< APN max length.
+#endif
+
+#ifndef BC66_PSD_USER_MAX_LEN
+#define BC66_PSD_USER_MAX_LEN			63		///< PSD connection user name max length.
+#endif
+
+#ifndef BC66_PSD_PASS_MAX_LEN
+#define BC66_PSD_PASS_MAX_LEN			63		///< PSD connection password max length.
+#endif
+
+#ifndef BC66_MAX_LOCKED_BANDS
+#define BC66_MAX_LOCKED_BANDS			16		///< Max number of bands in AT+QBAND.
+#endif
+
+//*****************************************************************************
+// Driver buffers
+
+#ifndef BC66_TX_BUFFER_SIZE
+#define BC66_TX_BUFFER_SIZE				1024	///< AT command line buffer (static).
+#endif
+
+#ifndef BC66_RX_BUFFER_SIZE
+#define BC66_RX_BUFFER_SIZE				1536	///< Modem responses buffer (static).
+#endif
+
+#ifndef BC66_ARENA_SIZE
+#define BC66_ARENA_SIZE					512		///< Per command scratch memory (static). All the buffers below are allocated here.
+#endif
+
+#ifndef BC66_MAX_RSP_SIZE
+#define BC66_MAX_RSP_SIZE				128		///< Max AT response line size (arena).
+#endif
+
+#ifndef BC66_EXP_RSP_SIZE
+#define BC66_EXP_RSP_SIZE				48		///< Max expected response text length.
+#endif
+
+#ifndef BC66_PATTERN_MAX_ELEMS
+#define BC66_PATTERN_MAX_ELEMS			12		///< Max elements of a compiled response pattern (literals, fields, alternatives).
+#endif
+
+#ifndef BC66_PATTERN_MAX_FIELDS
+#define BC66_PATTERN_MAX_FIELDS			6		///< Max fields captured by a response pattern.
+#endif
+
+#ifndef BC66_PDP_CONTEXTS
+#define BC66_PDP_CONTEXTS				3		///< PDP contexts kept in the address cache.
+#endif
+
+#ifndef BC66_DEFAULT_CID
+#define BC66_DEFAULT_CID				1		///< PDP context of bc66_get_ipv4_address() and bc66_get_ipv6_address().
+#endif
+
+#ifndef BC66_MAX_NEIGHBOUR_CELLS
+#define BC66_MAX_NEIGHBOUR_CELLS		4		///< Neighbour cells kept from AT+QENG=0.
+#endif
+
+#ifndef BC66_PLMN_SIZE
+#define BC66_PLMN_SIZE					7		///< Numeric PLMN (MCC + MNC) with string terminator.
+#endif
+
+#ifndef BC66_IMSI_SIZE
+#define BC66_IMSI_SIZE					16		///< IMSI (15 digits) with string terminator.
+#endif
+
+#ifndef BC66_ICCID_SIZE
+#define BC66_ICCID_SIZE					23		///< ICCID (up to 22 chars) with string terminator.
+#endif
+
+#ifndef BC66_FW_ID_SIZE
+#define BC66_FW_ID_SIZE					24		///< Manufacturer, model and revision strings (ATI) with string terminator.
+#endif
+
+#ifndef BC66_FOTA_URL_SIZE
+#define BC66_FOTA_URL_SIZE				128		///< DFOTA image URL with string terminator.
+#endif
+
+#ifndef BC66_FOTA_MAX_ATTEMPTS
+#define BC66_FOTA_MAX_ATTEMPTS			3		///< DFOTA image download requests before giving up.
+#endif
+
+#ifndef BC66_FOTA_SAVE_STEP
+#define BC66_FOTA_SAVE_STEP				10		///< DFOTA progress [%] between state saves.
+#endif
+
+#ifndef BC66_FOTA_RESUME_QUIET
+#define BC66_FOTA_RESUME_QUIET			30000	///< Time without +QIND: "FOTA" before a resumed download is requested again [ms].
+#endif
+
+#ifndef BC66_FOTA_VERIFY_TIMEOUT
+#define BC66_FOTA_VERIFY_TIMEOUT		120000	///< Max time for the module to answer with its new revision [ms].
+#endif
+
+#ifndef BC66_RESYNC_TIMEOUT
+#define BC66_RESYNC_TIMEOUT				1000	///< Max wait of the resync marker answer after a timed out command [ms].
+#endif
+
+#ifndef BC66_STALE_TIME
+#define BC66_STALE_TIME					60000	///< Time a late answer of a timed out command is still dropped [ms].
+#endif
+
+#ifndef BC66_HEALTH_MAX_TIMEOUTS
+#define BC66_HEALTH_MAX_TIMEOUTS		3		///< Consecutive command timeouts that start a module recovery.
+#endif
+
+#ifndef BC66_HEALTH_PROBES
+#define BC66_HEALTH_PROBES				2		///< AT probes on each recovery tier before escalating to the next one.
+#endif
+
+#ifndef BC66_HEALTH_IDLE_TIME
+#define BC66_HEALTH_IDLE_TIME			300000	///< Time without received chars before an AT liveness probe [ms].
+#endif
+
+#ifndef BC66_HEALTH_BOOT_TIME
+#define BC66_HEALTH_BOOT_TIME			5000	///< Wait after a reset or power cycle before probing the module [ms].
+#endif
+
+#ifndef BC66_HEALTH_RETRY_TIME
+#define BC66_HEALTH_RETRY_TIME			600000	///< Power cycle period while the module does not answer at all [ms].
+#endif
+
+#ifndef BC66_CFG_CACHE_SIZE
+#define BC66_CFG_CACHE_SIZE				384		///< Setting command lines replayed after a module restart (static).
+#endif
+
+#ifndef BC66_RX_CHUNK_SIZE
+#define BC66_RX_CHUNK_SIZE				64		///< Max bytes read from UART on each poll.
+#endif
+
+#ifndef BC66_RX_RING_SIZE
+#define BC66_RX_RING_SIZE				0		///< Receive ring filled by bc66_rx_feed() from an ISR or DMA callback (static). Power of two to push bytes, 0 to leave it out.
+#endif
+
+#if BC66_RX_RING_SIZE && !defined(BC66_RX_RING_BARRIER)
+#if defined(__GNUC__)
+#define BC66_RX_RING_BARRIER()			__sync_synchronize()	///< Memory barrier between ring data and ring indexes.
+#else
+#error "BC66_RX_RING_SIZE needs BC66_RX_RING_BARRIER(): define a memory barrier for the target compiler"
+#endif
+#endif
+
+#ifndef BC66_PDP_ARGS_SIZE
+#define BC66_PDP_ARGS_SIZE				256		///< AT+QCGDEFCONT arguments buffer (arena).
+#endif
+
+#ifndef BC66_BANDS_ARGS_SIZE
+#define BC66_BANDS_ARGS_SIZE			72		///< AT+QBAND arguments buffer (arena).
+#endif
+
+//*****************************************************************************
+// Transmit policy (bc66_tx_policy.h)
+
+#ifndef BC66_TX_QUEUE_SIZE
+#define BC66_TX_QUEUE_SIZE				8		///< Messages held by a transmit policy.
+#endif
+
+#ifndef BC66_TX_CLASSES
+#define BC66_TX_CLASSES					4		///< Message classes of a transmit policy.
+#endif
+
+#ifndef BC66_TX_MAX_RETRIES
+#define BC66_TX_MAX_RETRIES				3		///< Publish retries of a queued message before it is dropped.
+#endif
+
+//*****************************************************************************
+// Threads
+
+#ifndef BC66_THREAD_LOCAL
+#define BC66_THREAD_LOCAL						///< Selected module storage. Define as _Thread_local to drive modules from several threads (one module per thread at a time).
+#endif
+
+//*****************************************************************************
+// Build time checks
+
+#if defined(__cplusplus)
+#define BC66_STATIC_ASSERT(cond, msg)	static_assert(cond, msg)
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#define BC66_STATIC_ASSERT(cond, msg)	_Static_assert(cond, msg)
+#else
+#define BC66_STATIC_ASSERT_NAME(line)	BC66_STATIC_ASSERT_JOIN(bc66_static_assert_, line)
+#define BC66_STATIC_ASSERT_JOIN(a, b)	a##b
+#define BC66_STATIC_ASSERT(cond, msg)	typedef char BC66_STATIC_ASSERT_NAME(__LINE__)[(cond) ? 1 : -1]
+#endif
+
+#define BC66_MAX(a, b)		(((a) > (b)) ? (a) : (b))
+
+/// Worst case AT+QMTPUB line: AT+QMTPUB=0,65535,2,1,"<topic>","<msg>"<CR><LF><NUL>
+#define BC66_PUBLISH_CMD_MAX_LEN	(sizeof("AT+QMTPUB=0,65535,2,1,\"\",\"\"\r\n") + BC66_MQTT_TOPIC_MAX_LEN + BC66_MQTT_PUBLISH_MAX_LEN)
+
+/// Worst case AT+QMTCONN line: AT+QMTCONN=0,"<id>","<user>","<pass>"<CR><LF><NUL>
+#define BC66_CONNECT_CMD_MAX_LEN	(sizeof("AT+QMTCONN=0,\"\",\"\",\"\"\r\n") + BC66_MQTT_CLIENT_ID_MAX_LEN + BC66_MQTT_USER_MAX_LEN + BC66_MQTT_PASS_MAX_LEN)
+
+/// Worst case +QMTRECV URC: +QMTRECV: 0,65535,"<topic>","<payload>"<CR><LF><NUL>
+#define BC66_RECV_URC_MAX_LEN		(sizeof("\r\n+QMTRECV: 0,65535,\"\",\"\"\r\n") + BC66_MQTT_TOPIC_MAX_LEN + BC66_MQTT_DATA_MODE_MAX_LEN)
+
+/// Worst case AT+QCGDEFCONT arguments: "IPV4V6","<apn>","<user>","<pass>"<NUL>
+#define BC66_PDP_ARGS_MAX_LEN		(sizeof("\"IPV4V6\",\"\",\"\",\"\"") + BC66_APN_MAX_LEN + BC66_PSD_USER_MAX_LEN + BC66_PSD_PASS_MAX_LEN)
+
+/// Worst case AT+QBAND arguments: <n>,<band>,...,<band><NUL> (bands up to 3 digits)
+#define BC66_BANDS_ARGS_MAX_LEN		(3 + (BC66_MAX_LOCKED_BANDS * 4) + 1)
+
+/// Arena allocations are aligned to pointer size.
+#define BC66_ARENA_ALIGN(n)			(((n) + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+
+/// Worst case arena usage: the last response slot of the previous command (kept until the 
+/// next command is sent) plus the largest argument buffer of the next one. Each command 
+/// reuses one last response slot for all its responses; UART chunks are read straight 
+/// into the RX buffer and take no arena memory. 
+#define BC66_ARENA_WORST_CASE_USAGE	(BC66_ARENA_ALIGN(BC66_MAX_RSP_SIZE) + BC66_ARENA_ALIGN(BC66_MAX( BC66_PDP_ARGS_SIZE, BC66_BANDS_ARGS_SIZE )))
+
+BC66_STATIC_ASSERT( BC66_TX_BUFFER_SIZE >= BC66_PUBLISH_CMD_MAX_LEN, "BC66_TX_BUFFER_SIZE can not hold a max length AT+QMTPUB command" );
+BC66_STATIC_ASSERT( BC66_TX_BUFFER_SIZE >= BC66_CONNECT_CMD_MAX_LEN, "BC66_TX_BUFFER_SIZE can not hold a max length AT+QMTCONN command" );
+BC66_STATIC_ASSERT( BC66_RX_BUFFER_SIZE >= BC66_RECV_URC_MAX_LEN, "BC66_RX_BUFFER_SIZE can not hold a max length (data mode) message" );
+BC66_STATIC_ASSERT( BC66_RX_BUFFER_SIZE > BC66_RX_CHUNK_SIZE, "BC66_RX_CHUNK_SIZE must be smaller than BC66_RX_BUFFER_SIZE" );
+BC66_STATIC_ASSERT( BC66_ARENA_SIZE >= BC66_ARENA_WORST_CASE_USAGE, "BC66_ARENA_SIZE can not hold the arguments and response of a command" );
+BC66_STATIC_ASSERT( BC66_PDP_ARGS_SIZE >= BC66_PDP_ARGS_MAX_LEN, "BC66_PDP_ARGS_SIZE can not hold max length APN, user and password" );
+BC66_STATIC_ASSERT( BC66_BANDS_ARGS_SIZE >= BC66_BANDS_ARGS_MAX_LEN, "BC66_BANDS_ARGS_SIZE can not hold BC66_MAX_LOCKED_BANDS bands" );
+BC66_STATIC_ASSERT( (BC66_RX_RING_SIZE & (BC66_RX_RING_SIZE - 1)) == 0, "BC66_RX_RING_SIZE must be a power of two" );
+BC66_STATIC_ASSERT( BC66_TX_BUFFER_SIZE >= sizeof("AT+QFOTADL=\"\"\r\n") + BC66_FOTA_URL_SIZE, "BC66_TX_BUFFER_SIZE can not hold a max length AT+QFOTADL command" );
+
+//*****************************************************************************
+// RAM footprint
+
+/// RAM of the driver buffers of each module [bytes]. Only a part of \p bc66_obj_t: 
+/// the driver state (response patterns, caches, coroutines) comes on top, 
+/// sizeof(bc66_obj_t) is the RAM of each module. 
+#define BC66_BUFFER_RAM_USAGE		(BC66_TX_BUFFER_SIZE + BC66_RX_BUFFER_SIZE + BC66_ARENA_SIZE + BC66_CFG_CACHE_SIZE + BC66_RX_RING_SIZE)
+
+/// Stack buffers sized here on the deepest driver call path [bytes]: AT+QBAND list 
+/// (bc66_set_mobile_bands), pattern leading literal (response wait) and captured 
+/// fields (MQTT commands). Frames and locals depend on the compiler, see -fstack-usage. 
+#define BC66_STACK_BUFFERS_USAGE	(BC66_MAX_LOCKED_BANDS + BC66_EXP_RSP_SIZE + BC66_PATTERN_MAX_FIELDS * (sizeof(const char *) + 2 * sizeof(int32_t)))
+
+#endif /* BC66_CONFIG_H_ */
@@ -0,0 +1,281 @@
+/**
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @copyright   Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @file    bc66_coro.hpp
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @brief
+ * C++20 coroutine layer over the BC66 asynchronous driver core.
+ *
+ * - bc66::Task<T> is a lazy coroutine, started when it is awaited or by start().
+ * - bc66::AsyncModem::command(...) and publish(...) are awaitables: the coroutine
+ *   is suspended until \p bc66_process() finds the response and calls the done
+ *   callback, which resumes it. Nothing waits in the driver.
+ * - One thread drives any number of modules calling AsyncModem::process() on each
+ *   of them (i.e. when its UART is readable). Coroutine frames are the only
+ *   per-module state besides \p bc66_obj_t, there is no per-module stack.
+ *
+ * A module runs one command at a time, awaiting a second command on the same
+ * module returns bc66_ret_busy.
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @date    10/17/2026
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @author    Eng. Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @version    1.0.0
+ *
+ */
+
+#ifndef BC66_CORO_HPP_
+#define BC66_CORO_HPP_
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "bc66_drv.hpp"
+
+namespace bc66 {
+
+template <class T = void>
+class Task;
+
+namespace detail {
+
+//*****************************************************************************
+/// Promise members shared by every Task<T>.
+struct PromiseBase {
+	std::coroutine_handle<> continuation_ = std::noop_coroutine();
+
+	/// Resume the awaiting coroutine, if any, when the task ends.
+	struct FinalAwaiter {
+		bool await_ready() const noexcept { return false; }
+		template <class P>
+		std::coroutine_handle<> await_suspend( std::coroutine_handle<P> h ) noexcept { return h.promise().continuation_; }
+		void await_resume() const noexcept {}
+	};
+
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	FinalAwaiter final_suspend() const noexcept { return {}; }
+	void unhandled_exception() const noexcept { std::terminate(); }
+};
+
+template <class T>
+struct Promise : PromiseBase {
+	std::optional<T> value_;
+
+	Task<T> get_return_object() noexcept;
+	template <class U>
+	void return_value( U && value ) { value_.emplace( std::forward<U>( value ) ); }
+	T result() { return std::move( *value_ ); }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+	Task<void> get_return_object() noexcept;
+	void return_void() const noexcept {}
+	void result() const noexcept {}
+};
+
+} // namespace detail
+
+//*****************************************************************************
+/**
+ * @brief
+ * Lazy coroutine. Owns its frame, which is destroyed with the task.
+ */
+template <class T>
+class Task {
+public:
+	using promise_type = detail::Promise<T>;
+
+	Task( Task && other ) noexcept : h_( std::exchange( other.h_, nullptr ) ) {}
+	Task( const Task & ) = delete;
+	Task & operator=( const Task & ) = delete;
+	Task & operator=( Task && other ) noexcept {
+		if( this != &other ) {
+			if( h_ ) {
+				h_.destroy();
+			}
+			h_ = std::exchange( other.h_, nullptr );
+		}
+		return *this;
+	}
+	~Task() {
+		if( h_ ) {
+			h_.destroy();
+		}
+	}
+
+	/// Start a top level task. It runs until its first suspension.
+	void start() { h_.resume(); }
+
+	/// The task has ended.
+	bool done() const noexcept { return !h_ || h_.done(); }
+
+	/// Task result, once done().
+	T result() { return h_.promise().result(); }
+
+	bool await_ready() const noexcept { return false; }
+	std::coroutine_handle<> await_suspend( std::coroutine_handle<> awaiting ) noexcept {
+		h_.promise().continuation_ = awaiting;
+		return h_;
+	}
+	T await_resume() { return h_.promise().result(); }
+
+private:
+	friend promise_type;
+	explicit Task( std::coroutine_handle<promise_type> h ) noexcept : h_( h ) {}
+
+	std::coroutine_handle<promise_type> h_;
+};
+
+namespace detail {
+
+template <class T>
+Task<T> Promise<T>::get_return_object() noexcept { return Task<T>( std::coroutine_handle<Promise<T>>::from_promise( *this ) ); }
+
+inline Task<void> Promise<void>::get_return_object() noexcept { return Task<void>( std::coroutine_handle<Promise<void>>::from_promise( *this ) ); }
+
+//*****************************************************************************
+/**
+ * @brief
+ * Awaitable driver command. \p Start sends the command with the given done
+ * callback; the coroutine is resumed from \p bc66_process(). A start refused
+ * while the module resynchronizes is done again from \p bc66_process().
+ */
+template <class Start>
+class CommandAwaiter {
+public:
+	CommandAwaiter( bc66_obj_t * obj, Start start ) : obj_( obj ), start_( std::move( start ) ) {}
+
+	bool await_ready() const noexcept { return false; }
+
+	bool await_suspend( std::coroutine_handle<> h ) {
+		h_ = h;
+		bc66_select( obj_ );
+		ret_ = start_( &CommandAwaiter::done, this );
+		// module resynchronizing after a timeout: sent once it is idle
+		if( ret_ == bc66_ret_busy ) {
+			return bc66_cmd_wait_ready( &CommandAwaiter::ready, this ) == bc66_ret_success;
+		}
+		// not sent: continue without suspending
+		return ret_ == bc66_ret_success;
+	}
+
+	Result<void> await_resume() const { return check( ret_ ); }
+
+private:
+	static void done( bc66_ret_t ret_code, void * arg ) {
+		CommandAwaiter * self = static_cast<CommandAwaiter *>( arg );
+		self->ret_ = ret_code;
+		self->h_.resume();
+	}
+
+	static void ready( bc66_ret_t, void * arg ) {
+		CommandAwaiter * self = static_cast<CommandAwaiter *>( arg );
+		self->ret_ = self->start_( &CommandAwaiter::done, self );
+		if( self->ret_ == bc66_ret_busy && bc66_cmd_wait_ready( &CommandAwaiter::ready, self ) == bc66_ret_success ) {
+			return;
+		}
+		if( self->ret_ != bc66_ret_success ) {
+			self->h_.resume();
+		}
+	}
+
+	bc66_obj_t * obj_;
+	Start start_;
+	std::coroutine_handle<> h_;
+	bc66_ret_t ret_ = bc66_ret_error;
+};
+
+} // namespace detail
+
+//*****************************************************************************
+/**
+ * @brief
+ * Initialized module driven by coroutines. It does not own the module, see bc66::Modem.
+ * \p func_get_tick should be set in the HAL object so timeouts do not depend on
+ * the process() call rate.
+ */
+class AsyncModem {
+public:
+	explicit AsyncModem( bc66_obj_t & obj ) noexcept : obj_( &obj ) {}
+
+	/// HAL object.
+	bc66_obj_t * native_handle() const noexcept { return obj_; }
+
+	/// Process received chars, resuming the coroutine waiting this module.
+	void process() const {
+		if( bc66_select( obj_ ) == bc66_ret_success ) {
+			bc66_process();
+		}
+	}
+
+	/// A command is waiting its response.
+	bool busy() const {
+		return ( bc66_select( obj_ ) == bc66_ret_success ) && bc66_cmd_busy();
+	}
+
+	/// Send any command, see \p bc66_cmd_start(...).
+	template <class... Args>
+	auto command( bc66_cmd_type_t type, bc66_cmd_list_t cmd, const char * exp_rsp, const char * arg_fmt, Args... args ) {
+		auto start = [=]( bc66_done_cb_t cb, void * arg ) {
+			return bc66_cmd_start( cb, arg, type, cmd, exp_rsp, arg_fmt, args... );
+		};
+		return detail::CommandAwaiter<decltype( start )>( obj_, start );
+	}
+
+	/// Publish a message (command mode), see \p bc66_publish_msg_mqtt_start(...).
+	/// Topic and payload must stay valid until the command is sent, i.e. until co_await.
+	auto publish( std::string_view topic, std::string_view payload, int qos = 0 ) {
+		auto start = [=]( bc66_done_cb_t cb, void * arg ) {
+			return bc66_publish_msg_mqtt_start( cb, arg, topic.data(), topic.size(), payload.data(), payload.size(), qos );
+		};
+		return detail::CommandAwaiter<decltype( start )>( obj_, start );
+	}
+
+	/// Last modem response.
+	std::string_view last_response() const {
+		bc66_select( obj_ );
+		return bc66_get_last_response();
+	}
+
+private:
+	bc66_obj_t * obj_;
+};
+
+} // namespace bc66
+
+#endif /* BC66_CORO_HPP_ */
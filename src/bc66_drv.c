@@ -60,6 +60,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <assert.h>
 #include "bc66_drv.h"
 
 // commands defines 
@@ -72,7 +73,31 @@
 #define RSP_TIMEOUT 			"BC66_TIMEOUT\r\n"	///< Answer when a timeout is occurred.
 #define RSP_NO_CMD_IMPEMENTED 	"BC66_NO_CMD\r\n"	///< The command is not implemented.
 
-#define MAX_RSP_SIZE	64		///< Max AT response size
+// final result codes (response line without <CR><LF>)
+#define FRC_OK					"OK"				///< Command executed.
+#define FRC_ERROR				"ERROR"				///< Command failed.
+#define FRC_CME_ERROR			"+CME ERROR:"		///< Command failed, ME error code follows.
+#define FRC_CMS_ERROR			"+CMS ERROR:"		///< Command failed, MS error code follows.
+#define CME_NOT_SUPPORTED		4					///< +CME ERROR number: operation not supported.
+
+// data mode 
+#define RSP_DATA_PROMPT			">"					///< Module is waiting for data.
+#define CMD_END_OF_DATA			0x1A				///< Ctrl+Z, ends data mode.
+#define CMD_ESC					0x1B				///< ESC, leaves data mode without sending.
+
+#if defined(BC66_RAM_REPORT)
+#define BC66_STR_(x)	#x
+#define BC66_STR(x)		BC66_STR_(x)
+// the preprocessor can not add: each term is printed with its value 
+#pragma message( "bc66: buffer RAM per module [bytes] = TX " BC66_STR(BC66_TX_BUFFER_SIZE) " + RX " BC66_STR(BC66_RX_BUFFER_SIZE) \
+				 " + arena " BC66_STR(BC66_ARENA_SIZE) " + cfg cache " BC66_STR(BC66_CFG_CACHE_SIZE) " + RX ring " BC66_STR(BC66_RX_RING_SIZE) " (sizeof(bc66_obj_t) adds the driver state)" )
+#pragma message( "bc66: worst case stack buffers [bytes] = bands " BC66_STR(BC66_MAX_LOCKED_BANDS) " + response lead " BC66_STR(BC66_EXP_RSP_SIZE) \
+				 " + " BC66_STR(BC66_PATTERN_MAX_FIELDS) " match fields (see BC66_STACK_BUFFERS_USAGE)" )
+#endif
+
+#if defined(BC66_OBJ_RAM_MAX)
+BC66_STATIC_ASSERT( sizeof(bc66_obj_t) <= BC66_OBJ_RAM_MAX, "bc66_obj_t is larger than BC66_OBJ_RAM_MAX" );
+#endif
 
 /**
  * AT Command Syntax
@@ -89,208 +114,132 @@
  */
 
 //*****************************************************************************
-// global working buffers
-static uint8_t tx_buffer[512];
-static uint8_t rx_buffer[512];
-static uint8_t rx_last_response[256];
-
-// pointer to once object instance 
-static bc66_obj_t *bc66 = NULL;
-
-/// Buffer to save last valid answer
-static char rsp_found[MAX_RSP_SIZE];
+// pointer to selected object instance. Working buffers are in its driver data (bc66->drv).
+// Each thread has its own selection when BC66_THREAD_LOCAL is defined (see bc66_config.h).
+static BC66_THREAD_LOCAL bc66_obj_t *bc66 = NULL;
 
 //*****************************************************************************
-/// Command possibilities indicator flags. 
-typedef enum { 
-	TEST	= 0x1,				///< Command has test posibility
-	READ 	= 0x2,				///< Command has read posibility
-	WRITE 	= 0x4,				///< Command has write posibility
-	EXE 	= 0x8				///< Command has execute posibility
-} cmd_flgs_t ;
-
 /// BC66 Command struct 
 typedef const struct
 {
 	const char 	*cmd;			///< at command sentence
-	cmd_flgs_t 	cmd_flags;		///< flags for command implementation (see @code flags enum)
+	bc66_cmd_flags_t cmd_flags;	///< flags for command implementation (see @code bc66_cmd_flags_t)
 	char 		*cmd_rsp;		///< expected command response
 	uint32_t 	rsp_timeout;	///< response timeout [ms]
 } bc66_at_cmd_t;
 
 //*****************************************************************************
-/// Define AT commands list: order must be equal to commands definition enum bc66_cmd_list_t
+/// Define AT commands list from BC66_CMDS_TABLE (bc66_cmds.h): same order as enum bc66_cmd_list_t
+#define BC66_CMD_ROW( name, text, flags, timeout )	{ .cmd = text, .cmd_flags = flags, .cmd_rsp = RSP_OK, .rsp_timeout = timeout },
 const bc66_at_cmd_t bc66_cmds_list[] = {
-/* 1- AT command */
-	{
-		.cmd = "\0",
-		.cmd_flags = EXE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-
-/* 2- Product Information Query Commands */
-	{
-		.cmd = "I",
-		.cmd_flags = EXE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-
-/* 3- UART function commands */
-	{
-		.cmd = "E",
-		.cmd_flags = EXE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-
-/* 4- Network State Query Commands */
-	{
-		.cmd = "+CEREG",
-		.cmd_flags = TEST | READ | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-	{
-		.cmd = "+CESQ",
-		.cmd_flags = TEST | EXE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-	{
-		.cmd = "+CGATT",
-		.cmd_flags = TEST | READ | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 85000,
-	},
-	{
-		.cmd = "+CGPADDR",
-		.cmd_flags = TEST | READ | WRITE | EXE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-
-/* 5- PDN and APN Commands */
-	{
-		.cmd = "+QCGDEFCONT",
-		.cmd_flags = TEST | READ | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-
-/* 6- Other Network Commands */
-	{
-		.cmd = "+QBAND",
-		.cmd_flags = TEST | READ | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-
-/* 7- USIM Related Commands */
-	{
-		.cmd = "+CIMI",
-		.cmd_flags = TEST | EXE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-
-	{
-		.cmd = "+CPIN",
-		.cmd_flags = TEST | READ | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 5000,
-	},
-
-/* 8- Power Consumption Commands */ 
-	{
-		.cmd = "+CPSMS",
-		.cmd_flags = TEST | READ | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-	{
-		.cmd = "+QNBIOTEVENT",
-		.cmd_flags = TEST | READ | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-	{
-		.cmd = "+QSCLK",
-		.cmd_flags = TEST | READ | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
+	BC66_CMDS_TABLE( BC66_CMD_ROW )
+};
+#undef BC66_CMD_ROW
 
-/* 9- Platform Related Commands */ 
+//*****************************************************************************
+/// Driver response pattern sources from BC66_RSP_PATTERNS (bc66_cmds.h): same order as enum bc66_rsp_list_t. 
+#define BC66_RSP_SRC( name, src )		src,
+static const char * const bc66_rsp_src[] = {
+	BC66_RSP_PATTERNS( BC66_RSP_SRC )
+};
+#undef BC66_RSP_SRC
 
-/* 10- Time-related Commands */
+//*****************************************************************************
+/**
+ * @brief 
+ * Get memory from command arena. It is valid until the next command is sent. 
+ * 
+ * @param size	: bytes 
+ * 
+ * @return 
+ * Pointer to memory or NULL if arena is full.
+ */
+static void * _bc66_arena_alloc( size_t size )
+{
+	void * ptr;
+	// keep allocations aligned 
+	size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+	if( (bc66 == NULL) || size > sizeof(bc66->drv.arena.buf) - bc66->drv.arena_top ) {
+		return NULL;
+	}
+	ptr = &bc66->drv.arena.buf[bc66->drv.arena_top];
+	bc66->drv.arena_top += size;
+	return ptr;
+}
 
-/* 11- Other Related Commands */ 
-	{
-		.cmd = "+QMTCFG",
-		.cmd_flags = TEST | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-	{
-		.cmd = "+QMTOPEN",
-		.cmd_flags = TEST | READ | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 75000,
-	},
-	{
-		.cmd = "+QMTCLOSE",
-		.cmd_flags = TEST | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-	{
-		.cmd = "+QMTCONN",
-		.cmd_flags = TEST | READ | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 10000,	/* <pkt_timeout> (default 10 s), determined by network */
-	},
-	{
-		.cmd = "+QMTDISC",
-		.cmd_flags = TEST | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 300,
-	},
-	{
-		.cmd = "+QMTSUB",
-		.cmd_flags = TEST | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 40000,	/* 	<pkt_timeout> + <pkt_timeout> ×<retry_times>
-								(default 40 s), determined by network */
-	},
-	{
-		.cmd = "+QMTUNS",
-		.cmd_flags = TEST | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 40000,	/* 	<pkt_timeout> + <pkt_timeout> ×<retry_times>
-								(default 40 s), determined by network */
-	},
-	{
-		.cmd = "+QMTPUB",
-		.cmd_flags = TEST | WRITE,
-		.cmd_rsp = RSP_OK,
-		.rsp_timeout = 40000,	/* 	<pkt_timeout> + <pkt_timeout> ×<retry_times>
-								(default 40 s), determined by network */
-	},
-};
+//*****************************************************************************
+/**
+ * @brief 
+ * Release all command arena memory. 
+ */
+static void _bc66_arena_reset( void )
+{
+	bc66->drv.arena_top = 0;
+	bc66->drv.last_rsp = NULL;
+}
 
 //*****************************************************************************
+/**
+ * @brief 
+ * Store a response line as last response. The line goes to one BC66_MAX_RSP_SIZE 
+ * slot taken from the arena by the first response of a command and reused by 
+ * the next ones, so reading many responses does not use up the arena. 
+ * 
+ * @param rsp	: response text 
+ * @param len	: response length 
+ * 
+ * @return 
+ * Stored response or NULL if there is no room for it.
+ */
+static char * _bc66_set_last_response( const char * rsp, size_t len )
+{
+	char * ptr = bc66->drv.last_rsp;
+	if( len >= BC66_MAX_RSP_SIZE ) { 
+		return NULL;
+	}
+	if( (ptr == NULL) && ((ptr = (char *)_bc66_arena_alloc( BC66_MAX_RSP_SIZE )) == NULL) ) { 
+		return NULL;
+	}
+	memcpy( ptr, rsp, len );
+	ptr[len] = '\0';
+	bc66->drv.last_rsp = ptr;
+	return ptr;
+}
 
+//*****************************************************************************
 static void _bc66_rx_buffer_flush( void )
 {
-	memset(rx_buffer,0,sizeof(rx_buffer));
+	bc66->drv.rx_len = 0;
+	bc66->drv.rx_buffer[0] = '\0';
+	bc66->drv.urc_scan = 0;
 }
 
 //*****************************************************************************
 static void _bc66_tx_buffer_flush( void )
 {
-	memset(rx_buffer,0,sizeof(rx_buffer));
+	bc66->drv.tx_len = 0;
+	bc66->drv.tx_buffer[0] = '\0';
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Remove chars from RX buffer. 
+ * 
+ * @param start	: first char to remove 
+ * @param len	: chars to remove 
+ */
+static void _bc66_rx_buffer_remove( char * start, size_t len )
+{
+	size_t tail = bc66->drv.rx_len - ((start + len) - (char*)bc66->drv.rx_buffer);
+	size_t offset = start - (char*)bc66->drv.rx_buffer;
+	// move remaining chars with string terminator 
+	memmove( start, start + len, tail + 1 );
+	bc66->drv.rx_len -= len;
+	// keep URC scan position on the same char 
+	if( bc66->drv.urc_scan > offset ) { 
+		bc66->drv.urc_scan = (bc66->drv.urc_scan >= offset + len) ? bc66->drv.urc_scan - len : offset;
+	}
 }
 
 //*****************************************************************************
@@ -306,13 +255,28 @@ static void _bc66_tx_buffer_flush( void )
 bc66_ret_t bc66_init(bc66_obj_t *bc66_obj)
 {
 	bc66_ret_t ret_code = bc66_ret_error;
-	if (bc66 == 0)
+	size_t i;
+	// without receive ring the bytes can only be read 
+	if ( bc66_obj && !bc66_obj->drv.init && (bc66_obj->func_r_bytes_ptr || BC66_RX_RING_SIZE) )
 	{
+		// set local object pointer
+		bc66 = bc66_obj;
+		memset(&bc66->drv,0,sizeof(bc66->drv));
+		bc66->drv.init = true;
+
 		_bc66_tx_buffer_flush();
 		_bc66_rx_buffer_flush();
+
+		// driver response patterns, per module: nothing shared between threads 
+		for( i = 0; i < bc66_rsp_list_size; i++ ) { 
+			ret_code = bc66_pattern_compile( &bc66->drv.rsp[i], bc66_rsp_src[i] );
+			assert( ret_code == bc66_ret_success );
+			if( ret_code != bc66_ret_success ) { 
+				bc66->drv.init = false;
+				return ret_code;
+			}
+		}
 		
-		// set local object pointer
-		bc66 = bc66_obj;
 		// call to uart (hal) initialize function
 		bc66->func_init_ptr();
 
@@ -338,496 +302,4758 @@ bc66_ret_t bc66_init(bc66_obj_t *bc66_obj)
 //*****************************************************************************
 /**
  * @brief 
- * Function to initialize bc66 object. 
+ * Function to release bc66 object. 
  * 
  * @param bc66_obj 
  */
 void bc66_deinit(bc66_obj_t *bc66_obj)
 {
+	bc66_obj->drv.init = false;
 	// clear local object pointer 
-	bc66 = NULL;
+	if( bc66 == bc66_obj ) {
+		bc66 = NULL;
+	}
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * Find an expected answer and remove them if from rx buffer it is found.
+ * Push received bytes to a module, i.e. from the UART ISR or the DMA half/full 
+ * transfer callback, when \p func_r_bytes_ptr is NULL. Wait-free: bytes are copied 
+ * to the module receive ring, bytes that do not fit are dropped and counted. 
+ * Only one context may feed a module; the driver reads the ring when it polls. 
+ * Needs BC66_RX_RING_SIZE (0 by default: nothing is stored). 
  * 
- * @param str	: RX responses buffer 
- * @param rsp	: extected at response or NULL
+ * @param bc66_obj	: initialized bc66 object (the selected module is not used). 
+ * @param bytes		: received bytes. 
+ * @param len		: bytes count. 
  * 
  * @return 
- * Extected AT response or NULL.
+ * Bytes stored.
  */
-static char * _bc66_at_parser(char * str, const char * rsp)
+size_t bc66_rx_feed( bc66_obj_t * bc66_obj, const uint8_t * bytes, size_t len )
 {
-	char * idx_start, * idx_stop;
+#if BC66_RX_RING_SIZE
+	uint32_t head, room, first;
 
-	if( (idx_start = strstr( str, rsp )) ) {
-		if( (idx_stop = strstr( idx_start+1, RSP_END_OF_LINE )) ) {
-			// add end of line chars 
-			idx_stop += strlen(RSP_END_OF_LINE);
-			uint16_t length = (idx_stop - idx_start);
-			
-			if( length < MAX_RSP_SIZE ) { 
-				// init response buffer 
-				memset(rsp_found,0,sizeof(rsp_found));
-				// get response - copy to new buffer
-				strncpy(rsp_found, idx_start, length );
-				// remove response from rx buffer
-				strcpy(idx_start, idx_stop );
-				// return expected response 
-				return rsp_found;
-			}
-		}
+	if( (bc66_obj == NULL) || !bc66_obj->drv.init || (bytes == NULL) ) { 
+		return 0;
 	}
-
-	return NULL;
+	head = bc66_obj->drv.ring.head;
+	room = BC66_RX_RING_SIZE - (head - bc66_obj->drv.ring.tail);
+	// room is read before writing over it 
+	BC66_RX_RING_BARRIER();
+	if( len > room ) { 
+		bc66_obj->drv.ring.dropped += (uint32_t)(len - room);
+		len = room;
+	}
+	first = BC66_RX_RING_SIZE - (head & (BC66_RX_RING_SIZE - 1));
+	if( first > len ) { 
+		first = (uint32_t)len;
+	}
+	memcpy( &bc66_obj->drv.ring.buf[head & (BC66_RX_RING_SIZE - 1)], bytes, first );
+	memcpy( bc66_obj->drv.ring.buf, bytes + first, len - first );
+	// data is visible before its index 
+	BC66_RX_RING_BARRIER();
+	bc66_obj->drv.ring.head = head + (uint32_t)len;
+	return len;
+#else
+	(void)bc66_obj;
+	(void)bytes;
+	(void)len;
+	return 0;
+#endif
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * Wait Modem response.
+ * Get the received bytes dropped by \p bc66_rx_feed(...) because the ring was full. 
  * 
- * @param rsp	: response buffer pointer 
- * @param timeout: response wait time [ms]
+ * @param dropped : bytes dropped since \p bc66_init(...). 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-static bc66_ret_t _bc66_find_at_response( const char * rsp, uint32_t timeout )
+bc66_ret_t bc66_get_rx_dropped( uint32_t * dropped )
 {
-	uint8_t rx_temp_buffer[64]; 
-	char * rsp_ptr;
-	while( timeout ) {
-		// printf("timeout: %u\n", timeout);
-		bc66->func_delay(1);
-		// get new received chars 
-		memset(rx_temp_buffer,0,sizeof(rx_temp_buffer));
-		bc66->func_r_bytes_ptr( rx_temp_buffer, sizeof(rx_temp_buffer) );
-		// add new chars to RX buffer 
-		strcat((char*)rx_buffer,(char*)rx_temp_buffer);
-		if( (rsp_ptr = _bc66_at_parser((char *)rx_buffer, rsp)) ) {
-			strcpy( (char*)rx_last_response, rsp_ptr );
-			return bc66_ret_success;
-		}
-		timeout --;
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
 	}
-
-	return bc66_ret_timeout;
+	if( dropped == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+#if BC66_RX_RING_SIZE
+	*dropped = bc66->drv.ring.dropped;
+#else
+	*dropped = 0;
+#endif
+	return bc66_ret_success;
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * Function to send at command sentence to bc66 module through an external function communication. 
+ * Select the module used by all the driver functions. 
  * 
- * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
- * @param cmd_lst 	: command to send (see command list). 
- * @param rsp 		: pointer to expected response text. 
- * @param arg_fmt 	: arguments format (like printf function) and must be sended all arguments too.
+ * @param bc66_obj : initialized bc66 object.
  * 
  * @return 
- * See \p bc66_ret_t return codes. 
+ * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_send_at_command(bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char *exp_rsp, const char * arg_fmt, ...)
+bc66_ret_t bc66_select(bc66_obj_t *bc66_obj)
 {
-	// check if object was initialized
-	if( bc66 == NULL ) { 
+	if( (bc66_obj == NULL) || !bc66_obj->drv.init ) { 
 		return bc66_ret_not_init;
 	}
-
-	// flush rx buffer to store all responses 
-	_bc66_rx_buffer_flush();
-
-	// send command AT 
-	switch( cmd_type )
-	{
-		case BC66_CMD_TEST:
-			if( bc66_cmds_list[cmd_lst].cmd_flags & TEST ) {
-				sprintf((char*)tx_buffer,"AT%s=?",bc66_cmds_list[cmd_lst].cmd);
-			}
-			break;
-
-		case BC66_CMD_READ:
-			if( bc66_cmds_list[cmd_lst].cmd_flags & READ ) {
-				sprintf((char*)tx_buffer,"AT%s?",bc66_cmds_list[cmd_lst].cmd);
-			}
-			break;
-
-		case BC66_CMD_WRITE:
-			if( bc66_cmds_list[cmd_lst].cmd_flags & WRITE ) {
-				sprintf((char*)tx_buffer,"AT%s=",bc66_cmds_list[cmd_lst].cmd);
-				if( arg_fmt ) { 
-					// declare list of arguments 
-					va_list args;
-					// initialize the list 
-					va_start ( args, arg_fmt );
-					vsprintf((char*)&tx_buffer[strlen((const char *)tx_buffer)], (const char *)arg_fmt, args);
-					// clear the list 
-					va_end(args);
-				}
-			}
-			break;
-
-		case BC66_CMD_EXE:
-			if( bc66_cmds_list[cmd_lst].cmd_flags & EXE ) {
-				sprintf((char*)tx_buffer,"AT%s",bc66_cmds_list[cmd_lst].cmd);
-				if( arg_fmt ) { 
-					// declare list of arguments 
-					va_list args;
-					// initialize the list 
-					va_start ( args, arg_fmt );
-					vsprintf((char*)&tx_buffer[strlen((const char *)tx_buffer)], (const char *)arg_fmt, args);
-					// clear the list 
-					va_end(args);
-				}
-			}
-			break;
-
-		default:	
-			return bc66_ret_no_cmd_implemented;
-			break;
-	}
-
-	// send command
-	strcat((char*)tx_buffer,CMD_END_LINE);
-	bc66->func_w_bytes_ptr((uint8_t*)tx_buffer,strlen((const char*)tx_buffer));
-
-	// check expected response - +ATCMD: ... 
-	if( exp_rsp ) {
-		return _bc66_find_at_response((const char*)exp_rsp, bc66_cmds_list[cmd_lst].rsp_timeout);
-	}
-
-	// check command response - <CR><LF>OK<CR><LF> normally
-	if( bc66_cmds_list[cmd_lst].cmd_rsp ) {
-		return _bc66_find_at_response((const char*)bc66_cmds_list[cmd_lst].cmd_rsp, bc66_cmds_list[cmd_lst].rsp_timeout);
-	}
-
+	bc66 = bc66_obj;
 	return bc66_ret_success;
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * Function to get any response stored in the RX buffer.
- * 
- * @param rsp	: response to get 
+ * Get the selected module. 
  * 
  * @return 
- * Response if found, NULL otherwise
+ * Selected bc66 object or NULL.
  */
-char * bc66_get_at_response( char * rsp )
+bc66_obj_t * bc66_selected( void )
 {
-	return _bc66_at_parser((char*)rx_buffer, (const char *)rsp);
+	return bc66;
 }
 
 //*****************************************************************************
 /**
- * @brief
- * Reset the module via Hardware PIN.
+ * @brief 
+ * Find an expected answer and remove them if from rx buffer it is found.
+ * 
+ * @param rsp	: extected at response or NULL
  * 
  * @return 
- * See \p bc66_ret_t return codes.
+ * Extected AT response or NULL.
  */
-bc66_ret_t bc66_hw_reset( void )
+static char * _bc66_at_parser(const char * rsp)
 {
-	if( bc66 ) {
-		bc66->control_lines.MDM_RESET_N(1);
-		bc66->func_delay(100);
-		bc66->control_lines.MDM_RESET_N(0);
-		bc66->func_delay(100);
+	char * idx_start, * idx_stop;
 
-		// return _bc66_find_at_response("Leaving", 5000 );
+	if( (idx_start = strstr( (char*)bc66->drv.rx_buffer, rsp )) ) {
+		if( (idx_stop = strstr( idx_start+1, RSP_END_OF_LINE )) ) {
+			// add end of line chars 
+			idx_stop += strlen(RSP_END_OF_LINE);
+			uint16_t length = (idx_stop - idx_start);
+			
+			char * rsp_found;
+			
+			// get response - copy to new buffer
+			if( (length < BC66_MAX_RSP_SIZE) && (rsp_found = _bc66_set_last_response( idx_start, length )) ) { 
+				// remove response from rx buffer
+				_bc66_rx_buffer_remove( idx_start, length );
+				// return expected response 
+				return rsp_found;
+			}
+		}
 	}
-	return bc66_ret_error;
-}
 
-//*****************************************************************************
-/**
- * @brief
- * Pull down PWRKEY to turn on the module
- */
-void bc66_power_on()
-{
-	if( bc66 ) {
-		bc66->control_lines.MDM_PWRKEY_N(1);
-		bc66->func_delay(500);
-		bc66->control_lines.MDM_PWRKEY_N(0);
-	}
+	return NULL;
 }
 
 //*****************************************************************************
 /**
- * @brief
- * Pull up PWRKEY to turn off the module
+ * @brief 
+ * Invalidate PDP addresses cache. 
  */
-void bc66_power_off()
+static void _bc66_addr_invalidate( void )
 {
-	if( bc66 ) {
-		bc66->control_lines.MDM_PWRKEY_N(0);
-	}
+	bc66->drv.pdp_addr_valid = false;
+	bc66->drv.pdp_addr_gen ++;
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * Function to get last modem response. 
- * If send a new AT command, the buffer which contain the last response will be erased.
+ * Get next comma separated field of a response line. 
+ * 
+ * @param str	: current position, moved after the field comma. 
+ * @param end	: end of line. 
+ * @param len	: field length (quotes removed). 
  * 
  * @return 
- * Pointer to RX buffer with last response. 
+ * Field start, NULL at end of line.
  */
-char * bc66_get_last_response( void )
+static const char * _bc66_next_field( const char ** str, const char * end, size_t * len )
 {
-	return (char*)rx_last_response;
+	const char * field = *str;
+	const char * stop;
+
+	if( field == NULL ) {
+		return NULL;
+	}
+	stop = memchr( field, ',', end - field );
+	*str = stop ? stop + 1 : NULL;
+	if( stop == NULL ) {
+		stop = end;
+	}
+	while( (field < stop) && ((*field == ' ') || (*field == '"')) ) {
+		field ++;
+	}
+	*len = stop - field;
+	if( *len && (field[*len - 1] == '"') ) {
+		(*len) --;
+	}
+	return field;
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * Send AT command to sync baud rate. 
+ * Parse a signed integer field, quoted or not. 
+ * 
+ * @param str	: field text. 
+ * @param end	: end of text. 
+ * @param value	: parsed value. 
  * 
  * @return 
- * See \p bc66_ret_t return codes. 
+ * Pointer after the number, NULL if there is no number.
  */
-bool bc66_send_cmd_AT( void )
+static const char * _bc66_parse_int( const char * str, const char * end, int32_t * value )
 {
-	return bc66_send_at_command( BC66_CMD_EXE,bc66_cmd_list_AT,NULL,NULL);
+	bool neg = false;
+	bool digits = false;
+	int32_t v = 0;
+
+	while( (str < end) && ((*str == ' ') || (*str == '"')) ) {
+		str ++;
+	}
+	if( (str < end) && ((*str == '+') || (*str == '-')) ) {
+		neg = (*str == '-');
+		str ++;
+	}
+	while( (str < end) && (*str >= '0') && (*str <= '9') && (v < 100000) ) {
+		v = v * 10 + (*str - '0');
+		digits = true;
+		str ++;
+	}
+	*value = neg ? -v : v;
+	return digits ? str : NULL;
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * Set Command Echo Mode. 
- * 
- * This Execution Command determines whether or not the UE echoes characters 
- * received from external MCU during command state. 
+ * Compile a response pattern. Call it once and keep the pattern: each match is 
+ * then a single pass over the line that also captures the fields. 
+ * - text: literal, matched from the line start 
+ * - %d: signed integer field 
+ * - %q: quoted string field 
+ * - (a|b|c): alternative literals, the first that matches; its index is the field value 
+ * - [...]: optional tail, at the end of the pattern: it may be missing at the end of the line 
+ * - %%, %(, %), %|, %[, %]: the char itself 
  * 
- * The command takes effect immediately. Remain valid after deep-sleep wakeup. 
- * The configuration will be saved to NVRAM (should execute AT&W after this command is issued).
+ * i.e. "+QMTCONN: 0,%d[,%d]" or "+CPIN: (READY|SIM PIN|SIM PUK)". 
  * 
- * @param echo 
- * - false: Echo mode OFF
- * - true: Echo mode ON
+ * @param pat	: compiled pattern. 
+ * @param src	: pattern source, must outlive \p pat (i.e. a string literal). 
  * 
  * @return 
- * See \p bc66_ret_t return codes.
+ * bc66_ret_out_of_range if the pattern is wrong or too long, see \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_set_echo_mode( bool echo )
+bc66_ret_t bc66_pattern_compile( bc66_pattern_t * pat, const char * src )
+{
+	static const char specials[] = "%()|[]";
+	size_t i = 0, n = 0;
+	uint8_t fields = 0;
+	bool opt = false, opt_end = false;
+
+	if( (pat == NULL) || (src == NULL) ) { 
+		return bc66_ret_out_of_range;
+	}
+	memset( pat, 0, sizeof(*pat) );
+
+	while( src[i] ) { 
+		bc66_pat_elem_t * elem = &pat->elem[n];
+
+		// keep room for the end element, nothing after the optional tail 
+		if( (n >= BC66_PATTERN_MAX_ELEMS - 1) || opt_end || (i > UINT16_MAX) ) { 
+			return bc66_ret_out_of_range;
+		}
+		switch( src[i] ) 
+		{
+			case '%':
+				if( (src[i + 1] == 'd') || (src[i + 1] == 'q') ) { 
+					elem->op = (src[i + 1] == 'd') ? bc66_pat_int : bc66_pat_quoted;
+					fields ++;
+				} else if( src[i + 1] && strchr( specials, src[i + 1] ) ) { 
+					elem->op = bc66_pat_lit;
+					elem->pos = (uint16_t)(i + 1);
+					elem->len = 1;
+				} else { 
+					return bc66_ret_out_of_range;
+				}
+				i += 2;
+				break;
+
+			case '(':
+				elem->op = bc66_pat_alt;
+				elem->pos = (uint16_t)++i;
+				elem->count = 1;
+				for( ; src[i] != ')'; i++ ) { 
+					if( (src[i] == '\0') || ((src[i] != '|') && strchr( specials, src[i] )) ) { 
+						return bc66_ret_out_of_range;
+					}
+					if( src[i] == '|' ) { 
+						elem->count ++;
+					}
+				}
+				elem->len = (uint16_t)(i++ - elem->pos);
+				fields ++;
+				break;
+
+			case '[':
+				if( opt ) { 
+					return bc66_ret_out_of_range;
+				}
+				elem->op = bc66_pat_opt;
+				opt = true;
+				i ++;
+				break;
+
+			case ']':
+				if( !opt ) { 
+					return bc66_ret_out_of_range;
+				}
+				opt_end = true;
+				i ++;
+				continue;
+
+			case ')':
+			case '|':
+				return bc66_ret_out_of_range;
+
+			default:
+				elem->op = bc66_pat_lit;
+				elem->pos = (uint16_t)i;
+				while( src[i] && !strchr( specials, src[i] ) ) { 
+					i ++;
+				}
+				elem->len = (uint16_t)(i - elem->pos);
+				break;
+		}
+		n ++;
+	}
+
+	if( (fields > BC66_PATTERN_MAX_FIELDS) || (opt && !opt_end) ) { 
+		return bc66_ret_out_of_range;
+	}
+	pat->elem[n].op = bc66_pat_end;
+	pat->src = src;
+	pat->fields = fields;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Match a line against a compiled pattern. Text after the pattern is ignored. 
+ * 
+ * @param pat	: compiled pattern. 
+ * @param line	: line, without <CR><LF>. 
+ * @param len	: line length. 
+ * @param match	: fields captured, they point into \p line. 
+ * 
+ * @return 
+ * true if the line matches.
+ */
+bool bc66_pattern_match( const bc66_pattern_t * pat, const char * line, size_t len, bc66_match_t * match )
+{
+	const bc66_pat_elem_t * elem;
+	const char * end = line + len;
+	const char * pos = line;
+	const char * next;
+	bool opt = false;
+
+	if( (pat == NULL) || (pat->src == NULL) || (line == NULL) || (match == NULL) ) { 
+		return false;
+	}
+	match->count = 0;
+
+	for( elem = pat->elem; elem->op != bc66_pat_end; elem++ ) { 
+		const char * text = &pat->src[elem->pos];
+
+		if( elem->op == bc66_pat_opt ) { 
+			opt = true;
+			continue;
+		}
+		// optional tail missing 
+		if( opt && (pos == end) ) { 
+			break;
+		}
+		switch( elem->op ) 
+		{
+			case bc66_pat_lit:
+				if( ((size_t)(end - pos) < elem->len) || memcmp( pos, text, elem->len ) ) { 
+					return false;
+				}
+				pos += elem->len;
+				break;
+
+			case bc66_pat_int:
+				if( (next = _bc66_parse_int( pos, end, &match->field[match->count].num )) == NULL ) { 
+					return false;
+				}
+				match->field[match->count].str = pos;
+				match->field[match->count++].len = (uint16_t)(next - pos);
+				pos = next;
+				break;
+
+			case bc66_pat_quoted:
+				if( (pos == end) || (*pos != '"') || ((next = memchr( pos + 1, '"', end - pos - 1 )) == NULL) ) { 
+					return false;
+				}
+				match->field[match->count].str = pos + 1;
+				match->field[match->count].len = (uint16_t)(next - pos - 1);
+				match->field[match->count++].num = 0;
+				pos = next + 1;
+				break;
+
+			case bc66_pat_alt:
+			{
+				const char * alt_end = text + elem->len;
+				int32_t index = 0;
+
+				for( ;; index++ ) { 
+					const char * bar = memchr( text, '|', alt_end - text );
+					size_t alt_len = (bar ? bar : alt_end) - text;
+
+					if( ((size_t)(end - pos) >= alt_len) && !memcmp( pos, text, alt_len ) ) { 
+						match->field[match->count].str = pos;
+						match->field[match->count].len = (uint16_t)alt_len;
+						match->field[match->count++].num = index;
+						pos += alt_len;
+						break;
+					}
+					if( bar == NULL ) { 
+						return false;
+					}
+					text = bar + 1;
+				}
+				break;
+			}
+
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Find the first response line that starts with \p lead and matches a pattern, 
+ * capturing its fields, and remove it from RX buffer. It is stored as last response. 
+ * 
+ * @param pat	: compiled pattern. 
+ * @param lead	: line start, i.e. "+QMTPUB: 0,<msgID>," to tell MQTT packets apart. 
+ * @param match	: fields captured, they point into the last response. 
+ * 
+ * @return 
+ * Last response or NULL if no line matches.
+ */
+static char * _bc66_pattern_parser( const bc66_pattern_t * pat, const char * lead, bc66_match_t * match )
+{
+	char * line = (char*)bc66->drv.rx_buffer;
+	char * eol;
+
+	while( (eol = strstr( line, RSP_END_OF_LINE )) ) { 
+		size_t len = eol + strlen(RSP_END_OF_LINE) - line;
+
+		if( (eol > line) && !strncmp( line, lead, strlen(lead) ) && bc66_pattern_match( pat, line, eol - line, match ) ) { 
+			char * rsp_found;
+			uint8_t i;
+
+			if( (len >= BC66_MAX_RSP_SIZE) || ((rsp_found = _bc66_set_last_response( line, len )) == NULL) ) { 
+				return NULL;
+			}
+			// captured fields follow the line copy 
+			for( i = 0; i < match->count; i++ ) { 
+				match->field[i].str = rsp_found + (match->field[i].str - line);
+			}
+			_bc66_rx_buffer_remove( line, len );
+			return rsp_found;
+		}
+		line = eol + strlen(RSP_END_OF_LINE);
+	}
+	return NULL;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Parse network time "yy/MM/dd,hh:mm:ss[±zz]" (4 digits year and "GMT±h" zone are 
+ * also accepted). 
+ * 
+ * @param str	: time text, quoted or not. 
+ * @param end	: end of text. 
+ * @param utc	: seconds since 1970 of the time fields. 
+ * @param tz	: time zone in quarters of an hour, not changed if the zone is missing. 
+ * 
+ * @return 
+ * true if the time is valid.
+ */
+static bool _bc66_parse_clock( const char * str, const char * end, uint32_t * utc, int8_t * tz )
+{
+	int32_t f[6];
+	uint8_t i;
+	int32_t y, m, days;
+
+	for( i = 0; i < 6; i++ ) {
+		if( i && ((str >= end) || ((*str != '/') && (*str != ',') && (*str != ':'))) ) {
+			return false;
+		}
+		if( i ) {
+			str ++;
+		}
+		if( ((str = _bc66_parse_int( str, end, &f[i] )) == NULL) || (f[i] < 0) ) {
+			return false;
+		}
+	}
+	if( f[0] < 100 ) {
+		f[0] += 2000;
+	}
+	if( (f[0] < 1970) || (f[0] > 2105) || (f[1] < 1) || (f[1] > 12) || (f[2] < 1) || (f[2] > 31) || 
+		(f[3] > 23) || (f[4] > 59) || (f[5] > 60) ) {
+		return false;
+	}
+
+	// days since 1970 (civil calendar, March based year) 
+	y = f[0] - (f[1] <= 2);
+	m = f[1] + ((f[1] > 2) ? -3 : 9);
+	days = (y / 400) * 146097 + (y % 400) * 365 + (y % 400) / 4 - (y % 400) / 100 + (153 * m + 2) / 5 + f[2] - 1 - 719468;
+	*utc = (uint32_t)days * 86400 + f[3] * 3600 + f[4] * 60 + f[5];
+
+	// time zone: ±zz quarters or GMT±h 
+	if( (end - str >= 3) && !strncmp( str, "GMT", 3 ) ) {
+		int32_t h;
+		if( _bc66_parse_int( str + 3, end, &h ) && (h >= -12) && (h <= 14) ) {
+			*tz = (int8_t)(h * 4);
+		}
+	} else if( (str < end) && ((*str == '+') || (*str == '-')) ) {
+		int32_t q;
+		if( _bc66_parse_int( str, end, &q ) && (q >= -48) && (q <= 56) ) {
+			*tz = (int8_t)q;
+		}
+	}
+	return true;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Store network time against current tick. 
+ * 
+ * @param utc	: UTC time [s since 1970]. 
+ */
+static void _bc66_time_set( uint32_t utc )
+{
+	if( bc66->func_get_tick == NULL ) { 
+		return;
+	}
+	bc66->drv.time.utc = utc;
+	bc66->drv.time.tick = bc66->func_get_tick();
+	bc66->drv.time.valid = true;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Time zone URCs: +CTZV: <tz>, +CTZE: <tz>,<dst>,<time> and +CTZEU: <tz>,<dst>,<utime>. 
+ * 
+ * @param line	: URC line without <CR><LF> 
+ * @param len	: line length 
+ */
+static void _bc66_urc_time_zone( const char * line, size_t len )
+{
+	const char * end = line + len;
+	const char * field = memchr( line, ':', len );
+	int32_t tz;
+	uint32_t utc;
+	int8_t utc_tz;
+
+	if( (field == NULL) || (_bc66_parse_int( field + 1, end, &tz ) == NULL) || (tz < -48) || (tz > 56) ) { 
+		return;
+	}
+	bc66->drv.time.tz = (int8_t)tz;
+	bc66->drv.time.tz_valid = true;
+
+	// UTC time after <dst> 
+	if( !strncmp( line, "+CTZEU:", 7 ) && (field = memchr( field, ',', end - field )) && 
+		(field = memchr( field + 1, ',', end - field - 1 )) && _bc66_parse_clock( field + 1, end, &utc, &utc_tz ) ) { 
+		_bc66_time_set( utc );
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get <stat> of a +CEREG line: URC +CEREG: <stat>[,<tac>,...] or read response 
+ * +CEREG: <n>,<stat>[,...] (second field is a number only in the read response). 
+ * 
+ * @param line	: line without <CR><LF> 
+ * @param len	: line length 
+ * @param stat	: registration status. 
+ * 
+ * @return 
+ * true if the status was found.
+ */
+static bool _bc66_cereg_stat( const char * line, size_t len, uint8_t * stat )
+{
+	const char * end = line + len;
+	const char * pos = memchr( line, ':', len );
+	const char * field;
+	int32_t value[2];
+	size_t flen;
+
+	if( pos == NULL ) {
+		return false;
+	}
+	pos ++;
+	if( ((field = _bc66_next_field( &pos, end, &flen )) == NULL) || !flen || !_bc66_parse_int( field, field + flen, &value[0] ) ) {
+		return false;
+	}
+	*stat = (uint8_t)value[0];
+	// read response: <n>,<stat> 
+	if( ((field = _bc66_next_field( &pos, end, &flen )) != NULL) && flen && (field[-1] != '"') && 
+		(_bc66_parse_int( field, field + flen, &value[1] ) == field + flen) ) {
+		*stat = (uint8_t)value[1];
+	}
+	return true;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * +CEREG: registration status changed, addresses may have changed. 
+ * 
+ * @param line	: URC line without <CR><LF> 
+ * @param len	: line length 
+ */
+static void _bc66_urc_cereg( const char * line, size_t len )
+{
+	uint8_t stat;
+
+	if( !_bc66_cereg_stat( line, len, &stat ) || (stat == bc66->drv.reg_stat) ) { 
+		return;
+	}
+	bc66->drv.reg_stat = stat;
+	if( (stat != 1) && (stat != 5) ) { 
+		bc66->drv.attach.pdp_active = false;
+		bc66->drv.attach.ip = false;
+	}
+	_bc66_addr_invalidate();
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * +CPIN: <code>, READY when the SIM needs no password. Updates the SIM cache. 
+ * 
+ * @param line	: URC line without <CR><LF> 
+ * @param len	: line length 
+ */
+static void _bc66_urc_cpin( const char * line, size_t len )
+{
+	bool ready = (len >= 12) && !strncmp( line + 7, "READY", 5 );
+
+	// SIM removed, locked or changed: identity must be read again 
+	if( !ready || (bc66->drv.sim.known && !bc66->drv.sim.ready) ) { 
+		bc66->drv.sim.imsi_valid = false;
+		bc66->drv.sim.iccid_valid = false;
+	}
+	bc66->drv.sim.known = true;
+	bc66->drv.sim.ready = ready;
+	// SIM ready after the firmware update restart: the module answers again 
+	if( ready && bc66->drv.fota.active && (bc66->drv.fota.state.phase == bc66_fota_verify) ) { 
+		bc66->drv.fota.probe = true;
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * +CGACT: <cid>,<state> of the attach PDP context. 
+ * 
+ * @param line	: URC line without <CR><LF> 
+ * @param len	: line length 
+ */
+static void _bc66_urc_cgact( const char * line, size_t len )
+{
+	const char * end = line + len;
+	const char * pos = line + 7;
+	const char * field;
+	int32_t value[2];
+	size_t flen;
+
+	if( ((field = _bc66_next_field( &pos, end, &flen )) != NULL) && _bc66_parse_int( field, field + flen, &value[0] ) && 
+		((field = _bc66_next_field( &pos, end, &flen )) != NULL) && _bc66_parse_int( field, field + flen, &value[1] ) && 
+		(value[0] == bc66->drv.attach.cfg.cid) ) { 
+		bc66->drv.attach.pdp_active = (value[1] == 1);
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * +CGEV: <event>: PDN activation or deactivation, addresses may have changed. 
+ * 
+ * @param line	: URC line without <CR><LF> 
+ * @param len	: line length 
+ */
+static void _bc66_urc_cgev( const char * line, size_t len )
+{
+	const char act[] = "PDN ACT";
+	const char deact[] = "PDN DEACT";
+	size_t i;
+
+	for( i = 6; i + sizeof(act) - 1 <= len; i++ ) { 
+		if( !strncmp( &line[i], act, sizeof(act) - 1 ) ) { 
+			bc66->drv.attach.pdp_active = true;
+			break;
+		}
+		if( (i + sizeof(deact) - 1 <= len) && !strncmp( &line[i], deact, sizeof(deact) - 1 ) ) { 
+			bc66->drv.attach.pdp_active = false;
+			bc66->drv.attach.ip = false;
+			break;
+		}
+	}
+	_bc66_addr_invalidate();
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * +IP: <IP_address>: the module got an address. 
+ * 
+ * @param line	: URC line without <CR><LF> 
+ * @param len	: line length 
+ */
+static void _bc66_urc_ip( const char * line, size_t len )
+{
+	(void)line;
+	(void)len;
+	bc66->drv.attach.ip = true;
+	_bc66_addr_invalidate();
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * +QMTSTAT: <TCP_connectID>,<err_code>: the MQTT connection was closed. 
+ * 
+ * @param line	: URC line without <CR><LF> 
+ * @param len	: line length 
+ */
+static void _bc66_urc_qmtstat( const char * line, size_t len )
+{
+	(void)line;
+	(void)len;
+	bc66->drv.mqtt_session ++;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * +CGPADDR: <cid>[,<PDP_addr>]: the attach PDP context has an address. 
+ * 
+ * @param line	: line without <CR><LF> 
+ * @param len	: line length 
+ */
+static void _bc66_urc_cgpaddr( const char * line, size_t len )
+{
+	const char * end = line + len;
+	const char * pos = line + 9;
+	const char * field;
+	int32_t cid;
+	size_t flen;
+
+	if( ((field = _bc66_next_field( &pos, end, &flen )) != NULL) && _bc66_parse_int( field, field + flen, &cid ) && 
+		(cid == bc66->drv.attach.cfg.cid) && ((field = _bc66_next_field( &pos, end, &flen )) != NULL) && flen ) { 
+		bc66->drv.attach.ip = true;
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Add the time since last update to the running firmware update phase. 
+ */
+static void _bc66_fota_account( void )
+{
+	uint32_t now = bc66->func_get_tick();
+	bc66_fota_state_t * st = &bc66->drv.fota.state;
+
+	if( st->phase < bc66_fota_done ) { 
+		st->phase_time[st->phase] += (uint32_t)(now - bc66->drv.fota.tick);
+	}
+	bc66->drv.fota.tick = now;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Move the firmware update to a new phase. The state is saved on next poll. 
+ * 
+ * @param phase	: new phase. 
+ * @param err	: module error code, for bc66_fota_failed. 
+ */
+static void _bc66_fota_set_phase( bc66_fota_phase_t phase, int16_t err )
+{
+	_bc66_fota_account();
+	bc66->drv.fota.state.phase = phase;
+	bc66->drv.fota.state.progress = 0;
+	bc66->drv.fota.state.err = err;
+	bc66->drv.fota.dirty = true;
+	if( phase == bc66_fota_verify ) { 
+		// the revision is queried when the module reports its boot 
+		bc66->drv.fota.verify_start = bc66->drv.fota.tick;
+		bc66->drv.fota.probe = false;
+		bc66->drv.fota.late_probe = false;
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * +QIND: "FOTA",<event>[,<value>]: firmware update progress. A failed download is 
+ * requested again up to BC66_FOTA_MAX_ATTEMPTS times. Any event shows that a 
+ * resumed download is still running in the module. 
+ * 
+ * @param line	: URC line without <CR><LF> 
+ * @param len	: line length 
+ */
+static void _bc66_urc_qind( const char * line, size_t len )
+{
+	const char * end = line + len;
+	const char * pos = line + 6;
+	const char * field;
+	const char * event;
+	size_t flen;
+	size_t elen;
+	int32_t value = 0;
+
+	if( !bc66->drv.fota.active || ((field = _bc66_next_field( &pos, end, &flen )) == NULL) || 
+		(flen != 4) || strncmp( field, "FOTA", 4 ) || ((event = _bc66_next_field( &pos, end, &elen )) == NULL) ) { 
+		return;
+	}
+	if( (field = _bc66_next_field( &pos, end, &flen )) != NULL ) { 
+		// percent may end with '%' 
+		_bc66_parse_int( field, field + flen, &value );
+	}
+	bc66->drv.fota.last_urc = bc66->func_get_tick();
+	if( bc66->drv.fota.wait_quiet ) { 
+		bc66->drv.fota.wait_quiet = false;
+		bc66->drv.fota.retry = false;
+	}
+
+	if( (elen == 9) && !strncmp( event, "HTTPSTART", 9 ) ) { 
+		if( bc66->drv.fota.state.phase != bc66_fota_download ) { 
+			_bc66_fota_set_phase( bc66_fota_download, 0 );
+		}
+	} else if( ((elen == 11) && !strncmp( event, "DOWNLOADING", 11 )) || ((elen == 8) && !strncmp( event, "UPDATING", 8 )) ) { 
+		if( (value >= 0) && (value <= 100) ) { 
+			bc66->drv.fota.state.progress = (uint8_t)value;
+		}
+	} else if( (elen == 7) && !strncmp( event, "HTTPEND", 7 ) ) { 
+		if( value == 0 ) { 
+			bc66->drv.fota.state.progress = 100;
+		} else if( bc66->drv.fota.state.attempts < BC66_FOTA_MAX_ATTEMPTS ) { 
+			bc66->drv.fota.retry = true;
+		} else { 
+			_bc66_fota_set_phase( bc66_fota_failed, (int16_t)value );
+		}
+	} else if( (elen == 5) && !strncmp( event, "START", 5 ) ) { 
+		_bc66_fota_set_phase( bc66_fota_update, 0 );
+	} else if( (elen == 3) && !strncmp( event, "END", 3 ) ) { 
+		_bc66_fota_set_phase( value ? bc66_fota_failed : bc66_fota_verify, (int16_t)value );
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * RDY: the module (re)started. Answers of commands sent before are lost, so no 
+ * late answer is waited; after a firmware update the new revision is queried. 
+ * 
+ * @param line	: URC line without <CR><LF> 
+ * @param len	: line length 
+ */
+static void _bc66_urc_rdy( const char * line, size_t len )
+{
+	(void)line;
+	(void)len;
+
+	bc66->drv.stale.frc = false;
+	bc66->drv.stale.prompt = false;
+	bc66->drv.stale.exp[0] = '\0';
+	if( bc66->drv.fota.active && (bc66->drv.fota.state.phase == bc66_fota_verify) ) { 
+		bc66->drv.fota.probe = true;
+	}
+}
+
+//*****************************************************************************
+/// URC handler: called with each received URC line (without <CR><LF>). 
+typedef void (*bc66_urc_handler_t)( const char * line, size_t len );
+
+/// BC66 URC struct 
+typedef const struct
+{
+	const char 			*urc;		///< URC prefix
+	bc66_urc_handler_t 	handler;	///< URC handler
+} bc66_urc_t;
+
+/// URCs handled by the driver. 
+static const bc66_urc_t bc66_urc_list[] = {
+	{ "+CEREG:",	_bc66_urc_cereg },
+	{ "+IP:",		_bc66_urc_ip },
+	{ "+CGEV:",		_bc66_urc_cgev },
+	{ "+CPIN:",		_bc66_urc_cpin },
+	{ "+CGACT:",	_bc66_urc_cgact },
+	{ "+CGPADDR:",	_bc66_urc_cgpaddr },
+	{ "+CTZV:",		_bc66_urc_time_zone },
+	{ "+CTZE:",		_bc66_urc_time_zone },
+	{ "+CTZEU:",	_bc66_urc_time_zone },
+	{ "+QIND:",		_bc66_urc_qind },
+	{ "RDY",		_bc66_urc_rdy },
+	{ "+QMTSTAT:",	_bc66_urc_qmtstat },
+};
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Find the driver handler of a URC line. 
+ * 
+ * @param line	: line without <CR><LF> 
+ * @param len	: line length 
+ * 
+ * @return 
+ * URC handler or NULL if the driver does not handle the line.
+ */
+static bc66_urc_handler_t _bc66_urc_handler( const char * line, size_t len )
+{
+	size_t i;
+
+	for( i = 0; i < sizeof(bc66_urc_list) / sizeof(bc66_urc_list[0]); i++ ) {
+		size_t urc_len = strlen( bc66_urc_list[i].urc );
+		if( (len >= urc_len) && !strncmp( line, bc66_urc_list[i].urc, urc_len ) ) {
+			return bc66_urc_list[i].handler;
+		}
+	}
+	return NULL;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Dispatch URCs in the complete lines received since last scan. Lines are not 
+ * removed: a solicited response with the same prefix is still found by its command. 
+ */
+static void _bc66_urc_scan( void )
+{
+	char * line = (char*)&bc66->drv.rx_buffer[bc66->drv.urc_scan];
+	char * eol;
+	bc66_urc_handler_t handler;
+
+	while( (eol = strstr( line, RSP_END_OF_LINE )) ) {
+		size_t len = eol - line;
+		// the answer of the running command goes first 
+		if( bc66->drv.stale.exp[0] && !strncmp( line, bc66->drv.stale.exp, strlen( bc66->drv.stale.exp ) ) && 
+			!(bc66->drv.cmd.busy && bc66->drv.cmd.exp_rsp[0] && !strncmp( line, bc66->drv.cmd.exp_rsp, strlen( bc66->drv.cmd.exp_rsp ) )) ) { 
+			// answers come in order: the first one is the late answer of the stale command 
+			bool expired = bc66->func_get_tick && ((int32_t)(bc66->func_get_tick() - bc66->drv.stale.until) >= 0);
+			bc66->drv.stale.exp[0] = '\0';
+			if( !expired ) { 
+				bc66->drv.result.late_answers ++;
+				_bc66_rx_buffer_remove( line, len + strlen(RSP_END_OF_LINE) );
+				continue;
+			}
+		}
+		if( (handler = _bc66_urc_handler( line, len )) ) {
+			handler( line, len );
+		}
+		line = eol + strlen(RSP_END_OF_LINE);
+	}
+	bc66->drv.urc_scan = line - (char*)bc66->drv.rx_buffer;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Drop the echo of the command line from new received chars, in place. Echo chars 
+ * are compared with TX buffer as they come and are not stored: a match can only 
+ * start at a line start, and if it breaks before the end of the command text the 
+ * chars taken are given back from TX buffer. 
+ * 
+ * @param buf	: new chars, at the end of RX buffer. 
+ * @param len	: new chars count. 
+ * 
+ * @return 
+ * New chars count without the echo.
+ */
+static size_t _bc66_echo_strip( uint8_t * buf, size_t len )
+{
+	const uint8_t * tx = bc66->drv.tx_buffer;
+	size_t text = bc66->drv.tx_len - strlen(CMD_END_LINE);
+	size_t r, w = 0;
+
+	for( r = 0; (r < len) && bc66->drv.echo.armed; r++ ) { 
+		size_t pos = bc66->drv.echo.pos;
+		uint8_t prev = w ? buf[w - 1] : (bc66->drv.rx_len ? buf[-1] : '\n');
+
+		if( (buf[r] == tx[pos]) && (pos || (prev == '\n')) ) { 
+			if( ++bc66->drv.echo.pos == bc66->drv.tx_len ) { 
+				bc66->drv.echo.armed = false;
+			}
+			continue;
+		}
+		if( pos >= text ) { 
+			// command text echoed, end of line chars differ 
+			bc66->drv.echo.armed = false;
+		} else if( pos ) { 
+			// not the echo: the room for these chars was kept by _bc66_rx_read() 
+			memmove( &buf[w + pos], &buf[r], len - r );
+			memcpy( &buf[w], tx, pos );
+			len = w + pos + (len - r);
+			r = w + pos;
+			w = r;
+			bc66->drv.echo.pos = 0;
+		}
+		buf[w++] = buf[r];
+	}
+
+	// echo done: keep the rest 
+	if( w < r ) { 
+		memmove( &buf[w], &buf[r], len - r );
+	}
+	return w + (len - r);
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Take received bytes from the ring filled by \p bc66_rx_feed(...). 
+ * 
+ * @param dst	: destination. 
+ * @param size	: max bytes. 
+ * 
+ * @return 
+ * Bytes taken.
+ */
+static int _bc66_ring_read( uint8_t * dst, uint16_t size )
+{
+#if BC66_RX_RING_SIZE
+	uint32_t tail = bc66->drv.ring.tail;
+	uint32_t len = bc66->drv.ring.head - tail;
+	uint32_t first;
+
+	// ring data is read after its index 
+	BC66_RX_RING_BARRIER();
+	if( len > size ) { 
+		len = size;
+	}
+	first = BC66_RX_RING_SIZE - (tail & (BC66_RX_RING_SIZE - 1));
+	if( first > len ) { 
+		first = len;
+	}
+	memcpy( dst, &bc66->drv.ring.buf[tail & (BC66_RX_RING_SIZE - 1)], first );
+	memcpy( dst + first, bc66->drv.ring.buf, len - first );
+	// room is given back once the data was copied 
+	BC66_RX_RING_BARRIER();
+	bc66->drv.ring.tail = tail + len;
+	return (int)len;
+#else
+	(void)dst;
+	(void)size;
+	return 0;
+#endif
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Room left in RX buffer for new received chars, without the string terminator 
+ * and the echo chars taken (they can be given back). RX buffer is full at 0. 
+ * 
+ * @return 
+ * Free chars.
+ */
+static size_t _bc66_rx_room( void )
+{
+	return sizeof(bc66->drv.rx_buffer) - 1 - bc66->drv.rx_len - bc66->drv.echo.pos;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Read new received chars from UART straight to the end of RX buffer. 
+ * 
+ * @return 
+ * Number of chars received, without the command echo.
+ */
+static size_t _bc66_rx_read( void )
+{
+	size_t room = _bc66_rx_room();
+	uint16_t size = (room < BC66_RX_CHUNK_SIZE) ? (uint16_t)room : BC66_RX_CHUNK_SIZE;
+	int len = bc66->func_r_bytes_ptr ? bc66->func_r_bytes_ptr( &bc66->drv.rx_buffer[bc66->drv.rx_len], size ) : 
+									   _bc66_ring_read( &bc66->drv.rx_buffer[bc66->drv.rx_len], size );
+
+	if( len <= 0 ) {
+		return 0;
+	}
+	bc66->drv.health.last_rx = bc66->func_get_tick ? bc66->func_get_tick() : 0;
+	if( bc66->drv.echo.armed && ((len = (int)_bc66_echo_strip( &bc66->drv.rx_buffer[bc66->drv.rx_len], len )) == 0) ) { 
+		return 0;
+	}
+	bc66->drv.rx_len += len;
+	bc66->drv.rx_buffer[bc66->drv.rx_len] = '\0';
+	_bc66_urc_scan();
+	return len;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Read received chars while no command is running. Empty lines and URCs handled 
+ * by the driver are dropped, other lines go to the URC callback or, without it, 
+ * stay in RX buffer for \p bc66_get_at_response(...). 
+ */
+static void _bc66_rx_idle( void )
+{
+	char * line = (char*)bc66->drv.rx_buffer;
+	char * eol;
+
+	_bc66_rx_read();
+	while( (line < (char*)&bc66->drv.rx_buffer[bc66->drv.urc_scan]) && (eol = strstr( line, RSP_END_OF_LINE )) ) { 
+		size_t len = eol - line;
+		bool keep = len && !_bc66_urc_handler( line, len );
+		if( keep && bc66->drv.urc_cb ) { 
+			// callback may select other module 
+			bc66_obj_t * self = bc66;
+			bc66->drv.urc_cb( line, (uint16_t)len, false, bc66->drv.urc_arg );
+			bc66 = self;
+			keep = false;
+		}
+		if( keep ) { 
+			line = eol + strlen(RSP_END_OF_LINE);
+		} else { 
+			_bc66_rx_buffer_remove( line, len + strlen(RSP_END_OF_LINE) );
+		}
+	}
+	// full: make room dropping the oldest line kept, or garbage without end of line 
+	if( _bc66_rx_room() == 0 ) { 
+		if( (eol = strstr( (char*)bc66->drv.rx_buffer, RSP_END_OF_LINE )) ) { 
+			_bc66_rx_buffer_remove( (char*)bc66->drv.rx_buffer, eol + strlen(RSP_END_OF_LINE) - (char*)bc66->drv.rx_buffer );
+		} else { 
+			_bc66_rx_buffer_flush();
+		}
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get <result> of a MQTT packet from the fields of its response pattern: 
+ * +QMTxxx: <TCP_connectID>,<msgID>,<result>[,<value>] 
+ * 
+ * @param match	: fields captured: <msgID>, <result>[, <value>]. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+static bc66_ret_t _bc66_mqtt_result( const bc66_match_t * match )
+{
+	bc66_ret_t ret_code = bc66_ret_error;
+
+	if( match->count >= 2 ) { 
+		switch( match->field[1].num ) 
+		{
+			case 0:
+				// Sent packet successfully and received ACK from server
+				ret_code = bc66_ret_success;
+				break;
+			case 1:
+				// Packet retransmission, <value> is the retransmission count 
+				if( match->count > 2 ) { 
+					bc66->drv.result.retransmissions = (uint8_t)match->field[2].num;
+				}
+				ret_code = bc66_ret_packet_retransmission;
+				break;
+			case 2:
+				// Failed to send packet 
+				ret_code = bc66_ret_packet_fail;
+				break;
+		}
+	}
+	// packet result is the command result 
+	bc66->drv.result.status = ret_code;
+	return ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Find an error final result code (ERROR, +CME ERROR, +CMS ERROR) in RX buffer. 
+ * It is stored as last response. 
+ * 
+ * @return 
+ * true if the command failed.
+ */
+static bool _bc66_at_error( void )
+{
+	static const char * const errors[] = { FRC_CME_ERROR, FRC_CMS_ERROR, RSP_ERROR };
+	size_t i;
+
+	for( i = 0; i < sizeof(errors) / sizeof(errors[0]); i++ ) {
+		if( _bc66_at_parser( errors[i] ) ) { 
+			return true;
+		}
+	}
+	return false;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check if a response line is a final result code. 
+ * 
+ * @param line	: response line without <CR><LF> 
+ * @param len	: line length 
+ * 
+ * @return 
+ * bc66_ret_success for OK, bc66_ret_error for ERROR/+CME ERROR/+CMS ERROR, 
+ * bc66_ret_timeout if it is not a final result code.
+ */
+static bc66_ret_t _bc66_final_result_code( const char * line, size_t len )
+{
+	if( (len == strlen(FRC_OK)) && !strncmp(line, FRC_OK, len) ) {
+		return bc66_ret_success;
+	}
+	if( ((len == strlen(FRC_ERROR)) && !strncmp(line, FRC_ERROR, len)) || 
+		!strncmp(line, FRC_CME_ERROR, strlen(FRC_CME_ERROR)) || 
+		!strncmp(line, FRC_CMS_ERROR, strlen(FRC_CMS_ERROR)) ) {
+		return bc66_ret_error;
+	}
+	return bc66_ret_timeout;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check if a response identifies its command: MQTT answers "+QMT<cmd>: <connectID>,<msgID>," 
+ * with a packet identifier. Other answers, and QoS 0 publishes (msgID 0), have the 
+ * same text for every command. 
+ * 
+ * @param rsp : expected response text. 
+ * 
+ * @return 
+ * true if no answer of another command can start with \p rsp.
+ */
+static bool _bc66_rsp_unique( const char * rsp )
+{
+	const char * pos = strchr( rsp, ',' );
+	int32_t msg_id;
+
+	return !strncmp( rsp, "+QMT", 4 ) && pos && _bc66_parse_int( pos + 1, pos + strlen(pos), &msg_id ) && (msg_id > 0);
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Remember the command that just timed out or was cancelled: its late final 
+ * result code is drained by the resync before the next command, and its late 
+ * answer line (if it is not the final result code and identifies the command) 
+ * is dropped when it arrives. 
+ * 
+ * @param ret_code	: command return code. 
+ */
+static void _bc66_stale_mark( bc66_ret_t ret_code )
+{
+	const char * line = (const char *)bc66->drv.rx_buffer;
+	const char * eol;
+	bool frc = false;
+
+	if( (ret_code != bc66_ret_timeout) && (ret_code != bc66_ret_cancelled) ) { 
+		return;
+	}
+	// final result code already received: only a response after OK may be late 
+	while( (eol = strstr( line, RSP_END_OF_LINE )) ) { 
+		if( _bc66_final_result_code( line, eol - line ) != bc66_ret_timeout ) { 
+			frc = true;
+		}
+		line = eol + strlen(RSP_END_OF_LINE);
+	}
+
+	bc66->drv.stale.seq = bc66->drv.result.seq;
+	bc66->drv.stale.cmd = bc66->drv.result.cmd;
+	bc66->drv.stale.frc = !frc;
+	bc66->drv.stale.until = (bc66->func_get_tick ? bc66->func_get_tick() : 0) + BC66_STALE_TIME;
+	if( _bc66_rsp_unique( bc66->drv.cmd.exp_rsp ) ) { 
+		strcpy( bc66->drv.stale.exp, bc66->drv.cmd.exp_rsp );
+	} else { 
+		bc66->drv.stale.exp[0] = '\0';
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Forget the stale command after a module restart: its answers will not come. 
+ * A caller waiting with \p bc66_cmd_wait_ready(...) stays registered and is 
+ * called by \p bc66_process() once the module is idle. 
+ */
+static void _bc66_stale_clear( void )
+{
+	bc66_done_cb_t ready_cb = bc66->drv.stale.ready_cb;
+	void * ready_arg = bc66->drv.stale.ready_arg;
+
+	memset( &bc66->drv.stale, 0, sizeof(bc66->drv.stale) );
+	bc66->drv.stale.ready_cb = ready_cb;
+	bc66->drv.stale.ready_arg = ready_arg;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Start the result of the command being sent. 
+ * 
+ * @param cmd_type	: command type. 
+ * @param cmd_lst 	: command. 
+ */
+static void _bc66_result_start( bc66_cmd_type_t cmd_type, bc66_cmd_list_t cmd_lst )
+{
+	bc66->drv.result.status = bc66_ret_busy;
+	bc66->drv.result.err_code = BC66_NO_ERR_CODE;
+	bc66->drv.result.cms = false;
+	bc66->drv.result.cmd_type = cmd_type;
+	bc66->drv.result.cmd = cmd_lst;
+	bc66->drv.result.elapsed = 0;
+	bc66->drv.result.retransmissions = 0;
+	bc66->drv.result.seq = bc66->drv.cmd.seq;
+	bc66->drv.cmd.start = bc66->func_get_tick ? bc66->func_get_tick() : 0;
+	bc66->drv.cmd.polls = 0;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Count a module timeout for the liveness monitor. 
+ * 
+ * @param start : tick when the unanswered line was sent [ms]. 
+ */
+static void _bc66_health_timeout( uint32_t start )
+{
+	if( bc66->drv.health.timeouts == 0 ) { 
+		bc66->drv.health.fault_start = start;
+	}
+	if( bc66->drv.health.timeouts < UINT8_MAX ) { 
+		bc66->drv.health.timeouts ++;
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the setting name length of a cached command line: the command, and its 
+ * first argument when it is a quoted name (AT+QMTCFG="keepalive",...). 
+ * 
+ * @param line		: command line. 
+ * @param len		: line length. 
+ * @param cmd_lst	: command. 
+ * 
+ * @return 
+ * Setting name length.
+ */
+static size_t _bc66_cfg_key( const char * line, size_t len, bc66_cmd_list_t cmd_lst )
+{
+	size_t key = strlen("AT") + strlen(bc66_cmds_list[cmd_lst].cmd);
+	const char * quote;
+
+	if( (key + 2 < len) && (line[key] == '=') && (line[key + 1] == '"') && 
+		(quote = memchr( &line[key + 2], '"', len - key - 2 )) ) { 
+		key = quote + 1 - line;
+	}
+	return key;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Cache the setting command line that just succeeded. A previous value of the 
+ * same setting is removed and the new one goes last, so the replay keeps the order. 
+ */
+static void _bc66_cfg_cache_add( void )
+{
+	bc66_cmd_list_t cmd_lst = bc66->drv.result.cmd;
+	bc66_cmd_type_t cmd_type = bc66->drv.result.cmd_type;
+	const char * line = (const char *)bc66->drv.tx_buffer;
+	size_t len = bc66->drv.tx_len - strlen(CMD_END_LINE);
+	uint8_t * buf = bc66->drv.cfg_cache.buf;
+	size_t key, pos = 0, entry;
+
+	if( bc66->drv.cfg_cache.replaying || !(bc66_cmds_list[cmd_lst].cmd_flags & BC66_CMD_FLAG_CFG) || 
+		((cmd_type != BC66_CMD_WRITE) && (cmd_type != BC66_CMD_EXE)) ) { 
+		return;
+	}
+
+	key = _bc66_cfg_key( line, len, cmd_lst );
+	while( pos < bc66->drv.cfg_cache.len ) { 
+		entry = 3 + buf[pos + 2];
+		if( (buf[pos] == cmd_lst) && (buf[pos + 1] == cmd_type) && 
+			(_bc66_cfg_key( (const char *)&buf[pos + 3], buf[pos + 2], cmd_lst ) == key) && !memcmp( &buf[pos + 3], line, key ) ) { 
+			memmove( &buf[pos], &buf[pos + entry], bc66->drv.cfg_cache.len - pos - entry );
+			bc66->drv.cfg_cache.len -= entry;
+		} else { 
+			pos += entry;
+		}
+	}
+
+	if( (len > UINT8_MAX) || (bc66->drv.cfg_cache.len + 3 + len > sizeof(bc66->drv.cfg_cache.buf)) ) { 
+		bc66->drv.health.stats.cfg_dropped ++;
+		return;
+	}
+	buf += bc66->drv.cfg_cache.len;
+	buf[0] = (uint8_t)cmd_lst;
+	buf[1] = (uint8_t)cmd_type;
+	buf[2] = (uint8_t)len;
+	memcpy( &buf[3], line, len );
+	bc66->drv.cfg_cache.len += 3 + len;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * End the result of the running command. 
+ * 
+ * @param ret_code	: command return code. 
+ * 
+ * @return 
+ * \p ret_code
+ */
+static bc66_ret_t _bc66_result_end( bc66_ret_t ret_code )
+{
+	const char * rsp = bc66->drv.last_rsp;
+
+	bc66->drv.result.status = ret_code;
+	bc66->drv.result.elapsed = bc66->func_get_tick ? (uint32_t)(bc66->func_get_tick() - bc66->drv.cmd.start) : bc66->drv.cmd.polls;
+	_bc66_stale_mark( ret_code );
+	bc66->drv.echo.armed = false;
+	bc66->drv.echo.pos = 0;
+	// liveness: any answer ends a run of timeouts 
+	if( ret_code == bc66_ret_timeout ) { 
+		_bc66_health_timeout( bc66->drv.cmd.start );
+	} else if( ret_code != bc66_ret_cancelled ) { 
+		bc66->drv.health.timeouts = 0;
+	}
+	if( ret_code == bc66_ret_success ) { 
+		_bc66_cfg_cache_add();
+	}
+	if( (ret_code == bc66_ret_error) && rsp ) { 
+		if( !strncmp( rsp, FRC_CME_ERROR, strlen(FRC_CME_ERROR) ) ) { 
+			bc66->drv.result.err_code = (int16_t)atoi( rsp + strlen(FRC_CME_ERROR) );
+		} else if( !strncmp( rsp, FRC_CMS_ERROR, strlen(FRC_CMS_ERROR) ) ) { 
+			bc66->drv.result.err_code = (int16_t)atoi( rsp + strlen(FRC_CMS_ERROR) );
+			bc66->drv.result.cms = true;
+		}
+	}
+	return ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check a command and its expected response before anything is sent: a command 
+ * refused after its line was written would still run on the module. 
+ * 
+ * @param cmd_lst 	: command to send. 
+ * @param exp_rsp 	: expected response text or NULL to wait the command response. 
+ * 
+ * @return 
+ * bc66_ret_success if the command can be sent, see \p bc66_ret_t return codes.
+ */
+static bc66_ret_t _bc66_cmd_check( bc66_cmd_list_t cmd_lst, const char * exp_rsp )
+{
+	if( cmd_lst >= bc66_cmd_list_size ) { 
+		return bc66_ret_no_cmd_implemented;
+	}
+	if( exp_rsp == NULL ) { 
+		exp_rsp = bc66_cmds_list[cmd_lst].cmd_rsp;
+	}
+	if( exp_rsp && (strlen(exp_rsp) >= BC66_EXP_RSP_SIZE) ) { 
+		return bc66_ret_out_of_range;
+	}
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set the response expected by the command just sent. The response length was 
+ * checked before sending (see \p _bc66_cmd_check(...)). 
+ * 
+ * @param rsp			: expected response text, shorter than BC66_EXP_RSP_SIZE 
+ * @param timeout		: response wait time [ms]
+ * @param mqtt_result	: response carries a MQTT packet <result> 
+ */
+static void _bc66_cmd_expect( const char * rsp, uint32_t timeout, bool mqtt_result )
+{
+	strcpy( bc66->drv.cmd.exp_rsp, rsp );
+	bc66->drv.cmd.pattern = NULL;
+	bc66->drv.cmd.mqtt_result = mqtt_result;
+	bc66->drv.cmd.timeout = timeout;
+	bc66->drv.cmd.done_cb = NULL;
+	bc66->drv.cmd.busy = true;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check received chars for the running command response, without blocking. 
+ * 
+ * @return 
+ * bc66_ret_busy while the response has not arrived, see \p bc66_ret_t return codes otherwise.
+ */
+static bc66_ret_t _bc66_cmd_step( void )
+{
+	bc66->drv.cmd.polls ++;
+
+	// get new received chars, nothing to parse if there are not
+	if( _bc66_rx_read() ) { 
+		if( bc66->drv.cmd.pattern ) { 
+			if( _bc66_pattern_parser( bc66->drv.cmd.pattern, bc66->drv.cmd.exp_rsp, bc66->drv.cmd.match ) ) { 
+				return bc66->drv.cmd.mqtt_result ? _bc66_mqtt_result( bc66->drv.cmd.match ) : bc66_ret_success;
+			}
+		} else if( _bc66_at_parser( bc66->drv.cmd.exp_rsp ) ) {
+			return bc66_ret_success;
+		}
+		// module answered with an error: do not wait the timeout 
+		if( _bc66_at_error() ) { 
+			return bc66_ret_error;
+		}
+	}
+
+	if( bc66->func_get_tick ) {
+		if( (uint32_t)(bc66->func_get_tick() - bc66->drv.cmd.start) >= bc66->drv.cmd.timeout ) {
+			return bc66_ret_timeout;
+		}
+	} else if( (bc66->drv.cmd.timeout == 0) || (--bc66->drv.cmd.timeout == 0) ) {
+		// without tick each step is 1 ms 
+		return bc66_ret_timeout;
+	}
+	return bc66_ret_busy;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Wait Modem response.
+ * 
+ * @param rsp	: response buffer pointer 
+ * @param timeout: response wait time [ms]
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+static bc66_ret_t _bc66_find_at_response( const char * rsp, uint32_t timeout )
+{
+	bc66_ret_t ret_code;
+
+	_bc66_cmd_expect( rsp, timeout, false );
+	do {
+		bc66->func_delay(1);
+	} while( (ret_code = _bc66_cmd_step()) == bc66_ret_busy );
+	bc66->drv.cmd.busy = false;
+	return _bc66_result_end( ret_code );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Wait the first modem response line that matches a pattern. 
+ * 
+ * @param pat			: compiled pattern. 
+ * @param rsp			: line start, shorter than BC66_EXP_RSP_SIZE, NULL for the pattern leading literal. 
+ * @param match			: fields captured. 
+ * @param timeout		: response wait time [ms]
+ * @param mqtt_result	: response carries a MQTT packet <msgID>,<result>[,<value>] 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+static bc66_ret_t _bc66_find_at_match( const bc66_pattern_t * pat, const char * rsp, bc66_match_t * match, uint32_t timeout, bool mqtt_result )
+{
+	char lead[BC66_EXP_RSP_SIZE] = "";
+	bc66_ret_t ret_code;
+
+	// leading literal is the expected answer (late answer filter if it identifies the command) 
+	if( rsp ) { 
+		strcpy( lead, rsp );
+	} else if( pat->elem[0].op == bc66_pat_lit ) { 
+		size_t len = (pat->elem[0].len < sizeof(lead)) ? pat->elem[0].len : sizeof(lead) - 1;
+		memcpy( lead, &pat->src[pat->elem[0].pos], len );
+		lead[len] = '\0';
+	}
+
+	_bc66_cmd_expect( lead, timeout, mqtt_result );
+	bc66->drv.cmd.pattern = pat;
+	bc66->drv.cmd.match = match;
+	do {
+		bc66->func_delay(1);
+	} while( (ret_code = _bc66_cmd_step()) == bc66_ret_busy );
+	bc66->drv.cmd.busy = false;
+	bc66->drv.cmd.pattern = NULL;
+	return _bc66_result_end( ret_code );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Wait a prompt from modem at a line start. Unlike responses, a prompt is not followed 
+ * by end of line. 
+ * 
+ * @param prompt	: prompt text 
+ * @param timeout	: prompt wait time [ms]
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+static bc66_ret_t _bc66_find_at_prompt( const char * prompt, uint32_t timeout )
+{
+	char * idx;
+	while( timeout ) {
+		bc66->func_delay(1);
+		bc66->drv.cmd.polls ++;
+		if( _bc66_rx_read() ) { 
+			// the prompt starts a line: a prompt char inside the topic or an echo is not it 
+			idx = (char*)bc66->drv.rx_buffer;
+			while( (idx = strstr( idx, prompt )) && (idx > (char*)bc66->drv.rx_buffer) && (idx[-1] != '\n') ) { 
+				idx ++;
+			}
+			if( idx ) {
+				// remove everything up to prompt 
+				_bc66_rx_buffer_remove( (char*)bc66->drv.rx_buffer, (idx - (char*)bc66->drv.rx_buffer) + strlen(prompt) );
+				return bc66_ret_success;
+			}
+			if( _bc66_at_error() ) { 
+				return _bc66_result_end( bc66_ret_error );
+			}
+		}
+		timeout --;
+	}
+
+	_bc66_result_end( bc66_ret_timeout );
+	// a late prompt leaves the module waiting data 
+	bc66->drv.stale.prompt = true;
+	return bc66_ret_timeout;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Hand every response line of the running command to a callback until the final 
+ * result code. Delivered lines are removed from RX buffer so a response can be 
+ * longer than RX buffer: if RX buffer fills up without an end of line, the 
+ * fragment is delivered as partial and the line continues in the next call. 
+ * 
+ * @param line_cb	: function called for each intermediate line. 
+ * @param arg		: callback user argument. 
+ * @param timeout	: response wait time [ms]
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+static bc66_ret_t _bc66_collect_at_lines( bc66_line_cb_t line_cb, void * arg, uint32_t timeout )
+{
+	bool partial = false;
+
+	while( timeout ) {
+		char * line = (char*)bc66->drv.rx_buffer;
+		char * eol;
+
+		bc66->func_delay(1);
+		bc66->drv.cmd.polls ++;
+		// get new received chars 
+		if( _bc66_rx_read() == 0 ) {
+			timeout --;
+			continue;
+		}
+
+		// process all complete lines 
+		while( (eol = strstr( line, RSP_END_OF_LINE )) ) {
+			size_t len = eol - line;
+			char * next = eol + strlen(RSP_END_OF_LINE);
+			bc66_ret_t frc;
+
+			// trim extra carriage return 
+			while( len && (line[len-1] == '\r') ) {
+				len--;
+			}
+
+			if( partial ) {
+				// end of a line already started 
+				line_cb( line, len, false, arg );
+				partial = false;
+			} else if( len ) {
+				// final result code ends the command 
+				if( (frc = _bc66_final_result_code( line, len )) != bc66_ret_timeout ) {
+					_bc66_set_last_response( line, len );
+					_bc66_rx_buffer_remove( (char*)bc66->drv.rx_buffer, next - (char*)bc66->drv.rx_buffer );
+					return _bc66_result_end( frc );
+				}
+				line_cb( line, len, false, arg );
+			}
+			line = next;
+		}
+		// remove delivered lines 
+		_bc66_rx_buffer_remove( (char*)bc66->drv.rx_buffer, line - (char*)bc66->drv.rx_buffer );
+
+		// RX buffer full without end of line: deliver fragment 
+		if( _bc66_rx_room() == 0 ) {
+			// keep last char, it could be the <CR> of end of line 
+			line_cb( (char*)bc66->drv.rx_buffer, bc66->drv.rx_len - 1, true, arg );
+			_bc66_rx_buffer_remove( (char*)bc66->drv.rx_buffer, bc66->drv.rx_len - 1 );
+			partial = true;
+		}
+		timeout --;
+	}
+
+	return _bc66_result_end( bc66_ret_timeout );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Start draining the answers of a timed out or cancelled command. ATI is sent 
+ * as marker (ESC first, to leave a data prompt): answers come in order, so every 
+ * line before its "Revision:" line and final OK belongs to older commands. 
+ */
+static void _bc66_resync_start( void )
+{
+	static const char marker[] = "ATI" CMD_END_LINE;
+	const uint8_t esc = CMD_ESC;
+
+	// a stale ATI answers a marker too 
+	bc66->drv.stale.markers = ((bc66->drv.stale.cmd == bc66_cmd_list_ATI) && bc66->drv.stale.frc) ? 2 : 1;
+	bc66->drv.stale.start = bc66->func_get_tick ? bc66->func_get_tick() : 0;
+	bc66->drv.stale.polls = 0;
+	bc66->drv.stale.resync = true;
+
+	if( bc66->drv.stale.prompt ) { 
+		bc66->func_w_bytes_ptr( (uint8_t *)&esc, sizeof(esc) );
+	}
+	bc66->func_w_bytes_ptr( (uint8_t *)marker, strlen(marker) );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check received chars for the resync marker answer, without blocking. 
+ * 
+ * @return 
+ * bc66_ret_busy while the marker answer has not arrived, bc66_ret_success when 
+ * synchronized, bc66_ret_timeout if the marker was not answered in 
+ * BC66_RESYNC_TIMEOUT (stale state is dropped anyway).
+ */
+static bc66_ret_t _bc66_resync_step( void )
+{
+	static const char revision[] = "Revision:";
+	bc66_ret_t ret_code = bc66_ret_busy;
+
+	if( _bc66_rx_read() ) { 
+		char * line = (char*)bc66->drv.rx_buffer;
+		char * eol;
+
+		while( (eol = strstr( line, RSP_END_OF_LINE )) ) {
+			size_t len = eol - line;
+			if( !strncmp( line, revision, strlen(revision) ) && bc66->drv.stale.markers ) { 
+				bc66->drv.stale.markers --;
+			} else if( (bc66->drv.stale.markers == 0) && (_bc66_final_result_code( line, len ) == bc66_ret_success) ) { 
+				ret_code = bc66_ret_success;
+				break;
+			}
+			line = eol + strlen(RSP_END_OF_LINE);
+		}
+		// answers of older commands are dropped 
+		_bc66_rx_buffer_remove( (char*)bc66->drv.rx_buffer, line - (char*)bc66->drv.rx_buffer );
+	}
+
+	if( ret_code == bc66_ret_busy ) { 
+		if( bc66->func_get_tick ) { 
+			if( (uint32_t)(bc66->func_get_tick() - bc66->drv.stale.start) >= BC66_RESYNC_TIMEOUT ) { 
+				ret_code = bc66_ret_timeout;
+			}
+		} else if( ++bc66->drv.stale.polls >= BC66_RESYNC_TIMEOUT ) { 
+			// without tick each step is 1 ms 
+			ret_code = bc66_ret_timeout;
+		}
+		if( ret_code == bc66_ret_busy ) { 
+			return ret_code;
+		}
+		_bc66_health_timeout( bc66->drv.stale.start );
+	}
+
+	_bc66_rx_buffer_flush();
+	bc66->drv.stale.frc = false;
+	bc66->drv.stale.prompt = false;
+	bc66->drv.stale.resync = false;
+	return ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Drain the answers of a timed out or cancelled command, blocking up to 
+ * BC66_RESYNC_TIMEOUT. A resync started by an asynchronous command is completed. 
+ * 
+ * @return 
+ * See \p _bc66_resync_step().
+ */
+static bc66_ret_t _bc66_resync( void )
+{
+	bc66_ret_t ret_code;
+
+	if( !bc66->drv.stale.resync ) { 
+		_bc66_resync_start();
+	}
+	do { 
+		bc66->func_delay(1);
+	} while( (ret_code = _bc66_resync_step()) == bc66_ret_busy );
+	return ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check if an asynchronous command has to wait a resync: the resync is started, 
+ * or checked once, and \p bc66_process() completes it. 
+ * 
+ * @return 
+ * true while the resync runs.
+ */
+static bool _bc66_resync_busy( void )
+{
+	if( !bc66->drv.stale.resync && !bc66->drv.stale.frc && !bc66->drv.stale.prompt ) { 
+		return false;
+	}
+	if( !bc66->drv.stale.resync ) { 
+		_bc66_resync_start();
+	}
+	return _bc66_resync_step() == bc66_ret_busy;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Append the arguments to the command line start in TX buffer and write it to the module. 
+ * 
+ * @param cmd_type	: command type, for the result. 
+ * @param cmd_lst 	: command, for the result. 
+ * @param len 		: command line start length (already in TX buffer). 
+ * @param arg_fmt 	: arguments format (like printf function) or NULL.
+ * @param args 		: arguments list. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+static bc66_ret_t _bc66_write_at_line(bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, int len, const char * arg_fmt, va_list args)
+{
+	bc66_ret_t ret_code;
+
+	// command type not available for this command 
+	if( len < 0 ) {
+		return bc66_ret_no_cmd_implemented;
+	}
+
+	// late final result code of a timed out command must not end this one 
+	if( (bc66->drv.stale.frc || bc66->drv.stale.prompt || bc66->drv.stale.resync) && ((ret_code = _bc66_resync()) != bc66_ret_success) ) { 
+		return ret_code;
+	}
+
+	if( arg_fmt && ((size_t)len < sizeof(bc66->drv.tx_buffer)) ) { 
+		len += vsnprintf((char*)&bc66->drv.tx_buffer[len], sizeof(bc66->drv.tx_buffer) - len, arg_fmt, args);
+	}
+
+	// command line must fit in tx buffer with end of line chars 
+	if( (size_t)len + sizeof(CMD_END_LINE) > sizeof(bc66->drv.tx_buffer) ) {
+		return bc66_ret_out_of_range;
+	}
+
+	// arguments were consumed: release previous command scratch memory 
+	_bc66_arena_reset();
+
+	// send command
+	memcpy(&bc66->drv.tx_buffer[len],CMD_END_LINE,sizeof(CMD_END_LINE));
+	bc66->drv.tx_len = len + strlen(CMD_END_LINE);
+	bc66->drv.echo.armed = true;
+	bc66->drv.echo.pos = 0;
+	bc66->drv.cmd.exp_rsp[0] = '\0';
+	bc66->drv.cmd.seq ++;
+	_bc66_result_start( cmd_type, cmd_lst );
+	if( (cmd_type == BC66_CMD_WRITE) && ((cmd_lst == bc66_cmd_list_CGATT) || (cmd_lst == bc66_cmd_list_QCGDEFCONT)) ) { 
+		_bc66_addr_invalidate();
+	}
+	bc66->func_w_bytes_ptr((uint8_t*)bc66->drv.tx_buffer,bc66->drv.tx_len);
+
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Build the AT command line in TX buffer and write it to the module. 
+ * 
+ * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
+ * @param cmd_lst 	: command to send (see command list). 
+ * @param arg_fmt 	: arguments format (like printf function).
+ * @param args 		: arguments list. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+static bc66_ret_t _bc66_write_at_command(bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char * arg_fmt, va_list args)
+{
+	int len = -1;
+
+	// only one command at a time 
+	if( bc66->drv.cmd.busy ) { 
+		return bc66_ret_busy;
+	}
+	if( cmd_lst >= bc66_cmd_list_size ) { 
+		return bc66_ret_no_cmd_implemented;
+	}
+
+	// flush rx buffer to store all responses 
+	_bc66_rx_buffer_flush();
+
+	// command line start, arguments only for write and execution commands 
+	switch( cmd_type )
+	{
+		case BC66_CMD_TEST:
+			if( bc66_cmds_list[cmd_lst].cmd_flags & BC66_CMD_FLAG_TEST ) {
+				len = snprintf((char*)bc66->drv.tx_buffer,sizeof(bc66->drv.tx_buffer),"AT%s=?",bc66_cmds_list[cmd_lst].cmd);
+			}
+			arg_fmt = NULL;
+			break;
+
+		case BC66_CMD_READ:
+			if( bc66_cmds_list[cmd_lst].cmd_flags & BC66_CMD_FLAG_READ ) {
+				len = snprintf((char*)bc66->drv.tx_buffer,sizeof(bc66->drv.tx_buffer),"AT%s?",bc66_cmds_list[cmd_lst].cmd);
+			}
+			arg_fmt = NULL;
+			break;
+
+		case BC66_CMD_WRITE:
+			if( bc66_cmds_list[cmd_lst].cmd_flags & BC66_CMD_FLAG_WRITE ) {
+				len = snprintf((char*)bc66->drv.tx_buffer,sizeof(bc66->drv.tx_buffer),"AT%s=",bc66_cmds_list[cmd_lst].cmd);
+			}
+			break;
+
+		case BC66_CMD_EXE:
+			if( bc66_cmds_list[cmd_lst].cmd_flags & BC66_CMD_FLAG_EXE ) {
+				len = snprintf((char*)bc66->drv.tx_buffer,sizeof(bc66->drv.tx_buffer),"AT%s",bc66_cmds_list[cmd_lst].cmd);
+			}
+			break;
+
+		default:	
+			return bc66_ret_no_cmd_implemented;
+			break;
+	}
+
+	return _bc66_write_at_line( cmd_type, cmd_lst, len, arg_fmt, args );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Send at command sentence without waiting any response. 
+ * 
+ * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
+ * @param cmd_lst 	: command to send (see command list). 
+ * @param arg_fmt 	: arguments format (like printf function) and must be sended all arguments too.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+static bc66_ret_t _bc66_send_at_line(bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char * arg_fmt, ...)
+{
+	bc66_ret_t ret_code;
+	va_list args;
+
+	// check if object was initialized
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+
+	va_start( args, arg_fmt );
+	ret_code = _bc66_write_at_command( cmd_type, cmd_lst, arg_fmt, args );
+	va_end( args );
+	return ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to send at command sentence to bc66 module through an external function communication. 
+ * 
+ * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
+ * @param cmd_lst 	: command to send (see command list). 
+ * @param rsp 		: pointer to expected response text. 
+ * @param arg_fmt 	: arguments format (like printf function) and must be sended all arguments too.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+bc66_ret_t bc66_send_at_command(bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char *exp_rsp, const char * arg_fmt, ...)
+{
+	bc66_ret_t ret_code;
+	va_list args;
+
+	// check if object was initialized
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (ret_code = _bc66_cmd_check( cmd_lst, exp_rsp )) != bc66_ret_success ) { 
+		return ret_code;
+	}
+
+	// send command 
+	va_start( args, arg_fmt );
+	ret_code = _bc66_write_at_command( cmd_type, cmd_lst, arg_fmt, args );
+	va_end( args );
+	if( ret_code != bc66_ret_success ) { 
+		return ret_code;
+	}
+
+	// check expected response - +ATCMD: ... 
+	if( exp_rsp ) {
+		return _bc66_find_at_response((const char*)exp_rsp, bc66_cmds_list[cmd_lst].rsp_timeout);
+	}
+
+	// check command response - <CR><LF>OK<CR><LF> normally
+	if( bc66_cmds_list[cmd_lst].cmd_rsp ) {
+		return _bc66_find_at_response((const char*)bc66_cmds_list[cmd_lst].cmd_rsp, bc66_cmds_list[cmd_lst].rsp_timeout);
+	}
+
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to send at command sentence which start (i.e. "AT+QMTPUB=") was built by the caller. 
+ * 
+ * @param cmd_type	: command type of \p prefix, for \p bc66_get_last_result(...). 
+ * @param cmd_lst 	: command to send (see command list), gives response and timeout. 
+ * @param prefix 	: command line start, not null terminated. 
+ * @param prefix_len: command line start length. 
+ * @param exp_rsp 	: pointer to expected response text or NULL to wait command response. 
+ * @param arg_fmt 	: arguments format (like printf function) or NULL.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+bc66_ret_t bc66_send_at_prefixed(bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char *prefix, size_t prefix_len, const char *exp_rsp, const char * arg_fmt, ...)
+{
+	bc66_ret_t ret_code;
+	va_list args;
+
+	// check if object was initialized
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (ret_code = _bc66_cmd_check( cmd_lst, exp_rsp )) != bc66_ret_success ) { 
+		return ret_code;
+	}
+	if( prefix_len >= sizeof(bc66->drv.tx_buffer) ) { 
+		return bc66_ret_out_of_range;
+	}
+	if( bc66->drv.cmd.busy ) { 
+		return bc66_ret_busy;
+	}
+
+	// flush rx buffer to store all responses 
+	_bc66_rx_buffer_flush();
+	memcpy( bc66->drv.tx_buffer, prefix, prefix_len );
+
+	va_start( args, arg_fmt );
+	ret_code = _bc66_write_at_line( cmd_type, cmd_lst, (int)prefix_len, arg_fmt, args );
+	va_end( args );
+
+	if( ret_code == bc66_ret_success ) { 
+		ret_code = _bc66_find_at_response( exp_rsp ? exp_rsp : bc66_cmds_list[cmd_lst].cmd_rsp, bc66_cmds_list[cmd_lst].rsp_timeout );
+	}
+	return ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to send at command sentence without blocking. 
+ * 
+ * @param done_cb	: function called when the command ends (optional). 
+ * @param arg		: callback user argument. 
+ * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
+ * @param cmd_lst 	: command to send (see command list). 
+ * @param exp_rsp 	: pointer to expected response text or NULL to wait command response. 
+ * @param arg_fmt 	: arguments format (like printf function) and must be sended all arguments too.
+ * 
+ * @return 
+ * bc66_ret_success if the command was sent, bc66_ret_busy while a command or a 
+ * resync runs (see \p bc66_cmd_wait_ready(...)), see \p bc66_ret_t return codes otherwise. 
+ */
+bc66_ret_t bc66_cmd_start(bc66_done_cb_t done_cb, void * arg, bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char *exp_rsp, const char * arg_fmt, ...)
+{
+	bc66_ret_t ret_code;
+	va_list args;
+
+	// check if object was initialized
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (ret_code = _bc66_cmd_check( cmd_lst, exp_rsp )) != bc66_ret_success ) { 
+		return ret_code;
+	}
+	if( (exp_rsp == NULL) && (bc66_cmds_list[cmd_lst].cmd_rsp == NULL) ) { 
+		return bc66_ret_out_of_range;
+	}
+	if( bc66->drv.cmd.busy || _bc66_resync_busy() ) { 
+		return bc66_ret_busy;
+	}
+
+	// send command 
+	va_start( args, arg_fmt );
+	ret_code = _bc66_write_at_command( cmd_type, cmd_lst, arg_fmt, args );
+	va_end( args );
+
+	if( ret_code == bc66_ret_success ) { 
+		_bc66_cmd_expect( exp_rsp ? exp_rsp : bc66_cmds_list[cmd_lst].cmd_rsp, bc66_cmds_list[cmd_lst].rsp_timeout, false );
+		bc66->drv.cmd.done_cb = done_cb;
+		bc66->drv.cmd.arg = arg;
+	}
+	return ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Query the state of the waiting bring-up stage. 
+ * 
+ * @param ret_code	: query result. 
+ * @param arg		: not used. 
+ */
+static void _bc66_attach_probe_done( bc66_ret_t ret_code, void * arg )
+{
+	(void)arg;
+	// attach refused: no need to wait the registration timeout 
+	if( bc66->drv.attach.active && (bc66->drv.result.cmd == bc66_cmd_list_CGATT) && (ret_code == bc66_ret_error) ) { 
+		bc66->drv.attach.active = false;
+		if( bc66->drv.attach.cb ) { 
+			bc66->drv.attach.cb( bc66->drv.attach.stage, ret_code, bc66->func_get_tick() - bc66->drv.attach.stage_start, bc66->drv.attach.arg );
+		}
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Advance the network bring-up: check the stage, its timeout and query its state. 
+ */
+static void _bc66_attach_step( void )
+{
+	uint32_t now = bc66->func_get_tick();
+	bc66_attach_stage_t stage = bc66->drv.attach.stage;
+	bool reached;
+
+	switch( stage ) { 
+		case bc66_attach_sim:	reached = bc66->drv.sim.ready;											break;
+		case bc66_attach_reg:	reached = (bc66->drv.reg_stat == 1) || (bc66->drv.reg_stat == 5);		break;
+		case bc66_attach_pdp:	reached = bc66->drv.attach.pdp_active;									break;
+		default:				reached = bc66->drv.attach.ip;											break;
+	}
+
+	if( reached ) { 
+		bc66->drv.attach.latency[stage] = now - bc66->drv.attach.stage_start;
+		bc66->drv.attach.stage = stage + 1;
+		bc66->drv.attach.stage_start = now;
+		bc66->drv.attach.last_probe = now - bc66->drv.attach.cfg.poll;
+		if( bc66->drv.attach.stage == bc66_attach_done ) { 
+			bc66->drv.attach.active = false;
+			bc66->drv.attach.latency[bc66_attach_done] = now - bc66->drv.attach.start;
+		}
+		if( bc66->drv.attach.cb ) { 
+			bc66->drv.attach.cb( stage, bc66_ret_success, bc66->drv.attach.latency[stage], bc66->drv.attach.arg );
+			if( !bc66->drv.attach.active && (bc66->drv.attach.stage == bc66_attach_done) ) { 
+				bc66->drv.attach.cb( bc66_attach_done, bc66_ret_success, bc66->drv.attach.latency[bc66_attach_done], bc66->drv.attach.arg );
+			}
+		}
+		return;
+	}
+
+	if( (now - bc66->drv.attach.stage_start) >= bc66->drv.attach.cfg.timeout[stage] ) { 
+		bc66->drv.attach.active = false;
+		if( bc66->drv.attach.cb ) { 
+			bc66->drv.attach.cb( stage, bc66_ret_timeout, now - bc66->drv.attach.stage_start, bc66->drv.attach.arg );
+		}
+		return;
+	}
+
+	// query stage state: the answer lines are handled as URCs 
+	if( bc66->drv.cmd.busy || ((now - bc66->drv.attach.last_probe) < bc66->drv.attach.cfg.poll) ) { 
+		return;
+	}
+	bc66->drv.attach.last_probe = now;
+	switch( stage ) { 
+		case bc66_attach_sim:
+			bc66_cmd_start( _bc66_attach_probe_done, NULL, BC66_CMD_READ, bc66_cmd_list_CPIN, NULL, NULL );
+			break;
+		case bc66_attach_reg:
+			if( bc66->drv.attach.cfg.attach && !bc66->drv.attach.attach_sent ) { 
+				bc66->drv.attach.attach_sent = true;
+				bc66_cmd_start( _bc66_attach_probe_done, NULL, BC66_CMD_WRITE, bc66_cmd_list_CGATT, NULL, "1" );
+			} else { 
+				bc66_cmd_start( _bc66_attach_probe_done, NULL, BC66_CMD_READ, bc66_cmd_list_CEREG, NULL, NULL );
+			}
+			break;
+		case bc66_attach_pdp:
+			bc66_cmd_start( _bc66_attach_probe_done, NULL, BC66_CMD_READ, bc66_cmd_list_CGACT, NULL, NULL );
+			break;
+		default:
+			bc66_cmd_start( _bc66_attach_probe_done, NULL, BC66_CMD_WRITE, bc66_cmd_list_CGPADDR, NULL, "%u", bc66->drv.attach.cfg.cid );
+			break;
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set the callback of the received lines the driver does not handle, i.e. 
+ * +QMTRECV messages. Lines are delivered and dropped by \p bc66_process(...) 
+ * while no command runs. 
+ * 
+ * @param urc_cb	: line callback (partial is always false), NULL to keep the lines in RX buffer. 
+ * It must not send commands. 
+ * @param arg		: callback user argument. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_urc_callback( bc66_line_cb_t urc_cb, void * arg )
+{
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	bc66->drv.urc_cb = urc_cb;
+	bc66->drv.urc_arg = arg;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Process received chars of the selected module. 
+ * Ends the running asynchronous command, if any, calling its \p done_cb, or 
+ * advances the resync that follows a timed out command. 
+ */
+void bc66_process( void )
+{
+	bc66_obj_t * self = bc66;
+	bc66_ret_t ret_code;
+
+	if( bc66 == NULL ) { 
+		return;
+	}
+	if( bc66->drv.stale.resync && !bc66->drv.cmd.busy ) { 
+		_bc66_resync_step();
+	} else if( !bc66->drv.cmd.busy ) { 
+		_bc66_rx_idle();
+	} else if( (ret_code = _bc66_cmd_step()) != bc66_ret_busy ) { 
+		// command ended: callback can start a new one, even on other module 
+		bc66->drv.cmd.busy = false;
+		_bc66_result_end( ret_code );
+		if( bc66->drv.cmd.done_cb ) { 
+			bc66->drv.cmd.done_cb( ret_code, bc66->drv.cmd.arg );
+			bc66 = self;
+		}
+	}
+
+	if( bc66->drv.stale.ready_cb && !bc66->drv.cmd.busy && !bc66->drv.stale.resync ) { 
+		bc66_done_cb_t ready_cb = bc66->drv.stale.ready_cb;
+		bc66->drv.stale.ready_cb = NULL;
+		ready_cb( bc66_ret_success, bc66->drv.stale.ready_arg );
+		bc66 = self;
+	}
+
+	if( bc66->drv.attach.active ) { 
+		_bc66_attach_step();
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check if the selected module has a command waiting its response, or a resync 
+ * running: \p bc66_process(...) must be called and new asynchronous commands 
+ * get bc66_ret_busy. 
+ * 
+ * @return 
+ * true if a command or a resync is running.
+ */
+bool bc66_cmd_busy( void )
+{
+	return bc66 && (bc66->drv.cmd.busy || bc66->drv.stale.resync);
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Call a function from \p bc66_process(...) once the selected module is idle 
+ * (no command and no resync running), i.e. to start again an asynchronous 
+ * command that got bc66_ret_busy. It is called once. 
+ * 
+ * @param ready_cb	: function called with bc66_ret_success, NULL to clear. 
+ * @param arg		: callback user argument. 
+ * 
+ * @return 
+ * bc66_ret_busy if another function is waiting, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_cmd_wait_ready( bc66_done_cb_t ready_cb, void * arg )
+{
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( ready_cb && bc66->drv.stale.ready_cb ) { 
+		return bc66_ret_busy;
+	}
+	bc66->drv.stale.ready_cb = ready_cb;
+	bc66->drv.stale.ready_arg = arg;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Cancel the running asynchronous command of the selected module. Its \p done_cb 
+ * is called with bc66_ret_cancelled. The module may still answer it: the late 
+ * final result code is drained before the next command and its late response 
+ * line is dropped when it arrives. 
+ * 
+ * @return 
+ * bc66_ret_fail if no command is running, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_cmd_cancel( void )
+{
+	bc66_obj_t * self = bc66;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( !bc66->drv.cmd.busy ) { 
+		return bc66_ret_fail;
+	}
+	bc66->drv.cmd.busy = false;
+	_bc66_result_end( bc66_ret_cancelled );
+	if( bc66->drv.cmd.done_cb ) { 
+		bc66->drv.cmd.done_cb( bc66_ret_cancelled, bc66->drv.cmd.arg );
+		bc66 = self;
+	}
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Resynchronize with the module: send ATI as marker and drop every answer received 
+ * before the marker answer. Done automatically before the next command after a 
+ * timeout or a cancel (asynchronous commands let \p bc66_process(...) run it 
+ * without blocking); call it after a host restart to drop answers of commands 
+ * sent by the previous run. Blocks up to BC66_RESYNC_TIMEOUT. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_resync( void )
+{
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( bc66->drv.cmd.busy ) { 
+		return bc66_ret_busy;
+	}
+	return _bc66_resync();
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to send at command sentence and collect all its response lines. 
+ * 
+ * @param line_cb	: function called for each intermediate response line. 
+ * @param arg		: callback user argument (i.e. a \p bc66_line_arena_t). 
+ * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
+ * @param cmd_lst 	: command to send (see command list). 
+ * @param arg_fmt 	: arguments format (like printf function) and must be sended all arguments too.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+bc66_ret_t bc66_send_at_command_lines(bc66_line_cb_t line_cb, void * arg, bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char * arg_fmt, ...)
+{
+	bc66_ret_t ret_code;
+	va_list args;
+
+	// check if object was initialized
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( line_cb == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	// send command 
+	va_start( args, arg_fmt );
+	ret_code = _bc66_write_at_command( cmd_type, cmd_lst, arg_fmt, args );
+	va_end( args );
+	if( ret_code != bc66_ret_success ) { 
+		return ret_code;
+	}
+
+	return _bc66_collect_at_lines( line_cb, arg, bc66_cmds_list[cmd_lst].rsp_timeout );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to send at command sentence and wait the first response line that 
+ * matches a compiled pattern. 
+ * 
+ * @param pat		: compiled response pattern. 
+ * @param match		: fields captured, they point into the last response. 
+ * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
+ * @param cmd_lst 	: command to send (see command list). 
+ * @param arg_fmt 	: arguments format (like printf function) and must be sended all arguments too.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+bc66_ret_t bc66_send_at_command_match(const bc66_pattern_t * pat, bc66_match_t * match, bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char * arg_fmt, ...)
+{
+	bc66_ret_t ret_code;
+	va_list args;
+
+	// check if object was initialized
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (pat == NULL) || (pat->src == NULL) || (match == NULL) ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	// send command 
+	va_start( args, arg_fmt );
+	ret_code = _bc66_write_at_command( cmd_type, cmd_lst, arg_fmt, args );
+	va_end( args );
+	if( ret_code != bc66_ret_success ) { 
+		return ret_code;
+	}
+
+	return _bc66_find_at_match( pat, NULL, match, bc66_cmds_list[cmd_lst].rsp_timeout, false );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Line callback to store response lines in a caller buffer. 
+ * Lines are stored one after the other, each one terminated with '\0'. 
+ * 
+ * @param line		: response line. 
+ * @param len		: line length. 
+ * @param partial	: true if the line continues in the next call. 
+ * @param arg		: pointer to \p bc66_line_arena_t. 
+ */
+void bc66_line_arena_collect( const char * line, uint16_t len, bool partial, void * arg )
+{
+	bc66_line_arena_t * arena = (bc66_line_arena_t *)arg;
+
+	// stop collecting once a line was lost 
+	if( arena->overflow ) {
+		return;
+	}
+	// a partial line is continued in place: remove previous terminator 
+	if( arena->used && arena->partial ) {
+		arena->used--;
+	}
+	if( arena->used + len + 1 > arena->size ) {
+		arena->overflow = true;
+		return;
+	}
+	memcpy( &arena->buf[arena->used], line, len );
+	arena->used += len;
+	arena->buf[arena->used++] = '\0';
+	if( !arena->partial ) {
+		arena->lines++;
+	}
+	arena->partial = partial;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to get any response stored in the RX buffer.
+ * 
+ * @param rsp	: response to get 
+ * 
+ * @return 
+ * Response if found, NULL otherwise
+ */
+char * bc66_get_at_response( char * rsp )
+{
+	if( bc66 == NULL ) { 
+		return NULL;
+	}
+	return _bc66_at_parser((const char *)rsp);
+}
+
+//*****************************************************************************
+/**
+ * @brief
+ * Reset the module via Hardware PIN.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_hw_reset( void )
+{
+	if( bc66 ) {
+		// new SIM state after reset, answers of the old commands will not come 
+		memset( &bc66->drv.sim, 0, sizeof(bc66->drv.sim) );
+		_bc66_stale_clear();
+		bc66->drv.mqtt_session ++;
+		bc66->control_lines.MDM_RESET_N(1);
+		bc66->func_delay(100);
+		bc66->control_lines.MDM_RESET_N(0);
+		bc66->func_delay(100);
+
+		// return _bc66_find_at_response("Leaving", 5000 );
+	}
+	return bc66_ret_error;
+}
+
+//*****************************************************************************
+/**
+ * @brief
+ * Pull down PWRKEY to turn on the module
+ */
+void bc66_power_on()
+{
+	if( bc66 ) {
+		bc66->control_lines.MDM_PWRKEY_N(1);
+		bc66->func_delay(500);
+		bc66->control_lines.MDM_PWRKEY_N(0);
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief
+ * Pull up PWRKEY to turn off the module
+ */
+void bc66_power_off()
+{
+	if( bc66 ) {
+		bc66->drv.mqtt_session ++;
+		bc66->control_lines.MDM_PWRKEY_N(0);
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to get last modem response. 
+ * If send a new AT command, the buffer which contain the last response will be erased.
+ * 
+ * @return 
+ * Pointer to RX buffer with last response. 
+ */
+char * bc66_get_last_response( void )
+{
+	return (bc66 && bc66->drv.last_rsp) ? bc66->drv.last_rsp : "";
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the result of the last command: status, error number, command, elapsed 
+ * time and retransmissions. 
+ * 
+ * @param result : where the result is copied. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_last_result( bc66_result_t * result )
+{
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( result == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+	*result = bc66->drv.result;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Send AT command to sync baud rate. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+bool bc66_send_cmd_AT( void )
+{
+	return bc66_send_at_command( BC66_CMD_EXE,bc66_cmd_list_AT,NULL,NULL);
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set Command Echo Mode. 
+ * 
+ * This Execution Command determines whether or not the UE echoes characters 
+ * received from external MCU during command state. 
+ * 
+ * The command takes effect immediately. Remain valid after deep-sleep wakeup. 
+ * The configuration will be saved to NVRAM (should execute AT&W after this command is issued).
+ * 
+ * @param echo 
+ * - false: Echo mode OFF
+ * - true: Echo mode ON
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_echo_mode( bool echo )
+{ 
+	return bc66_send_at_command(BC66_CMD_EXE,bc66_cmd_list_ATE,NULL,"%c", '0' + (int)echo );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * EPS Network Registration Status. 
+ * Configures the different unsolicited result codes for EPS 
+ * Network Registration Status.
+ * 
+ * @param net : Disable or enable network registration URC. 
+ * - 0 Disable network registration URC 
+ * - 1 Enable network registration URC: +CEREG: <stat> 
+ * - 2 Enable network registration and location information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>]] 
+ * - 3 Enable network registration, location information and EMM cause value information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,<cause_type>,<reject_cause>]] 
+ * - 4 For a UE that requests PSM, enable network registration and location information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,,[,[<Active-Time>],[<Periodic-TAU>]]]]  
+ * - 5 For a UE that requests PSM, enable network registration, location information and EMM cause value information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,[<cause_type>],[<reject_cause>][,[<Active-Time>],[<Periodic-TAU>]]]]
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_eps( unsigned int set )
+{ 
+	if( set > 5 ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	return bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_CEREG, NULL, "%u", set );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Power Saving Mode Setting (PSM). 
+ * 
+ * @param mode 
+ * Integer type. Disable or enable the use of PSM in the UE 
+ * - 0 Disable the use of PSM 
+ * - 1 Enable the use of PSM 
+ * - 2 Disable the use of PSM and discard all parameters for PSM or, if available, reset to the default values.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_power_saving_mode( int mode )
+{
+	if( (0 <= mode) && (mode <= 2) ) {
+		return bc66_send_at_command(BC66_CMD_WRITE,bc66_cmd_list_CPSMS,NULL,"%c", '0' + (int)mode );
+	} else { 
+		return bc66_ret_out_of_range;
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Parse an IP address in a single pass: IPv4 (a1.a2.a3.a4), IPv6 as 16 dotted 
+ * octets or IPv6 hex groups (with "::"). 
+ * 
+ * @param str	: address text, without quotes. 
+ * @param len	: address length. 
+ * @param addr	: context to store the address. 
+ * 
+ * @return 
+ * true if it is a valid address.
+ */
+static bool _bc66_parse_ip( const char * str, size_t len, bc66_pdp_addr_t * addr )
+{
+	uint8_t bytes[16];
+	uint8_t n = 0;				// bytes stored
+	int gap = -1;				// "::" position in bytes
+	uint16_t dec = 0, hex = 0;
+	uint8_t digits = 0;			// digits in group
+	bool hex_digits = false;
+	char family = 0;			// '.' or ':' 
+	size_t i;
+
+	for( i = 0; i <= len; i++ ) {
+		char c = (i < len) ? str[i] : '\0';
+
+		if( (c >= '0') && (c <= '9') ) {
+			dec = dec * 10 + (c - '0');
+			hex = hex * 16 + (c - '0');
+		} else if( ((c | 0x20) >= 'a') && ((c | 0x20) <= 'f') ) {
+			hex = hex * 16 + ((c | 0x20) - 'a' + 10);
+			hex_digits = true;
+		} else if( (c == '.') || (c == ':') || (c == '\0') ) {
+			if( c && family && (c != family) ) {
+				return false;
+			}
+			if( c ) {
+				family = c;
+			}
+			if( digits ) {
+				// store group: octet or 16 bits 
+				if( family == ':' ) {
+					if( n > 14 ) {
+						return false;
+					}
+					bytes[n++] = hex >> 8;
+					bytes[n++] = hex & 0xFF;
+				} else {
+					if( hex_digits || (digits > 3) || (dec > 255) || (n > 15) ) {
+						return false;
+					}
+					bytes[n++] = dec;
+				}
+			} else if( !((c == ':') && (i == 0)) && !((c == '\0') && (gap == n)) ) {
+				// empty group, only valid around "::" 
+				return false;
+			}
+			if( (c == ':') && (i + 1 < len) && (str[i + 1] == ':') ) {
+				if( gap >= 0 ) {
+					return false;
+				}
+				gap = n;
+				i++;
+			} else if( (c == ':') && !digits ) {
+				return false;
+			}
+			dec = hex = 0;
+			digits = 0;
+			hex_digits = false;
+			continue;
+		} else {
+			return false;
+		}
+		if( ++digits > 4 ) {
+			return false;
+		}
+	}
+
+	if( (family == '.') && (n == 4) ) {
+		addr->v4.a1 = bytes[0];
+		addr->v4.a2 = bytes[1];
+		addr->v4.a3 = bytes[2];
+		addr->v4.a4 = bytes[3];
+		addr->ipv4 = true;
+		return true;
+	}
+	if( (family == '.') && (n == 16) ) {
+		memcpy( addr->v6.a, bytes, 16 );
+		addr->ipv6 = true;
+		return true;
+	}
+	if( (family == ':') && ((n == 16) || ((gap >= 0) && (n < 16))) ) {
+		// expand "::" with zeros 
+		memset( addr->v6.a, 0, 16 );
+		if( gap < 0 ) {
+			gap = n;
+		}
+		memcpy( addr->v6.a, bytes, gap );
+		memcpy( &addr->v6.a[16 - (n - gap)], &bytes[gap], n - gap );
+		addr->ipv6 = true;
+		return true;
+	}
+	return false;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Store a +CGPADDR: <cid>[,<PDP_addr_1>[,<PDP_addr_2>]] line in addresses cache. 
+ * Addresses are quoted or not, IPv4 first for dual stack contexts. 
+ * 
+ * @param line		: response line. 
+ * @param len		: line length. 
+ * @param partial	: line continues (never for this command). 
+ * @param arg		: not used. 
+ */
+static void _bc66_cgpaddr_line( const char * line, uint16_t len, bool partial, void * arg )
+{
+	const char prefix[] = "+CGPADDR:";
+	const char * end = line + len;
+	bc66_pdp_addr_t * addr;
+	(void)arg;
+
+	if( partial || (len < sizeof(prefix)) || strncmp( line, prefix, sizeof(prefix) - 1 ) || 
+		(bc66->drv.pdp_addr_count >= BC66_PDP_CONTEXTS) ) {
+		return;
+	}
+	addr = &bc66->drv.pdp_addr[bc66->drv.pdp_addr_count];
+	memset( addr, 0, sizeof(*addr) );
+	addr->cid = (uint8_t)atoi( line + sizeof(prefix) - 1 );
+
+	// address fields 
+	line = memchr( line, ',', len );
+	while( line && (line < end) ) {
+		const char * field = ++line;
+		const char * next = memchr( field, ',', end - field );
+		const char * stop = next ? next : end;
+		if( (stop - field >= 2) && (*field == '"') && (stop[-1] == '"') ) {
+			field ++;
+			stop --;
+		}
+		if( stop > field ) {
+			_bc66_parse_ip( field, stop - field, addr );
+		}
+		line = next;
+	}
+	bc66->drv.pdp_addr_count ++;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the addresses of a PDP context (AT+CGPADDR). Cached until a +CEREG, +IP 
+ * or +CGEV URC, or an AT+CGATT / AT+QCGDEFCONT write. 
+ * 
+ * @param cid	: PDP context identifier. 
+ * @param addr	: where addresses are copied. 
+ * 
+ * @return 
+ * bc66_ret_no_ip if the context has no address, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_pdp_address( uint8_t cid, bc66_pdp_addr_t * addr )
+{
+	bc66_ret_t ret_code;
+	uint8_t i;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( addr == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+	if( bc66->drv.cmd.busy ) { 
+		return bc66_ret_busy;
+	}
+
+	// pending URCs may invalidate the cache 
+	_bc66_rx_idle();
+
+	if( !bc66->drv.pdp_addr_valid ) { 
+		uint8_t gen = bc66->drv.pdp_addr_gen;
+		bc66->drv.pdp_addr_count = 0;
+		ret_code = bc66_send_at_command_lines( _bc66_cgpaddr_line, NULL, BC66_CMD_EXE, bc66_cmd_list_CGPADDR, NULL );
+		if( ret_code != bc66_ret_success ) { 
+			return ret_code;
+		}
+		// a URC during the command makes the answer old 
+		bc66->drv.pdp_addr_valid = (gen == bc66->drv.pdp_addr_gen);
+	}
+
+	for( i = 0; i < bc66->drv.pdp_addr_count; i++ ) { 
+		if( bc66->drv.pdp_addr[i].cid == cid ) { 
+			*addr = bc66->drv.pdp_addr[i];
+			return (addr->ipv4 || addr->ipv6) ? bc66_ret_success : bc66_ret_no_ip;
+		}
+	}
+	return bc66_ret_no_ip;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * This function returns the IPv4 address of the device (PDP context BC66_DEFAULT_CID). 
+ * 
+ * @param ip : pointer to struct variable to return IP ADDRESS (a1 is the first octet).
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */ 
+bc66_ret_t bc66_get_ipv4_address(bc66_ip_add_t * ip )
+{
+	bc66_pdp_addr_t addr;
+	bc66_ret_t ret_code = bc66_get_pdp_address( BC66_DEFAULT_CID, &addr );
+
+	if( ret_code != bc66_ret_success ) { 
+		return ret_code;
+	}
+	if( !addr.ipv4 ) { 
+		return bc66_ret_no_ip;
+	}
+	*ip = addr.v4;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * This function returns the IPv6 address of the device (PDP context BC66_DEFAULT_CID). 
+ * 
+ * @param ip : pointer to struct variable to return IPv6 ADDRESS.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */ 
+bc66_ret_t bc66_get_ipv6_address(bc66_ip6_add_t * ip )
+{
+	bc66_pdp_addr_t addr;
+	bc66_ret_t ret_code = bc66_get_pdp_address( BC66_DEFAULT_CID, &addr );
+
+	if( ret_code != bc66_ret_success ) { 
+		return ret_code;
+	}
+	if( !addr.ipv6 ) { 
+		return bc66_ret_no_ip;
+	}
+	*ip = addr.v6;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Time Zone Reporting. Time zone URCs update the zone returned by \p bc66_get_time_zone(...), 
+ * +CTZEU also synchronizes the network time. 
+ * 
+ * @param mode : 
+ * - 0 Disable time zone URC 
+ * - 1 Enable time zone URC: +CTZV: <tz> 
+ * - 2 Enable extended time zone and local time URC: +CTZE: <tz>,<dst>,<time> 
+ * - 3 Enable extended time zone and UTC time URC: +CTZEU: <tz>,<dst>,<utime> 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_time_zone_report( unsigned int mode )
+{
+	if( mode > 3 ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	return bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_CTZR, NULL, "%u", mode );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Store a +CCLK: <time> line: time is taken when the line is received. 
+ * 
+ * @param line		: response line. 
+ * @param len		: line length. 
+ * @param partial	: line continues (never for this command). 
+ * @param arg		: not used. 
+ */
+static void _bc66_cclk_line( const char * line, uint16_t len, bool partial, void * arg )
+{
+	const char prefix[] = "+CCLK:";
+	uint32_t utc;
+	int8_t tz = INT8_MIN;
+	(void)arg;
+
+	if( partial || (len < sizeof(prefix)) || strncmp( line, prefix, sizeof(prefix) - 1 ) ) {
+		return;
+	}
+	if( _bc66_parse_clock( line + sizeof(prefix) - 1, line + len, &utc, &tz ) ) { 
+		_bc66_time_set( utc );
+		if( tz != INT8_MIN ) { 
+			bc66->drv.time.tz = tz;
+			bc66->drv.time.tz_valid = true;
+		}
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Synchronize network time (AT+CCLK?). The UTC time is stored against \p func_get_tick 
+ * so \p bc66_get_utc_time(...) does not use the UART. 
+ * 
+ * @return 
+ * bc66_ret_no_time if the module has no network time yet (not attached) or 
+ * \p func_get_tick is missing, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_sync_network_time( void )
+{
+	bc66_ret_t ret_code;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( bc66->func_get_tick == NULL ) { 
+		return bc66_ret_no_time;
+	}
+
+	bc66->drv.time.valid = false;
+	ret_code = bc66_send_at_command_lines( _bc66_cclk_line, NULL, BC66_CMD_READ, bc66_cmd_list_CCLK, NULL );
+	if( ret_code != bc66_ret_success ) { 
+		return ret_code;
+	}
+	return bc66->drv.time.valid ? bc66_ret_success : bc66_ret_no_time;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get UTC time from the last network time synchronization and \p func_get_tick. 
+ * No AT command is sent. Call it at least once every 49 days (tick wrap). 
+ * 
+ * @param utc : seconds since 1970-01-01 00:00:00 UTC. 
+ * 
+ * @return 
+ * bc66_ret_no_time if network time was never synchronized, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_utc_time( uint32_t * utc )
+{
+	uint32_t seconds;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( !bc66->drv.time.valid ) { 
+		return bc66_ret_no_time;
+	}
+
+	// move the reference forward, so tick can wrap 
+	seconds = (bc66->func_get_tick() - bc66->drv.time.tick) / 1000;
+	bc66->drv.time.utc += seconds;
+	bc66->drv.time.tick += seconds * 1000;
+	*utc = bc66->drv.time.utc;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get network time zone (last AT+CCLK? or time zone URC). 
+ * 
+ * @param quarters : time zone in quarters of an hour, i.e. +32 for UTC+8. 
+ * 
+ * @return 
+ * bc66_ret_no_time if the time zone is not known, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_time_zone( int8_t * quarters )
+{
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( !bc66->drv.time.tz_valid ) { 
+		return bc66_ret_no_time;
+	}
+
+	*quarters = bc66->drv.time.tz;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set Default PSD Connection
+ * 
+ * This command sets the PSD connection settings for PDN connection on power-up. 
+ * When attaching to the NB-IoT network on power-on, a PDN connection setup must be performed. 
+ * In order to allow this to happen, PDN connection settings must be stored in NVRAM, 
+ * thus making it to be used by the modem during the attach procedure.
+ * 
+ * @param pdp_type 	: Specify the type of packet data protocol. 
+ * @param apn 		: A logical name that is used to select the GGSN or the external packet data network. The maximum configurable APN length is 99 bytes.
+ * @param user		: The user name for accessing to the IP network. (Optional)
+ * @param pass		: The password for accessing to the IP network. (Optional)
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_psd_conn(pdp_type_t pdp_type, const char * apn, const char * user, const char * pass )
+{
+	char * pdp = (char *)_bc66_arena_alloc( BC66_PDP_ARGS_SIZE );
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( pdp == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+	switch( pdp_type ) 
+	{
+		case pdp_type_ip: 
+			strcpy(pdp,"\"IP\"");
+			break; 
+		
+		case pdp_type_ipv6: 
+			strcpy(pdp,"\"IPV6\"");
+			break; 
+		
+		case pdp_type_ipv4v6: 
+			strcpy(pdp,"\"IPV4V6\"");
+			break; 
+		
+		case pdp_type_non_ip: 
+			strcpy(pdp,"\"Non-IP\"");
+			break; 
+
+		default: 
+			return bc66_ret_out_of_range;
+	}
+	if( apn == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+	if( (strlen(apn) > BC66_APN_MAX_LEN) || 
+		(user && (strlen(user) > BC66_PSD_USER_MAX_LEN)) || 
+		(pass && (strlen(pass) > BC66_PSD_PASS_MAX_LEN)) ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	strcat(pdp,",\"");
+	strcat(pdp,apn);
+	strcat(pdp,"\"");
+
+	if( user ) { 
+		strcat(pdp,",\"");
+		strcat(pdp,user);
+		strcat(pdp,"\"");
+	}
+
+	if( pass ) { 
+		strcat(pdp,",\"");
+		strcat(pdp,pass);
+		strcat(pdp,"\"");
+	}
+
+	return bc66_send_at_command(BC66_CMD_WRITE,bc66_cmd_list_QCGDEFCONT,NULL,"%s", pdp);
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set Mobile Operation Band.
+ * 
+ * @param band_numb : band quantity. 
+ * - 0 all bands. 
+ * - 1 to 16 Number of bands to be locked.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_mobile_bands( int band_number, ... )
+{ 
+	va_list bands;
+	uint8_t band_list[BC66_MAX_LOCKED_BANDS];
+
+	if( (band_number < 0) || (band_number > BC66_MAX_LOCKED_BANDS) ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	if( band_number ) {
+		va_start( bands, band_number );
+	}
+
+	for( int n = 0 ; n < band_number ; n ++ ) {
+		band_list[n] = (uint8_t)va_arg( bands, int );
+	}
+	
+	if( band_number ) {
+		va_end( bands );
+	}
+
+	return bc66_set_mobile_band_list( band_list, (uint8_t)band_number );
+}
+
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Store a +QENG: line in the snapshot. 
+ * - +QENG: 0,<earfcn>,<earfcn_offset>,<pci>,<cellID>,[<RSRP>],[<RSRQ>],[<RSSI>],[<SINR>],<band>,<TAC>,[<ECL>],[<Tx_pwr>],<op_mode> 
+ * - +QENG: 1,<earfcn>,<earfcn_offset>,<pci>,<RSRP> 
+ * 
+ * @param line		: response line. 
+ * @param len		: line length. 
+ * @param partial	: line continues (never for this command). 
+ * @param arg		: \p bc66_cell_info_t snapshot. 
+ */
+static void _bc66_qeng_line( const char * line, uint16_t len, bool partial, void * arg )
+{
+	const char prefix[] = "+QENG:";
+	bc66_cell_info_t * info = arg;
+	const char * end = line + len;
+	const char * pos = line + sizeof(prefix) - 1;
+	const char * field;
+	int32_t v[14];
+	uint32_t hex[2] = { 0, 0 };
+	size_t flen;
+	uint8_t n = 0;
+
+	if( partial || (len < sizeof(prefix)) || strncmp( line, prefix, sizeof(prefix) - 1 ) ) {
+		return;
+	}
+
+	// fields: <cellID> and <TAC> are hex strings 
+	while( (n < 14) && ((field = _bc66_next_field( &pos, end, &flen )) != NULL) ) {
+		if( (n == 4) || (n == 10) ) {
+			hex[n == 10] = (uint32_t)strtoul( field, NULL, 16 );
+		}
+		if( !flen || !_bc66_parse_int( field, field + flen, &v[n] ) ) {
+			v[n] = BC66_CELL_NO_VALUE;
+		}
+		n ++;
+	}
+
+	if( (n >= 14) && (v[0] == 0) ) { 
+		info->camped = true;
+		info->earfcn = (uint32_t)v[1];
+		info->earfcn_offset = (int16_t)v[2];
+		info->pci = (uint16_t)v[3];
+		info->cell_id = hex[0];
+		info->rsrp = (int16_t)v[5];
+		info->rsrq = (int16_t)v[6];
+		info->rssi = (int16_t)v[7];
+		info->sinr = (int16_t)v[8];
+		info->band = (uint8_t)v[9];
+		info->tac = (uint16_t)hex[1];
+		info->ecl = ((v[11] >= 0) && (v[11] <= 2)) ? (bc66_ecl_t)v[11] : bc66_ecl_unknown;
+		info->tx_pwr = (int16_t)v[12];
+		info->op_mode = (uint8_t)v[13];
+	} else if( (n >= 5) && (v[0] == 1) && (info->ncell_count < BC66_MAX_NEIGHBOUR_CELLS) ) { 
+		bc66_ncell_t * ncell = &info->ncell[info->ncell_count++];
+		ncell->earfcn = (uint32_t)v[1];
+		ncell->earfcn_offset = (int16_t)v[2];
+		ncell->pci = (uint16_t)v[3];
+		ncell->rsrp = (int16_t)v[4];
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Engineering mode snapshot (AT+QENG=0): serving cell radio values, coverage 
+ * enhancement level and neighbour cells. Response lines are parsed while 
+ * they are received, no response buffer is needed. 
+ * 
+ * @param info : snapshot. Values not reported by the module are BC66_CELL_NO_VALUE. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_cell_info( bc66_cell_info_t * info )
+{
+	if( info == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	if( !bc66_has_cap( BC66_CAP_QENG ) ) { 
+		return bc66_ret_no_cmd_implemented;
+	}
+
+	memset( info, 0, sizeof(*info) );
+	info->ecl = bc66_ecl_unknown;
+	return bc66_send_at_command_lines( _bc66_qeng_line, info, BC66_CMD_WRITE, bc66_cmd_list_QENG, "0" );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get serving cell coverage enhancement level (ECL). Transmission energy grows 
+ * with the level: ECL2 uses many repetitions of ECL0 packets. 
+ * 
+ * @param ecl : coverage enhancement level, bc66_ecl_unknown if not camped. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_coverage_level( bc66_ecl_t * ecl )
+{
+	bc66_cell_info_t info;
+	bc66_ret_t ret_code = bc66_get_cell_info( &info );
+
+	if( ret_code == bc66_ret_success ) { 
+		*ecl = info.ecl;
+	}
+	return ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set Mobile Operation Band from a list. 
+ * 
+ * @param bands	: bands to lock. 
+ * @param count	: band quantity, 0 for all bands. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_mobile_band_list( const uint8_t * bands, uint8_t count )
+{ 
+	char * all_bands = (char *)_bc66_arena_alloc( BC66_BANDS_ARGS_SIZE );
+	size_t len;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (all_bands == NULL) || (count > BC66_MAX_LOCKED_BANDS) || (count && (bands == NULL)) ) { 
+		return bc66_ret_out_of_range;
+	}
+	len = sprintf( all_bands, "%u", count );
+	for( uint8_t n = 0 ; n < count ; n ++ ) {
+		len += sprintf( &all_bands[len], ",%u", bands[n] );
+	}
+
+	return bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_QBAND, NULL,"%s", all_bands );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Store a +QBAND: <band>[,<band>...] line. Unlike the write command, the read 
+ * answer has no band count. 
+ * 
+ * @param line		: response line. 
+ * @param len		: line length. 
+ * @param partial	: line continues (never for this command). 
+ * @param arg		: \p uint8_t bands buffer, count is stored in \p net_cache.band_count. 
+ */
+static void _bc66_qband_line( const char * line, uint16_t len, bool partial, void * arg )
+{
+	const char prefix[] = "+QBAND:";
+	const char * end = line + len;
+	const char * pos = line + sizeof(prefix) - 1;
+	const char * field;
+	uint8_t * bands = arg;
+	int32_t value;
+	size_t flen;
+
+	if( partial || (len < sizeof(prefix)) || strncmp( line, prefix, sizeof(prefix) - 1 ) ) {
+		return;
+	}
+	bc66->drv.net_cache.band_count = 0;
+	while( (bc66->drv.net_cache.band_count < BC66_MAX_LOCKED_BANDS) && ((field = _bc66_next_field( &pos, end, &flen )) != NULL) ) {
+		if( flen && _bc66_parse_int( field, field + flen, &value ) && (value > 0) && (value <= UINT8_MAX) ) {
+			bands[bc66->drv.net_cache.band_count++] = (uint8_t)value;
+		}
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get Mobile Operation Band (AT+QBAND?). 
+ * 
+ * @param bands	: buffer of BC66_MAX_LOCKED_BANDS bands. 
+ * @param count	: bands returned. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_mobile_bands( uint8_t * bands, uint8_t * count )
+{
+	bc66_ret_t ret_code;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (bands == NULL) || (count == NULL) ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	bc66->drv.net_cache.band_count = 0;
+	ret_code = bc66_send_at_command_lines( _bc66_qband_line, bands, BC66_CMD_READ, bc66_cmd_list_QBAND, NULL );
+	*count = bc66->drv.net_cache.band_count;
+	return ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Store <stat> of a +CEREG: line. 
+ * 
+ * @param line		: response line. 
+ * @param len		: line length. 
+ * @param partial	: line continues (never for this command). 
+ * @param arg		: \p uint8_t status. 
+ */
+static void _bc66_cereg_line( const char * line, uint16_t len, bool partial, void * arg )
+{
+	const char prefix[] = "+CEREG:";
+
+	if( partial || (len < sizeof(prefix)) || strncmp( line, prefix, sizeof(prefix) - 1 ) ) {
+		return;
+	}
+	_bc66_cereg_stat( line, len, (uint8_t *)arg );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get EPS network registration status (AT+CEREG?). 
+ * 
+ * @param stat : 
+ * - 0 Not registered, not searching 
+ * - 1 Registered, home network 
+ * - 2 Not registered, searching 
+ * - 3 Registration denied 
+ * - 4 Unknown 
+ * - 5 Registered, roaming 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_registration( uint8_t * stat )
+{
+	if( stat == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	*stat = 4;
+	return bc66_send_at_command_lines( _bc66_cereg_line, stat, BC66_CMD_READ, bc66_cmd_list_CEREG, NULL );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * PS Attach or Detach (AT+CGATT). Blocks until the module answers (up to 85 s). 
+ * 
+ * @param attach : true to attach, false to detach. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_attach( bool attach )
+{
+	return bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_CGATT, NULL, "%u", (unsigned int)attach );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Start the network bring-up without blocking: SIM ready, registration, PDP context 
+ * active and IP address. Stages advance on URCs (+CPIN, +CEREG, +CGEV, +IP); while 
+ * a stage waits, its state is queried every \p poll ms in case the URC is disabled 
+ * or was missed. Progress is reported from \p bc66_process(), which must be called 
+ * periodically. Needs \p func_get_tick. 
+ * 
+ * @param cfg		: stage timeouts, poll period and PDP context, NULL for defaults 
+ * (SIM 10 s, registration 180 s, PDP 30 s, IP 30 s, poll 2 s, BC66_DEFAULT_CID). 
+ * @param cb		: progress callback. 
+ * @param arg		: callback user argument. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_attach_start( const bc66_attach_cfg_t * cfg, bc66_attach_cb_t cb, void * arg )
+{
+	static const bc66_attach_cfg_t default_cfg = { { 10000, 180000, 30000, 30000 }, 2000, BC66_DEFAULT_CID, false };
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( bc66->func_get_tick == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	memset( &bc66->drv.attach, 0, sizeof(bc66->drv.attach) );
+	bc66->drv.attach.cfg = cfg ? *cfg : default_cfg;
+	bc66->drv.attach.cb = cb;
+	bc66->drv.attach.arg = arg;
+	bc66->drv.attach.start = bc66->func_get_tick();
+	bc66->drv.attach.stage_start = bc66->drv.attach.start;
+	bc66->drv.attach.last_probe = bc66->drv.attach.start - bc66->drv.attach.cfg.poll;
+	bc66->drv.attach.stage = bc66_attach_sim;
+	bc66->drv.reg_stat = 4;
+	bc66->drv.attach.active = true;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Stop the bring-up. The running query, if any, ends normally. 
+ */
+void bc66_attach_cancel( void )
+{
+	if( bc66 ) { 
+		bc66->drv.attach.active = false;
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get how long a bring-up stage took. 
+ * 
+ * @param stage		: stage, bc66_attach_done for the whole bring-up. 
+ * @param latency	: stage duration [ms], 0 if the stage did not end. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_attach_get_latency( bc66_attach_stage_t stage, uint32_t * latency )
+{
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (stage > bc66_attach_done) || (latency == NULL) ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	*latency = bc66->drv.attach.latency[stage];
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set the last known good network (band, EARFCN, PLMN) kept by the host, i.e. 
+ * read from flash at power on, and the hook to store it when it changes. 
+ * 
+ * @param stored	: last known good network, NULL if there is not. 
+ * @param save		: called when \p bc66_net_cache_capture() finds a new network (optional). 
+ * @param arg		: hook user argument. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_net_cache_init( const bc66_net_cache_t * stored, bc66_net_cache_save_t save, void * arg )
+{
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+
+	memset( &bc66->drv.net_cache, 0, sizeof(bc66->drv.net_cache) );
+	if( stored && stored->valid ) { 
+		bc66->drv.net_cache.lkg = *stored;
+		bc66->drv.net_cache.lkg.plmn[BC66_PLMN_SIZE - 1] = '\0';
+	}
+	bc66->drv.net_cache.save = save;
+	bc66->drv.net_cache.arg = arg;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the last known good network. 
+ * 
+ * @param cache : last known good network copy. 
+ * 
+ * @return 
+ * bc66_ret_fail if there is not a known network, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_net_cache_get( bc66_net_cache_t * cache )
+{
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( !bc66->drv.net_cache.lkg.valid ) { 
+		return bc66_ret_fail;
+	}
+
+	*cache = bc66->drv.net_cache.lkg;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Store a +COPS: <mode>[,<format>,<oper>[,<AcT>]] line: <format> in 
+ * \p net_cache.cops_format and <oper> if it is numeric. 
+ * 
+ * @param line		: response line. 
+ * @param len		: line length. 
+ * @param partial	: line continues (never for this command). 
+ * @param arg		: PLMN buffer of BC66_PLMN_SIZE chars. 
+ */
+static void _bc66_cops_line( const char * line, uint16_t len, bool partial, void * arg )
+{
+	const char prefix[] = "+COPS:";
+	const char * end = line + len;
+	const char * pos = line + sizeof(prefix) - 1;
+	const char * field;
+	char * plmn = arg;
+	int32_t format;
+	size_t flen;
+
+	if( partial || (len < sizeof(prefix)) || strncmp( line, prefix, sizeof(prefix) - 1 ) ) {
+		return;
+	}
+	if( !_bc66_next_field( &pos, end, &flen ) || ((field = _bc66_next_field( &pos, end, &flen )) == NULL) || 
+		!flen || !_bc66_parse_int( field, field + flen, &format ) ) { 
+		return;
+	}
+	bc66->drv.net_cache.cops_format = (uint8_t)format;
+	if( (format == 2) && ((field = _bc66_next_field( &pos, end, &flen )) != NULL) && flen && (flen < BC66_PLMN_SIZE) ) { 
+		memcpy( plmn, field, flen );
+		plmn[flen] = '\0';
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Store the serving network as last known good (AT+QENG=0, AT+COPS?). Call it 
+ * once registered. The save hook is called if band, EARFCN or PLMN changed. 
+ * If the operator is not reported in numeric format, it is read again with 
+ * AT+COPS=3,2 and the previous format is restored. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_net_cache_capture( void )
+{
+	bc66_cell_info_t info;
+	bc66_net_cache_t lkg;
+	bc66_ret_t ret_code;
+	uint8_t format;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (ret_code = bc66_get_cell_info( &info )) != bc66_ret_success ) { 
+		return ret_code;
+	}
+	if( !info.camped ) { 
+		return bc66_ret_fail;
+	}
+
+	memset( &lkg, 0, sizeof(lkg) );
+	lkg.valid = true;
+	lkg.band = info.band;
+	lkg.earfcn = info.earfcn;
+	lkg.earfcn_offset = info.earfcn_offset;
+	// numeric operator format, then back to the application format 
+	bc66->drv.net_cache.cops_format = 0;
+	bc66_send_at_command_lines( _bc66_cops_line, lkg.plmn, BC66_CMD_READ, bc66_cmd_list_COPS, NULL );
+	format = bc66->drv.net_cache.cops_format;
+	if( (lkg.plmn[0] == '\0') && (bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_COPS, NULL, "3,2" ) == bc66_ret_success) ) { 
+		bc66_send_at_command_lines( _bc66_cops_line, lkg.plmn, BC66_CMD_READ, bc66_cmd_list_COPS, NULL );
+		bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_COPS, NULL, "3,%u", format );
+	}
+
+	if( memcmp( &lkg, &bc66->drv.net_cache.lkg, sizeof(lkg) ) ) { 
+		bc66->drv.net_cache.lkg = lkg;
+		if( bc66->drv.net_cache.save ) { 
+			bc66->drv.net_cache.save( &lkg, bc66->drv.net_cache.arg );
+		}
+	}
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * AT+COPS=1 end. 
+ * 
+ * @param ret_code	: command result. 
+ * @param arg		: not used. 
+ */
+static void _bc66_cops_done( bc66_ret_t ret_code, void * arg )
+{
+	(void)arg;
+	bc66->drv.net_cache.cops_pending = false;
+	bc66->drv.net_cache.cops_ret = ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Lock the search to the last known good network: band (AT+QBAND), EARFCN 
+ * (AT+QLOCKF) and PLMN (AT+COPS=1, asynchronous). Poll with \p bc66_net_cache_poll(): 
+ * if the module is not registered before \p deadline, locks are released and 
+ * the module goes back to a full scan. 
+ * 
+ * @param deadline : max time to register on the locked network [ms]. 
+ * 
+ * @return 
+ * bc66_ret_fail if there is not a known network, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_net_cache_lock( uint32_t deadline )
+{
+	bc66_net_cache_t * lkg;
+	bc66_ret_t ret_code;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	lkg = &bc66->drv.net_cache.lkg;
+	if( !lkg->valid ) { 
+		return bc66_ret_fail;
+	}
+
+	// bands to go back to (locks are kept after a successful search) 
+	if( !bc66->drv.net_cache.bands_saved ) { 
+		if( bc66_get_mobile_bands( bc66->drv.net_cache.bands, &bc66->drv.net_cache.band_count ) != bc66_ret_success ) { 
+			bc66->drv.net_cache.band_count = 0;
+		}
+		bc66->drv.net_cache.bands_saved = true;
+	}
+	bc66->drv.net_cache.locked = true;
+	bc66->drv.net_cache.cops_pending = false;
+	bc66->drv.net_cache.cops_ret = bc66_ret_success;
+	bc66->drv.net_cache.start = bc66->func_get_tick ? bc66->func_get_tick() : 0;
+	bc66->drv.net_cache.deadline = deadline;
+
+	if( ((ret_code = bc66_set_mobile_band_list( &lkg->band, 1 )) != bc66_ret_success) || 
+		(bc66_has_cap( BC66_CAP_QLOCKF ) && 
+		((ret_code = bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_QLOCKF, NULL, "1,%lu,%d", (unsigned long)lkg->earfcn, lkg->earfcn_offset )) != bc66_ret_success)) ) { 
+		bc66_net_cache_unlock();
+		return ret_code;
+	}
+
+	// PLMN selection answers after the search: do not block, the deadline is its timeout 
+	if( lkg->plmn[0] ) { 
+		ret_code = bc66_cmd_start( _bc66_cops_done, NULL, BC66_CMD_WRITE, bc66_cmd_list_COPS, NULL, "1,2,\"%s\"", lkg->plmn );
+		if( ret_code != bc66_ret_success ) { 
+			bc66_net_cache_unlock();
+			return ret_code;
+		}
+		bc66->drv.cmd.timeout = deadline;
+		bc66->drv.net_cache.cops_pending = true;
+	}
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check a locked search. Once registered the network is captured again and locks 
+ * are kept; on deadline or PLMN selection error locks are released (full scan). 
+ * 
+ * @return 
+ * - bc66_ret_busy while the module is searching 
+ * - bc66_ret_success when registered (or no locked search) 
+ * - bc66_ret_timeout when the fallback to full scan was done 
+ */
+bc66_ret_t bc66_net_cache_poll( void )
+{
+	uint8_t stat;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( !bc66->drv.net_cache.locked ) { 
+		return bc66_ret_success;
+	}
+	if( bc66->drv.net_cache.cops_pending ) { 
+		bc66_process();
+		if( bc66->drv.net_cache.cops_pending ) { 
+			return bc66_ret_busy;
+		}
+	}
+	if( bc66->drv.net_cache.cops_ret != bc66_ret_success ) { 
+		bc66_net_cache_unlock();
+		return bc66_ret_timeout;
+	}
+
+	if( (bc66_get_registration( &stat ) == bc66_ret_success) && ((stat == 1) || (stat == 5)) ) { 
+		bc66->drv.net_cache.locked = false;
+		bc66_net_cache_capture();
+		return bc66_ret_success;
+	}
+	if( bc66->func_get_tick && ((uint32_t)(bc66->func_get_tick() - bc66->drv.net_cache.start) >= bc66->drv.net_cache.deadline) ) { 
+		bc66_net_cache_unlock();
+		return bc66_ret_timeout;
+	}
+	return bc66_ret_busy;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Release band, EARFCN and PLMN locks: bands before \p bc66_net_cache_lock(...), 
+ * AT+QLOCKF=0 and automatic PLMN selection. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_net_cache_unlock( void )
+{
+	bc66_ret_t ret_code;
+	bc66_ret_t ret_err = bc66_ret_success;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( bc66->drv.cmd.busy ) { 
+		return bc66_ret_busy;
+	}
+
+	bc66->drv.net_cache.locked = false;
+	bc66->drv.net_cache.bands_saved = false;
+	if( (ret_code = bc66_set_mobile_band_list( bc66->drv.net_cache.bands, bc66->drv.net_cache.band_count )) != bc66_ret_success ) { 
+		ret_err = ret_code;
+	}
+	if( bc66_has_cap( BC66_CAP_QLOCKF ) && 
+		((ret_code = bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_QLOCKF, NULL, "0" )) != bc66_ret_success) ) { 
+		ret_err = ret_code;
+	}
+	if( (ret_code = bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_COPS, NULL, "0" )) != bc66_ret_success ) { 
+		ret_err = ret_code;
+	}
+	return ret_err;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Enter PIN AT command.
+ * Return bc66_ret_success if Modem is READY.
+ * 
+ * The SIM state is cached from +CPIN lines (URC or AT+CPIN? answer): once the 
+ * SIM is ready no command is sent until a +CPIN URC reports another state. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_is_ready( void )
 { 
-	return bc66_send_at_command(BC66_CMD_EXE,bc66_cmd_list_ATE,NULL,"%c", '0' + (int)echo );
+	if( bc66 && bc66->drv.sim.known && bc66->drv.sim.ready ) { 
+		return bc66_ret_success;
+	}
+	return bc66_send_at_command(BC66_CMD_READ,bc66_cmd_list_CPIN,"+CPIN: READY",NULL);
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Store the AT+CIMI answer line (digits only). 
+ * 
+ * @param line		: response line. 
+ * @param len		: line length. 
+ * @param partial	: line continues (never for this command). 
+ * @param arg		: not used. 
+ */
+static void _bc66_cimi_line( const char * line, uint16_t len, bool partial, void * arg )
+{
+	uint16_t i;
+	(void)arg;
+
+	if( partial || (len < 6) || (len >= BC66_IMSI_SIZE) ) {
+		return;
+	}
+	for( i = 0; i < len; i++ ) { 
+		if( (line[i] < '0') || (line[i] > '9') ) { 
+			return;
+		}
+	}
+	memcpy( bc66->drv.sim.imsi, line, len );
+	bc66->drv.sim.imsi[len] = '\0';
+	bc66->drv.sim.imsi_valid = true;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the International Mobile Subscriber Identity (AT+CIMI). Read once and 
+ * cached until the SIM state changes. 
+ * 
+ * @param imsi	: IMSI string buffer. 
+ * @param size	: buffer size, at least BC66_IMSI_SIZE. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_imsi( char * imsi, size_t size )
+{
+	bc66_ret_t ret_code;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (imsi == NULL) || (size < BC66_IMSI_SIZE) ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	if( !bc66->drv.sim.imsi_valid ) { 
+		ret_code = bc66_send_at_command_lines( _bc66_cimi_line, NULL, BC66_CMD_EXE, bc66_cmd_list_CIMI, NULL );
+		if( ret_code != bc66_ret_success ) { 
+			return ret_code;
+		}
+		if( !bc66->drv.sim.imsi_valid ) { 
+			return bc66_ret_fail;
+		}
+	}
+	strcpy( imsi, bc66->drv.sim.imsi );
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Store a +QCCID: <ICCID> line. 
+ * 
+ * @param line		: response line. 
+ * @param len		: line length. 
+ * @param partial	: line continues (never for this command). 
+ * @param arg		: not used. 
+ */
+static void _bc66_qccid_line( const char * line, uint16_t len, bool partial, void * arg )
+{
+	const char prefix[] = "+QCCID:";
+	const char * end = line + len;
+	const char * pos = line + sizeof(prefix) - 1;
+	const char * field;
+	size_t flen;
+	(void)arg;
+
+	if( partial || (len < sizeof(prefix)) || strncmp( line, prefix, sizeof(prefix) - 1 ) ) {
+		return;
+	}
+	if( ((field = _bc66_next_field( &pos, end, &flen )) != NULL) && flen && (flen < BC66_ICCID_SIZE) ) { 
+		memcpy( bc66->drv.sim.iccid, field, flen );
+		bc66->drv.sim.iccid[flen] = '\0';
+		bc66->drv.sim.iccid_valid = true;
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the USIM card identification (AT+QCCID). Read once and cached until the 
+ * SIM state changes. 
+ * 
+ * @param iccid	: ICCID string buffer. 
+ * @param size	: buffer size, at least BC66_ICCID_SIZE. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_iccid( char * iccid, size_t size )
+{
+	bc66_ret_t ret_code;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (iccid == NULL) || (size < BC66_ICCID_SIZE) ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	if( !bc66->drv.sim.iccid_valid ) { 
+		ret_code = bc66_send_at_command_lines( _bc66_qccid_line, NULL, BC66_CMD_EXE, bc66_cmd_list_QCCID, NULL );
+		if( ret_code != bc66_ret_success ) { 
+			return ret_code;
+		}
+		if( !bc66->drv.sim.iccid_valid ) { 
+			return bc66_ret_fail;
+		}
+	}
+	strcpy( iccid, bc66->drv.sim.iccid );
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/// Optional commands tested by \p bc66_probe_capabilities(). 
+static const struct {
+	bc66_cmd_list_t 	cmd;				///< command tested with AT+<cmd>=?
+	bc66_cap_t 			cap;				///< capability of the command
+} _bc66_cap_probes[] = {
+	{ bc66_cmd_list_QNBIOTRAI,	BC66_CAP_RAI },
+	{ bc66_cmd_list_QENG,		BC66_CAP_QENG },
+	{ bc66_cmd_list_QLOCKF,		BC66_CAP_QLOCKF },
+	{ bc66_cmd_list_CTZR,		BC66_CAP_CTZR },
+};
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Store an ATI / AT+CGMR line: manufacturer, model and "Revision: <revision>". 
+ * 
+ * @param line		: response line. 
+ * @param len		: line length. 
+ * @param partial	: line continues (never for these commands). 
+ * @param arg		: identification lines already received. 
+ */
+static void _bc66_ati_line( const char * line, uint16_t len, bool partial, void * arg )
+{
+	const char prefix[] = "Revision:";
+	uint8_t * count = (uint8_t *)arg;
+	char * dst;
+
+	// skip URCs 
+	if( partial || (line[0] == '+') ) {
+		return;
+	}
+	if( (len >= sizeof(prefix) - 1) && !strncmp( line, prefix, sizeof(prefix) - 1 ) ) { 
+		line += sizeof(prefix) - 1;
+		len -= sizeof(prefix) - 1;
+		while( len && (*line == ' ') ) { 
+			line ++;
+			len --;
+		}
+		dst = bc66->drv.fw.revision;
+	} else if( *count == 0 ) { 
+		dst = bc66->drv.fw.manufacturer;
+	} else if( *count == 1 ) { 
+		dst = bc66->drv.fw.model;
+	} else { 
+		dst = bc66->drv.fw.revision;
+	}
+	(*count) ++;
+
+	if( len >= BC66_FW_ID_SIZE ) { 
+		len = BC66_FW_ID_SIZE - 1;
+	}
+	memcpy( dst, line, len );
+	dst[len] = '\0';
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get revision and edition numbers from a revision like "BC66NBR01A07". 
+ * 
+ * @param fw : firmware information with the revision string. 
+ */
+static void _bc66_parse_revision( bc66_fw_info_t * fw )
+{
+	const char * end = fw->revision + strlen( fw->revision );
+	const char * pos;
+	const char * ed;
+	int32_t major;
+	int32_t minor;
+
+	for( pos = fw->revision; (pos = strchr( pos, 'R' )) != NULL; pos ++ ) { 
+		if( (pos[1] >= '0') && (pos[1] <= '9') && 
+			((ed = _bc66_parse_int( pos + 1, end, &major )) != NULL) && (*ed == 'A') && 
+			(ed[1] >= '0') && (ed[1] <= '9') && _bc66_parse_int( ed + 1, end, &minor ) ) { 
+			fw->major = (uint8_t)major;
+			fw->minor = (uint8_t)minor;
+			return;
+		}
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Probe product identification (ATI, AT+CGMR if ATI has not the revision) and 
+ * firmware capabilities: optional commands are tested (AT+<cmd>=?). Call it 
+ * once the module answers. The revision numbers are informational only. Data 
+ * mode and publish_max are not probed (AT+QMTPUB=? answers the same with or 
+ * without it): they are set to the data mode values and only dropped the first 
+ * time the module answers the prompt request with +CME ERROR: 4 (not supported). 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_probe_capabilities( void )
+{
+	bc66_fw_info_t * fw;
+	bc66_ret_t ret_code;
+	uint8_t count = 0;
+	size_t i;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	fw = &bc66->drv.fw;
+	memset( fw, 0, sizeof(*fw) );
+
+	ret_code = bc66_send_at_command_lines( _bc66_ati_line, &count, BC66_CMD_EXE, bc66_cmd_list_ATI, NULL );
+	if( (ret_code == bc66_ret_success) && (fw->revision[0] == '\0') ) { 
+		count = 2;
+		ret_code = bc66_send_at_command_lines( _bc66_ati_line, &count, BC66_CMD_EXE, bc66_cmd_list_CGMR, NULL );
+	}
+	if( ret_code != bc66_ret_success ) { 
+		return ret_code;
+	}
+	_bc66_parse_revision( fw );
+
+	// an unknown command is answered with ERROR, no answer is a failed probe 
+	for( i = 0; i < sizeof(_bc66_cap_probes) / sizeof(_bc66_cap_probes[0]); i++ ) { 
+		ret_code = bc66_send_at_command( BC66_CMD_TEST, _bc66_cap_probes[i].cmd, NULL, NULL );
+		if( ret_code == bc66_ret_success ) { 
+			fw->caps |= _bc66_cap_probes[i].cap;
+		} else if( ret_code == bc66_ret_timeout ) { 
+			return ret_code;
+		}
+	}
+
+	// not probed: assumed until the first +CME ERROR: 4 to the prompt request 
+	fw->caps |= BC66_CAP_DATA_MODE;
+	fw->publish_max = BC66_MQTT_DATA_MODE_MAX_LEN;
+	fw->valid = true;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the product identification and capabilities found by \p bc66_probe_capabilities(). 
+ * 
+ * @param info : firmware information. 
+ * 
+ * @return 
+ * bc66_ret_fail if the probe was not done, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_fw_info( bc66_fw_info_t * info )
+{
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( info == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+	if( !bc66->drv.fw.valid ) { 
+		return bc66_ret_fail;
+	}
+	*info = bc66->drv.fw;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check a firmware capability. Before the probe every capability is assumed. 
+ * 
+ * @param cap : capability (\p bc66_cap_t flag). 
+ * 
+ * @return 
+ * true if the firmware has the capability.
+ */
+bool bc66_has_cap( bc66_cap_t cap )
+{
+	return bc66 && (!bc66->drv.fw.valid || (bc66->drv.fw.caps & cap));
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * EPS Network Registration Status. 
- * Configures the different unsolicited result codes for EPS 
- * Network Registration Status.
+ * End of a firmware update command: download request or revision query. 
  * 
- * @param net : Disable or enable network registration URC. 
- * - 0 Disable network registration URC 
- * - 1 Enable network registration URC: +CEREG: <stat> 
- * - 2 Enable network registration and location information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>]] 
- * - 3 Enable network registration, location information and EMM cause value information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,<cause_type>,<reject_cause>]] 
- * - 4 For a UE that requests PSM, enable network registration and location information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,,[,[<Active-Time>],[<Periodic-TAU>]]]]  
- * - 5 For a UE that requests PSM, enable network registration, location information and EMM cause value information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,[<cause_type>],[<reject_cause>][,[<Active-Time>],[<Periodic-TAU>]]]]
+ * @param ret_code	: command result. 
+ * @param arg		: not used. 
+ */
+static void _bc66_fota_cmd_done( bc66_ret_t ret_code, void * arg )
+{
+	bc66_fota_state_t * st = &bc66->drv.fota.state;
+	const char * rev;
+	size_t len;
+	(void)arg;
+
+	if( bc66->drv.result.cmd == bc66_cmd_list_QFOTADL ) { 
+		if( ret_code == bc66_ret_success ) { 
+			return;
+		}
+		if( st->attempts < BC66_FOTA_MAX_ATTEMPTS ) { 
+			bc66->drv.fota.retry = true;
+		} else { 
+			_bc66_fota_set_phase( bc66_fota_failed, bc66->drv.result.err_code );
+		}
+		return;
+	}
+
+	// Revision: <revision> (module still restarting: query again on its boot) 
+	if( (ret_code != bc66_ret_success) || ((st->phase != bc66_fota_verify) && (st->phase != bc66_fota_download)) ) { 
+		return;
+	}
+	rev = bc66_get_last_response();
+	if( strncmp( rev, "Revision:", sizeof("Revision:") - 1 ) ) { 
+		return;
+	}
+	rev += sizeof("Revision:") - 1;
+	while( *rev == ' ' ) { 
+		rev ++;
+	}
+	len = strcspn( rev, "\r\n" );
+	if( st->from_rev[0] && (len == strlen( st->from_rev )) && !strncmp( rev, st->from_rev, len ) ) { 
+		// a resumed download goes on: the old firmware still runs 
+		if( st->phase == bc66_fota_verify ) { 
+			_bc66_fota_set_phase( bc66_fota_failed, 0 );
+		}
+		return;
+	}
+	// resumed download: a new revision means the update ended while the host was down 
+	if( (st->phase == bc66_fota_download) && !st->from_rev[0] ) { 
+		return;
+	}
+	_bc66_fota_set_phase( bc66_fota_done, 0 );
+	// identification and capabilities changed with the firmware 
+	bc66->drv.fw.valid = false;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Request the image download (AT+QFOTADL). 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_set_eps( unsigned int set )
-{ 
-	if( set > 5 ) { 
-		return bc66_ret_out_of_range;
-	}
+static bc66_ret_t _bc66_fota_download( void )
+{
+	bc66_fota_state_t * st = &bc66->drv.fota.state;
 
-	return bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_CEREG, NULL, "%u", set );
+	st->attempts ++;
+	if( st->phase != bc66_fota_download ) { 
+		_bc66_fota_set_phase( bc66_fota_download, 0 );
+	}
+	st->progress = 0;
+	bc66->drv.fota.dirty = true;
+	return bc66_cmd_start( _bc66_fota_cmd_done, NULL, BC66_CMD_WRITE, bc66_cmd_list_QFOTADL, NULL, "\"%s\"", st->url );
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * Power Saving Mode Setting (PSM). 
+ * Start a firmware update (DFOTA): the module downloads the image from \p url 
+ * (AT+QFOTADL), writes it and restarts. Drive it with \p bc66_fota_poll(). 
+ * The revision before the update is taken from the capability probe, if done. 
  * 
- * @param mode 
- * Integer type. Disable or enable the use of PSM in the UE 
- * - 0 Disable the use of PSM 
- * - 1 Enable the use of PSM 
- * - 2 Disable the use of PSM and discard all parameters for PSM or, if available, reset to the default values.
+ * @param url			: image URL (http:// or https://). 
+ * @param image_size	: image size [bytes] for the throughput report, 0 if unknown. 
+ * @param save			: hook to store the state (phase changes and every 
+ * BC66_FOTA_SAVE_STEP %), NULL if not needed. 
+ * @param arg			: hook user argument. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_set_power_saving_mode( int mode )
+bc66_ret_t bc66_fota_start( const char * url, uint32_t image_size, bc66_fota_save_t save, void * arg )
 {
-	if( (0 <= mode) && (mode <= 2) ) {
-		return bc66_send_at_command(BC66_CMD_WRITE,bc66_cmd_list_CPSMS,NULL,"%c", '0' + (int)mode );
-	} else { 
+	bc66_fota_state_t * st;
+	bc66_ret_t ret_code;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (url == NULL) || (strlen( url ) >= BC66_FOTA_URL_SIZE) || (bc66->func_get_tick == NULL) ) { 
 		return bc66_ret_out_of_range;
 	}
+	if( bc66->drv.cmd.busy || bc66->drv.fota.active ) { 
+		return bc66_ret_busy;
+	}
+
+	st = &bc66->drv.fota.state;
+	memset( st, 0, sizeof(*st) );
+	strcpy( st->url, url );
+	if( bc66->drv.fw.valid ) { 
+		strcpy( st->from_rev, bc66->drv.fw.revision );
+	}
+	st->image_size = image_size;
+	bc66->drv.fota.save = save;
+	bc66->drv.fota.arg = arg;
+	bc66->drv.fota.retry = false;
+	bc66->drv.fota.wait_quiet = false;
+	bc66->drv.fota.probe = false;
+	bc66->drv.fota.saved_progress = 0;
+	bc66->drv.fota.tick = bc66->func_get_tick();
+
+	ret_code = _bc66_fota_download();
+	if( ret_code != bc66_ret_success ) { 
+		st->phase = bc66_fota_idle;
+		return ret_code;
+	}
+	bc66->drv.fota.active = true;
+	return bc66_ret_success;
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * This function returns the IP address of the device. Show PDP Addresses.
+ * Resume a firmware update from a saved state, i.e. after a host reboot. The 
+ * module has no download state query (AT+QFOTADL has no read command): the 
+ * revision is queried, and an interrupted download is requested again only when 
+ * no +QIND: "FOTA" came in BC66_FOTA_RESUME_QUIET. An interrupted update goes on 
+ * to wait the new revision. Time while the host was down is not added to the phases. 
  * 
- * @param ip : pointer to struct variable to return IP ADDRESS.
+ * @param state	: state given to the save hook. 
+ * @param save	: hook to store the state, NULL if not needed. 
+ * @param arg	: hook user argument. 
  * 
  * @return 
- * See \p bc66_ret_t return codes.
- */ 
-bc66_ret_t bc66_get_ipv4_address(bc66_ip_add_t * ip )
+ * bc66_ret_success if the update is running or was done, bc66_ret_fail if it 
+ * had failed, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_fota_resume( const bc66_fota_state_t * state, bc66_fota_save_t save, void * arg )
 {
-	bc66_ret_t ret_code; 
-	const char cmd_rsp[] = "+CGPADDR: 1,";
-	char * rsp;
-	// send command 
-	ret_code = bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_CGPADDR, cmd_rsp, "1" );
-	if( ret_code == bc66_ret_success ) { 
-		// get ip address in text format 
-		rsp = bc66_get_last_response();
-		if( (rsp = strstr(rsp,cmd_rsp)) ) {
-			if( (rsp = strchr(rsp, ',')) ) {
-				rsp++;
-				ip->a4 = atoi(rsp);
-				if( (rsp = strchr(rsp, '.')) ) { 
-					rsp++;
-					ip->a3 = atoi(rsp);
-					if( (rsp = strchr(rsp, '.')) ) { 
-						rsp++;
-						ip->a2 = atoi(rsp);
-						if( (rsp = strchr(rsp, '.')) ) {
-							rsp++;
-							ip->a1 = atoi(rsp);
-							return bc66_ret_success;
-						}
-					}
-				}
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (state == NULL) || (state->phase > bc66_fota_failed) || (bc66->func_get_tick == NULL) ) { 
+		return bc66_ret_out_of_range;
+	}
+	if( bc66->drv.fota.active ) { 
+		return bc66_ret_busy;
+	}
+
+	bc66->drv.fota.state = *state;
+	bc66->drv.fota.state.url[BC66_FOTA_URL_SIZE - 1] = '\0';
+	bc66->drv.fota.state.from_rev[BC66_FW_ID_SIZE - 1] = '\0';
+	bc66->drv.fota.save = save;
+	bc66->drv.fota.arg = arg;
+	bc66->drv.fota.retry = false;
+	bc66->drv.fota.wait_quiet = false;
+	bc66->drv.fota.dirty = false;
+	bc66->drv.fota.saved_progress = state->progress;
+	bc66->drv.fota.tick = bc66->func_get_tick();
+	bc66->drv.fota.last_urc = bc66->drv.fota.tick;
+
+	switch( state->phase ) { 
+		case bc66_fota_download:
+			// the module may still be downloading 
+			bc66->drv.fota.retry = true;
+			bc66->drv.fota.wait_quiet = true;
+			bc66->drv.fota.probe = true;
+			break;
+		case bc66_fota_update:
+		case bc66_fota_verify:
+			// the module may have restarted already 
+			_bc66_fota_set_phase( bc66_fota_verify, 0 );
+			bc66->drv.fota.probe = true;
+			break;
+		case bc66_fota_failed:
+			return bc66_ret_fail;
+		default:
+			return bc66_ret_success;
+	}
+	bc66->drv.fota.active = true;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Drive the firmware update: processes received chars, accounts phase times, 
+ * requests a failed download again, queries the new revision once the module 
+ * reports its boot after the update (RDY or +CPIN: READY, or half 
+ * BC66_FOTA_VERIFY_TIMEOUT without them) and saves the state when it changed. 
+ * 
+ * @return 
+ * - bc66_ret_busy while the update is running 
+ * - bc66_ret_success when the new firmware runs (or no update) 
+ * - bc66_ret_fail when the update failed 
+ */
+bc66_ret_t bc66_fota_poll( void )
+{
+	bc66_fota_state_t * st;
+	uint32_t now;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	st = &bc66->drv.fota.state;
+	if( !bc66->drv.fota.active ) { 
+		return (st->phase == bc66_fota_failed) ? bc66_ret_fail : bc66_ret_success;
+	}
+
+	bc66_process();
+	_bc66_fota_account();
+	now = bc66->drv.fota.tick;
+
+	if( (st->phase == bc66_fota_verify) && !bc66->drv.fota.late_probe && 
+		((uint32_t)(now - bc66->drv.fota.verify_start) >= BC66_FOTA_VERIFY_TIMEOUT / 2) ) { 
+		// boot indication missed 
+		bc66->drv.fota.late_probe = true;
+		bc66->drv.fota.probe = true;
+	}
+
+	if( !bc66_cmd_busy() ) { 
+		if( bc66->drv.fota.probe && ((st->phase == bc66_fota_verify) || (st->phase == bc66_fota_download)) ) { 
+			// one query per boot indication 
+			if( bc66_cmd_start( _bc66_fota_cmd_done, NULL, BC66_CMD_EXE, bc66_cmd_list_ATI, "Revision:", NULL ) == bc66_ret_success ) { 
+				bc66->drv.fota.probe = false;
+			}
+		} else if( bc66->drv.fota.retry && (st->phase == bc66_fota_download) && 
+			(!bc66->drv.fota.wait_quiet || ((uint32_t)(now - bc66->drv.fota.last_urc) >= BC66_FOTA_RESUME_QUIET)) ) { 
+			bc66->drv.fota.retry = false;
+			bc66->drv.fota.wait_quiet = false;
+			if( _bc66_fota_download() != bc66_ret_success ) { 
+				bc66->drv.fota.retry = true;
 			}
+		} else if( (st->phase == bc66_fota_verify) && ((uint32_t)(now - bc66->drv.fota.verify_start) >= BC66_FOTA_VERIFY_TIMEOUT) ) { 
+			_bc66_fota_set_phase( bc66_fota_failed, 0 );
 		}
 	}
-	return bc66_ret_no_ip;
+
+	// save on phase change and every BC66_FOTA_SAVE_STEP % 
+	if( bc66->drv.fota.dirty || (st->progress >= bc66->drv.fota.saved_progress + BC66_FOTA_SAVE_STEP) ) { 
+		bc66->drv.fota.dirty = false;
+		bc66->drv.fota.saved_progress = st->progress;
+		if( bc66->drv.fota.save ) { 
+			bc66->drv.fota.save( st, bc66->drv.fota.arg );
+		}
+	}
+
+	if( st->phase == bc66_fota_done ) { 
+		bc66->drv.fota.active = false;
+		return bc66_ret_success;
+	}
+	if( st->phase == bc66_fota_failed ) { 
+		bc66->drv.fota.active = false;
+		return bc66_ret_fail;
+	}
+	return bc66_ret_busy;
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * Set Default PSD Connection
- * 
- * This command sets the PSD connection settings for PDN connection on power-up. 
- * When attaching to the NB-IoT network on power-on, a PDN connection setup must be performed. 
- * In order to allow this to happen, PDN connection settings must be stored in NVRAM, 
- * thus making it to be used by the modem during the attach procedure.
+ * Get the firmware update state. 
  * 
- * @param pdp_type 	: Specify the type of packet data protocol. 
- * @param apn 		: A logical name that is used to select the GGSN or the external packet data network. The maximum configurable APN length is 99 bytes.
- * @param user		: The user name for accessing to the IP network. (Optional)
- * @param pass		: The password for accessing to the IP network. (Optional)
+ * @param state : update state. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_set_psd_conn(pdp_type_t pdp_type, const char * apn, const char * user, const char * pass )
+bc66_ret_t bc66_fota_get_state( bc66_fota_state_t * state )
 {
-	char pdp[256];
-	switch( pdp_type ) 
-	{
-		case pdp_type_ip: 
-			strcpy(pdp,"\"IP\"");
-			break; 
-		
-		case pdp_type_ipv6: 
-			strcpy(pdp,"\"IPV6\"");
-			break; 
-		
-		case pdp_type_ipv4v6: 
-			strcpy(pdp,"\"IPV4V6\"");
-			break; 
-		
-		case pdp_type_non_ip: 
-			strcpy(pdp,"\"Non-IP\"");
-			break; 
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( state == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+	*state = bc66->drv.fota.state;
+	return bc66_ret_success;
+}
 
-		default: 
-			return bc66_ret_out_of_range;
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the image download throughput: downloaded bytes over the download phase 
+ * time (failed attempts included). 
+ * 
+ * @param throughput : download throughput [bytes/s]. 
+ * 
+ * @return 
+ * bc66_ret_fail if the image size is unknown, nothing was downloaded or the update 
+ * failed, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_fota_get_throughput( uint32_t * throughput )
+{
+	const bc66_fota_state_t * st;
+	uint64_t bytes;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
 	}
-	if( apn == NULL ) { 
+	if( throughput == NULL ) { 
 		return bc66_ret_out_of_range;
 	}
+	st = &bc66->drv.fota.state;
+	bytes = (st->phase == bc66_fota_download) ? (uint64_t)st->image_size * st->progress / 100 : st->image_size;
+	if( (st->phase == bc66_fota_idle) || (st->phase == bc66_fota_failed) || (bytes == 0) || (st->phase_time[bc66_fota_download] == 0) ) { 
+		return bc66_ret_fail;
+	}
+	*throughput = (uint32_t)(bytes * 1000 / st->phase_time[bc66_fota_download]);
+	return bc66_ret_success;
+}
 
-	strcat(pdp,",\"");
-	strcat(pdp,apn);
-	strcat(pdp,"\"");
+//*****************************************************************************
+/**
+ * @brief 
+ * Send the cached settings again, in the order they were first sent. 
+ */
+static void _bc66_cfg_replay( void )
+{
+	const uint8_t * buf = bc66->drv.cfg_cache.buf;
+	size_t pos = 0;
 
-	if( user ) { 
-		strcat(pdp,",\"");
-		strcat(pdp,user);
-		strcat(pdp,"\"");
+	bc66->drv.cfg_cache.replaying = true;
+	while( pos < bc66->drv.cfg_cache.len ) { 
+		if( bc66_send_at_prefixed( (bc66_cmd_type_t)buf[pos + 1], (bc66_cmd_list_t)buf[pos], (const char *)&buf[pos + 3], buf[pos + 2], NULL, NULL ) != bc66_ret_success ) { 
+			bc66->drv.health.stats.replay_errors ++;
+		}
+		pos += 3 + buf[pos + 2];
 	}
+	bc66->drv.cfg_cache.replaying = false;
+}
 
-	if( pass ) { 
-		strcat(pdp,",\"");
-		strcat(pdp,pass);
-		strcat(pdp,"\"");
+//*****************************************************************************
+/**
+ * @brief 
+ * Probe the module with AT up to the configured times. 
+ * 
+ * @return 
+ * bc66_ret_success if the module answered, see \p bc66_ret_t return codes.
+ */
+static bc66_ret_t _bc66_health_probe( void )
+{
+	bc66_ret_t ret_code = bc66_ret_timeout;
+	uint8_t i;
+
+	for( i = 0; (i < bc66->drv.health.cfg.probes) || (i == 0); i++ ) { 
+		if( (ret_code = bc66_send_at_command( BC66_CMD_EXE, bc66_cmd_list_AT, NULL, NULL )) == bc66_ret_success ) { 
+			break;
+		}
+	}
+	return ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Restart the module and wait it before the next probe: the old answers and the 
+ * module state caches are dropped. 
+ * 
+ * @param tier	: bc66_health_reset or bc66_health_power. 
+ * @param wait	: time before the next probe [ms]. 
+ */
+static void _bc66_health_restart( bc66_health_tier_t tier, uint32_t wait )
+{
+	if( tier == bc66_health_reset ) { 
+		bc66_hw_reset();
+	} else if( bc66->drv.health.cfg.power_cycle ) { 
+		bc66_obj_t * self = bc66;
+		bc66->drv.health.cfg.power_cycle( bc66->drv.health.arg );
+		bc66 = self;
+		bc66->drv.mqtt_session ++;
+	} else { 
+		bc66_power_off();
+		bc66->func_delay(100);
+		bc66_power_on();
+	}
+	memset( &bc66->drv.sim, 0, sizeof(bc66->drv.sim) );
+	_bc66_stale_clear();
+	_bc66_addr_invalidate();
+	_bc66_rx_buffer_flush();
+	bc66->drv.health.wait_until = bc66->func_get_tick() + wait;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Report a recovery tier end to the callback. 
+ * 
+ * @param ret_code	: tier result. 
+ */
+static void _bc66_health_notify( bc66_ret_t ret_code )
+{
+	bc66_obj_t * self = bc66;
+
+	if( bc66->drv.health.cb ) { 
+		bc66->drv.health.cb( bc66->drv.health.tier, ret_code, bc66->func_get_tick() - bc66->drv.health.fault_start, bc66->drv.health.arg );
+		bc66 = self;
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * The module answers again: replay the settings after a restart, account the 
+ * time to recover and report it. 
+ */
+static void _bc66_health_recovered( void )
+{
+	bc66_health_stats_t * stats = &bc66->drv.health.stats;
+	bc66_health_tier_t tier = bc66->drv.health.tier;
+	uint32_t ttr, count = 0;
+
+	if( (tier == bc66_health_probe) && bc66->drv.health.idle_probe ) { 
+		// idle module, nothing to recover 
+		stats->recoveries[bc66_health_ok] ++;
+	} else { 
+		if( tier >= bc66_health_reset ) { 
+			_bc66_cfg_replay();
+		}
+		ttr = bc66->func_get_tick() - bc66->drv.health.fault_start;
+		stats->recoveries[tier] ++;
+		for( tier = bc66_health_probe; tier <= bc66_health_power; tier++ ) { 
+			count += stats->recoveries[tier];
+		}
+		stats->last_ttr = ttr;
+		stats->total_ttr += ttr;
+		stats->mttr = stats->total_ttr / count;
+		if( ttr > stats->max_ttr ) { 
+			stats->max_ttr = ttr;
+		}
+		_bc66_health_notify( bc66_ret_success );
+	}
+	bc66->drv.health.tier = bc66_health_ok;
+	bc66->drv.health.timeouts = 0;
+	bc66->drv.health.last_rx = bc66->func_get_tick();
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Start the liveness monitor: after consecutive command timeouts, or a long time 
+ * without received chars, \p bc66_health_poll() probes the module with AT and 
+ * escalates from resync to RESET pin to power cycle until it answers. After a 
+ * restart the cached settings (commands flagged BC66_CMD_FLAG_CFG, in the order 
+ * they were sent) are sent again. 
+ * 
+ * @param cfg	: configuration, NULL for the BC66_HEALTH_... defaults. 
+ * @param cb	: progress callback, NULL if not needed. 
+ * @param arg	: callback and power cycle hook user argument. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_health_start( const bc66_health_cfg_t * cfg, bc66_health_cb_t cb, void * arg )
+{
+	static const bc66_health_cfg_t default_cfg = { BC66_HEALTH_MAX_TIMEOUTS, BC66_HEALTH_PROBES, BC66_HEALTH_IDLE_TIME, BC66_HEALTH_BOOT_TIME, BC66_HEALTH_RETRY_TIME, NULL };
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( bc66->func_get_tick == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	bc66->drv.health.cfg = cfg ? *cfg : default_cfg;
+	bc66->drv.health.cb = cb;
+	bc66->drv.health.arg = arg;
+	bc66->drv.health.tier = bc66_health_ok;
+	bc66->drv.health.timeouts = 0;
+	bc66->drv.health.last_rx = bc66->func_get_tick();
+	bc66->drv.health.active = true;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Stop the liveness monitor. Metrics are kept. 
+ */
+void bc66_health_stop( void )
+{
+	if( bc66 ) { 
+		bc66->drv.health.active = false;
+		bc66->drv.health.tier = bc66_health_ok;
 	}
-
-	return bc66_send_at_command(BC66_CMD_WRITE,bc66_cmd_list_QCGDEFCONT,NULL,"%s", pdp);
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * Set Mobile Operation Band.
- * 
- * @param band_numb : band quantity. 
- * - 0 all bands. 
- * - 1 to 16 Number of bands to be locked.
+ * Drive the liveness monitor. Call it periodically while no command is running; 
+ * it blocks while probing (AT and resync timeouts), never during a restart wait. 
  * 
  * @return 
- * See \p bc66_ret_t return codes.
+ * - bc66_ret_success while the module answers 
+ * - bc66_ret_busy while a recovery is running: do not send commands 
+ * - bc66_ret_fail if the monitor is not running 
  */
-bc66_ret_t bc66_set_mobile_bands( int band_number, ... )
-{ 
-	va_list bands;
-	char all_bands[32];
-	sprintf( all_bands, "%u", band_number );
+bc66_ret_t bc66_health_poll( void )
+{
+	uint32_t now;
 
-	if( band_number ) {
-		va_start( bands, band_number );
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
 	}
-
-	for( int n = 0 ; n < band_number ; n ++ ) {
-		char tmp[8]; 
-		int next_band = va_arg( bands, int );
-		// add next selected band 
-		sprintf(tmp, ",%u", next_band );
-		// add band to command line 
-		strcat(all_bands,tmp);
+	if( !bc66->drv.health.active ) { 
+		return bc66_ret_fail;
 	}
-	
-	if( band_number ) {
-		va_end( bands );
+	if( bc66->drv.cmd.busy ) { 
+		return (bc66->drv.health.tier == bc66_health_ok) ? bc66_ret_success : bc66_ret_busy;
 	}
 
-	return bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_QBAND, NULL,"%s", all_bands );
+	// received chars (URCs included) tell the module is alive 
+	_bc66_rx_idle();
+	now = bc66->func_get_tick();
+
+	if( bc66->drv.health.tier == bc66_health_ok ) { 
+		if( bc66->drv.health.timeouts >= bc66->drv.health.cfg.max_timeouts ) { 
+			bc66->drv.health.idle_probe = false;
+		} else if( (uint32_t)(now - bc66->drv.health.last_rx) >= bc66->drv.health.cfg.idle ) { 
+			bc66->drv.health.idle_probe = true;
+			bc66->drv.health.fault_start = now;
+		} else { 
+			return bc66_ret_success;
+		}
+		bc66->drv.health.tier = bc66_health_probe;
+	} else if( (int32_t)(now - bc66->drv.health.wait_until) < 0 ) { 
+		// module restarting 
+		return bc66_ret_busy;
+	}
+
+	for( ;; ) { 
+		bc66_ret_t ret_code;
+
+		if( bc66->drv.health.tier == bc66_health_resync ) { 
+			// a module stuck in a data prompt needs ESC before any command 
+			bc66->drv.stale.prompt = true;
+			ret_code = _bc66_resync();
+		} else { 
+			ret_code = _bc66_health_probe();
+		}
+		if( ret_code == bc66_ret_success ) { 
+			_bc66_health_recovered();
+			return bc66_ret_success;
+		}
+
+		_bc66_health_notify( bc66_ret_fail );
+		switch( bc66->drv.health.tier ) 
+		{
+			case bc66_health_probe:
+				bc66->drv.health.tier = bc66_health_resync;
+				break;
+
+			case bc66_health_resync:
+				bc66->drv.health.tier = bc66_health_reset;
+				_bc66_health_restart( bc66_health_reset, bc66->drv.health.cfg.boot );
+				return bc66_ret_busy;
+
+			case bc66_health_reset:
+				bc66->drv.health.tier = bc66_health_power;
+				_bc66_health_restart( bc66_health_power, bc66->drv.health.cfg.boot );
+				return bc66_ret_busy;
+
+			default:
+				// nothing answers: keep power cycling at a slow pace 
+				bc66->drv.health.stats.failures ++;
+				_bc66_health_restart( bc66_health_power, bc66->drv.health.cfg.retry );
+				return bc66_ret_busy;
+		}
+	}
 }
 
 //*****************************************************************************
 /**
  * @brief 
- * Enter PIN AT command.
- * Return bc66_ret_success if Modem is READY.
+ * Get the liveness monitor metrics. 
+ * 
+ * @param stats : metrics. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_is_ready( void )
-{ 
-	return bc66_send_at_command(BC66_CMD_READ,bc66_cmd_list_CPIN,"+CPIN: READY",NULL);
+bc66_ret_t bc66_health_get_stats( bc66_health_stats_t * stats )
+{
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( stats == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+	*stats = bc66->drv.health.stats;
+	return bc66_ret_success;
 }
 
 //*****************************************************************************
@@ -848,6 +5074,27 @@ bc66_ret_t bc66_set_nbiot_event_report(bool enable, bool event )
 	return bc66_send_at_command(BC66_CMD_WRITE,bc66_cmd_list_QNBIOTEVENT, NULL,"%u,%u", (int)enable, (int)event );
 }
 
+//*****************************************************************************
+/**
+ * @brief 
+ * Configure NB-IoT Release Assistance Indication (AT+QNBIOTRAI). The indication 
+ * is sent with the next uplink packets, so the network releases the RRC connection 
+ * without waiting for its inactivity timer. 
+ * 
+ * @param rai : release assistance indication. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_release_assistance( bc66_rai_t rai )
+{
+	if( rai > bc66_rai_one_downlink ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	return bc66_send_at_command( BC66_CMD_WRITE, bc66_cmd_list_QNBIOTRAI, NULL, "%u", (unsigned int)rai );
+}
+
 //*****************************************************************************
 /**
  * @brief 
@@ -932,24 +5179,25 @@ bc66_ret_t bc66_set_mqtt_parameters( uint16_t keepalive, bool dataformat, bool s
 bc66_ret_t bc66_open_net_mqtt_client(const char * server_ip, uint16_t server_port )
 {
 	const uint8_t TCP_connectID = 0;
+	bc66_match_t match;
 
-	if( strlen( server_ip ) >= 150 ) { 
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( strlen( server_ip ) > BC66_MQTT_SERVER_MAX_LEN ) { 
 		return bc66_ret_out_of_range;
 	}
 
-	if( bc66_send_at_command(BC66_CMD_WRITE,bc66_cmd_list_QMTOPEN,"+QMTOPEN: 0,","%u,\"%s\",%u", TCP_connectID, server_ip, server_port) == bc66_ret_success ) {
-		char * rsp = bc66_get_last_response();
-		if( strstr( rsp,"0,0" ) ) { 
+	if( bc66_send_at_command_match(&bc66->drv.rsp[bc66_rsp_QMTOPEN],&match,BC66_CMD_WRITE,bc66_cmd_list_QMTOPEN,"%u,\"%s\",%u", TCP_connectID, server_ip, server_port) == bc66_ret_success ) {
+		if( match.field[0].num == 0 ) { 
 			// Network opened successfully
 			return bc66_ret_success;
-		} else if( strstr( rsp, "0,-1" ) ) {
+		} else if( match.field[0].num == -1 ) {
 			// Failed to open network
 			return bc66_ret_fail;
-		} else { 
-			// unknown error
-			return bc66_ret_error;
 		}
 	}
+	// unknown error
 	return bc66_ret_error;
 }
 
@@ -964,12 +5212,17 @@ bc66_ret_t bc66_open_net_mqtt_client(const char * server_ip, uint16_t server_por
 bc66_ret_t bc66_close_net_mqtt_client( void )
 {
 	const uint8_t TCP_connectID = 0;
-	if( bc66_send_at_command(BC66_CMD_WRITE,bc66_cmd_list_QMTCLOSE,"+QMTCLOSE: 0,","%u", TCP_connectID) ) {
-		char * rsp = bc66_get_last_response();
-		if( strstr( rsp,"0,0" ) ) { 
+	bc66_match_t match;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	bc66->drv.mqtt_session ++;
+	if( bc66_send_at_command_match(&bc66->drv.rsp[bc66_rsp_QMTCLOSE],&match,BC66_CMD_WRITE,bc66_cmd_list_QMTCLOSE,"%u", TCP_connectID) == bc66_ret_success ) {
+		if( match.field[0].num == 0 ) { 
 			// Network closed successfully
 			return bc66_ret_success;
-		} else if( strstr( rsp, "0,-1" ) ) {
+		} else if( match.field[0].num == -1 ) {
 			// Failed to close the network
 			return bc66_ret_fail;
 		}
@@ -995,28 +5248,32 @@ bc66_ret_t bc66_close_net_mqtt_client( void )
 bc66_ret_t bc66_connect_mqtt_client(const char * client_id, const char * user, const char * pass )
 {
 	const uint8_t TCP_connectID = 0;
-	if( bc66_ret_success == bc66_send_at_command(BC66_CMD_WRITE,bc66_cmd_list_QMTCONN,"+QMTCONN: 0,","%u,\"%s\",\"%s\",\"%s\"",TCP_connectID,client_id,user,pass )) { 
-		char * rsp = bc66_get_last_response();
-		if( (rsp = strchr(rsp,',' )) ) { 
-			rsp ++ ; 
-			if( *rsp == '0' ) { 
-				if( rsp[2] == '0' ) {
-					// Sent the packet successfully and received ACK from server and Connection Accepted
-					return bc66_ret_success; 
-				} else if( rsp[2] == '1' ) {
-					// Connection Refused: Unacceptable Protocol Version
-					return bc66_ret_err_protocol;
-				} else if( rsp[2] == '2' ) {
-					// Connection Refused: Identifier Rejected
-					return bc66_ret_id_rejected;
-				}
-			} else if( *rsp == '1' ) {
-				// Packet retransmission 
-				return bc66_ret_packet_retransmission;
-			} else if( *rsp == '2' ) {
-				// Failed to send packet 
-				return bc66_ret_packet_fail;
+	bc66_match_t match;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( bc66_ret_success == bc66_send_at_command_match(&bc66->drv.rsp[bc66_rsp_QMTCONN],&match,BC66_CMD_WRITE,bc66_cmd_list_QMTCONN,"%u,\"%s\",\"%s\",\"%s\"",TCP_connectID,client_id,user,pass )) { 
+		// <result>[,<ret_code>] 
+		if( match.field[0].num == 0 ) { 
+			if( match.count < 2 ) { 
+				return bc66_ret_error;
+			} else if( match.field[1].num == 0 ) {
+				// Sent the packet successfully and received ACK from server and Connection Accepted
+				return bc66_ret_success; 
+			} else if( match.field[1].num == 1 ) {
+				// Connection Refused: Unacceptable Protocol Version
+				return bc66_ret_err_protocol;
+			} else if( match.field[1].num == 2 ) {
+				// Connection Refused: Identifier Rejected
+				return bc66_ret_id_rejected;
 			}
+		} else if( match.field[0].num == 1 ) {
+			// Packet retransmission 
+			return bc66_ret_packet_retransmission;
+		} else if( match.field[0].num == 2 ) {
+			// Failed to send packet 
+			return bc66_ret_packet_fail;
 		}
 	}
 	
@@ -1038,9 +5295,93 @@ bc66_ret_t bc66_connect_mqtt_client(const char * client_id, const char * user, c
 bc66_ret_t bc66_disconn_mqtt_client( void )
 {
 	const uint8_t TCP_connectID = 0;
+	if( bc66 ) { 
+		bc66->drv.mqtt_session ++;
+	}
 	return bc66_send_at_command(BC66_CMD_WRITE,bc66_cmd_list_QMTDISC,"+QMTDISC: 0,0","%u", TCP_connectID);
 }
 
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the MQTT connection number. It changes when the connection is closed: by 
+ * \p bc66_disconn_mqtt_client(...), \p bc66_close_net_mqtt_client(...), the server 
+ * (+QMTSTAT URC) or a module reset. Compare it to tell if a connection is still live. 
+ * 
+ * @return 
+ * Connection number, 0 if the driver is not initialized.
+ */
+uint16_t bc66_mqtt_session( void )
+{
+	return bc66 ? bc66->drv.mqtt_session : 0;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get a new MQTT packet identifier. 
+ * 
+ * @return 
+ * Packet identifier (1 to 65535).
+ */
+static uint16_t _bc66_mqtt_next_msg_id( void )
+{
+	if( ++bc66->drv.mqtt_msg_id == 0 ) { 
+		bc66->drv.mqtt_msg_id = 1;
+	}
+	return bc66->drv.mqtt_msg_id;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Wait the answer of a MQTT packet command already sent: the line of its 
+ * <msgID> is matched with the command response pattern and <result> read from 
+ * the captured fields. 
+ * 
+ * @param rsp		: response pattern. 
+ * @param cmd_lst	: command sent, gives the response prefix and timeout. 
+ * @param msgID		: packet identifier sent. 
+ * 
+ * @return 
+ * Packet result, see \p bc66_ret_t return codes.
+ */
+static bc66_ret_t _bc66_mqtt_wait( bc66_rsp_list_t rsp, bc66_cmd_list_t cmd_lst, uint16_t msgID )
+{
+	char lead[24];
+	bc66_match_t match;
+
+	snprintf( lead, sizeof(lead), "%s: 0,%u,", bc66_cmds_list[cmd_lst].cmd, msgID );
+	return _bc66_find_at_match( &bc66->drv.rsp[rsp], lead, &match, bc66_cmds_list[cmd_lst].rsp_timeout, true );
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Send a MQTT packet command and wait its result (see \p _bc66_mqtt_wait(...)). 
+ * 
+ * @param rsp		: response pattern. 
+ * @param cmd_lst	: command to send. 
+ * @param msgID		: packet identifier, in the arguments too. 
+ * @param arg_fmt 	: arguments format (like printf function). 
+ * 
+ * @return 
+ * Packet result, see \p bc66_ret_t return codes.
+ */
+static bc66_ret_t _bc66_mqtt_packet( bc66_rsp_list_t rsp, bc66_cmd_list_t cmd_lst, uint16_t msgID, const char * arg_fmt, ... )
+{
+	bc66_ret_t ret_code;
+	va_list args;
+
+	va_start( args, arg_fmt );
+	ret_code = _bc66_write_at_command( BC66_CMD_WRITE, cmd_lst, arg_fmt, args );
+	va_end( args );
+	if( ret_code != bc66_ret_success ) { 
+		return ret_code;
+	}
+	return _bc66_mqtt_wait( rsp, cmd_lst, msgID );
+}
+
 //*****************************************************************************
 /**
  * @brief 
@@ -1062,8 +5403,8 @@ bc66_ret_t bc66_disconn_mqtt_client( void )
 bc66_ret_t bc66_publish_msg_mqtt( const char * topic, const char * msg, int qos )
 {
 	const uint8_t TCP_connectID = 0;
-	/* Message identifier of packet. The range is 0-65535. It will be 0 onlywhen <qos>=0. */
-	int msgID = 0;			// The range is 0-65535.
+	/* Message identifier of packet. The range is 0-65535. It will be 0 only when <qos>=0. */
+	uint16_t msgID;
 	/* Whether or not the server will retain the message after it has been 
 	delivered to the current subscribers.
 	0: The server will not retain the message after it has been delivered to the
@@ -1071,7 +5412,228 @@ bc66_ret_t bc66_publish_msg_mqtt( const char * topic, const char * msg, int qos
 	1: The server will retain the message after it has been delivered to the current
 	subscribers */
 	int retain = 0;
-	return bc66_send_at_command(BC66_CMD_WRITE,bc66_cmd_list_QMTPUB,"+QMTPUB: 0,0,0","%u,%u,%u,%u,\"%s\",\"%s\"",TCP_connectID,msgID,qos,retain,topic,msg);
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (qos < 0) || (qos > 2) ) { 
+		return bc66_ret_out_of_range;
+	}
+	msgID = qos ? _bc66_mqtt_next_msg_id() : 0;
+
+	return _bc66_mqtt_packet(bc66_rsp_QMTPUB,bc66_cmd_list_QMTPUB,msgID,"%u,%u,%u,%u,\"%s\",\"%s\"",TCP_connectID,msgID,qos,retain,topic,msg);
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Publish a message of a burst. The last message of the burst is sent with release 
+ * assistance (no further data for QoS 0, one downlink for the QoS 1/2 acknowledge), 
+ * so the radio is released straight after it. Release assistance is then disabled 
+ * again for the next burst. 
+ * 
+ * @param topic	: Topic. The maximum length is 255 bytes. 
+ * @param msg 	: The message that needs to be published. The maximum length is 700 bytes. 
+ * @param qos	: QoS level (0 to 2). 
+ * @param last	: last message of the burst. 
+ * 
+ * @return 
+ * Publish result, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_publish_msg_mqtt_burst( const char * topic, const char * msg, int qos, bool last )
+{
+	bc66_ret_t ret_code;
+
+	if( !last || !bc66_has_cap( BC66_CAP_RAI ) ) { 
+		return bc66_publish_msg_mqtt( topic, msg, qos );
+	}
+
+	ret_code = bc66_set_release_assistance( qos ? bc66_rai_one_downlink : bc66_rai_no_data );
+	if( ret_code != bc66_ret_success ) { 
+		return ret_code;
+	}
+	ret_code = bc66_publish_msg_mqtt( topic, msg, qos );
+	bc66_set_release_assistance( bc66_rai_none );
+	return ret_code;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Publish Messages in data mode. 
+ * The message is written to the module straight from \p msg, without copying it 
+ * to the TX buffer, so it can hold any byte and does not need to be null terminated.
+ * 
+ * Firmware that answers the prompt request with +CME ERROR: 4 (not supported) 
+ * loses the data mode capability; then printable messages without '"' up to 
+ * 700 bytes are sent in the command line, and other messages are refused with 
+ * bc66_ret_no_cmd_implemented. 
+ * 
+ * @param topic		: Topic (not null terminated). The maximum length is 255 bytes. 
+ * @param topic_len	: Topic length. 
+ * @param msg 		: The message that needs to be published. The maximum length is 
+ * \p bc66_fw_info_t publish_max (1024 bytes in data mode). 
+ * @param msg_len	: Message length. 
+ * @param qos		: Integer type. The QoS level at which the client wants to publish the messages.
+ * - 0 At most once
+ * - 1 At least once
+ * - 2 Exactly once
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_publish_data_mqtt( const char * topic, size_t topic_len, const uint8_t * msg, size_t msg_len, int qos )
+{
+	const uint8_t TCP_connectID = 0;
+	const uint8_t end_of_data = CMD_END_OF_DATA;
+	/* Message identifier of packet. It will be 0 only when <qos>=0. */
+	uint16_t msgID;
+	int retain = 0;
+	bc66_ret_t ret_code;
+	size_t n;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (topic_len > BC66_MQTT_TOPIC_MAX_LEN) || (msg_len > (bc66->drv.fw.valid ? bc66->drv.fw.publish_max : BC66_MQTT_DATA_MODE_MAX_LEN)) || (qos < 0) || (qos > 2) ) { 
+		return bc66_ret_out_of_range;
+	}
+	msgID = qos ? _bc66_mqtt_next_msg_id() : 0;
+
+	if( bc66_has_cap( BC66_CAP_DATA_MODE ) ) { 
+		// command without message: module answers with data prompt 
+		ret_code = _bc66_send_at_line(BC66_CMD_WRITE,bc66_cmd_list_QMTPUB,"%u,%u,%u,%u,\"%.*s\"",TCP_connectID,msgID,qos,retain,(int)topic_len,topic);
+		if( ret_code == bc66_ret_success ) {
+			ret_code = _bc66_find_at_prompt( RSP_DATA_PROMPT, bc66_cmds_list[bc66_cmd_list_QMTPUB].rsp_timeout );
+		}
+		if( ret_code == bc66_ret_success ) { 
+			// message is sent from caller memory 
+			bc66->func_w_bytes_ptr( (uint8_t *)msg, msg_len );
+			bc66->func_w_bytes_ptr( (uint8_t *)&end_of_data, sizeof(end_of_data) );
+
+			return _bc66_mqtt_wait( bc66_rsp_QMTPUB, bc66_cmd_list_QMTPUB, msgID );
+		}
+		// a plain ERROR is a rejected publish (no connection, bad topic), not a missing feature 
+		if( (ret_code != bc66_ret_error) || (bc66->drv.result.err_code != CME_NOT_SUPPORTED) || bc66->drv.result.cms || !bc66->drv.fw.valid ) { 
+			return ret_code;
+		}
+		bc66->drv.fw.caps &= ~(uint32_t)BC66_CAP_DATA_MODE;
+		bc66->drv.fw.publish_max = BC66_MQTT_PUBLISH_MAX_LEN;
+	}
+
+	// command mode: the message must fit the command line between quotes 
+	if( msg_len > BC66_MQTT_PUBLISH_MAX_LEN ) { 
+		return bc66_ret_out_of_range;
+	}
+	for( n = 0; n < msg_len; n++ ) { 
+		if( (msg[n] < ' ') || (msg[n] > '~') || (msg[n] == '"') ) { 
+			return bc66_ret_no_cmd_implemented;
+		}
+	}
+	return _bc66_mqtt_packet(bc66_rsp_QMTPUB,bc66_cmd_list_QMTPUB,msgID,"%u,%u,%u,%u,\"%.*s\",\"%.*s\"",TCP_connectID,msgID,qos,retain,(int)topic_len,topic,(int)msg_len,(const char *)msg);
 }
 
+//*****************************************************************************
+/**
+ * @brief 
+ * Subscribe to Topics. 
+ * Received messages are reported by +QMTRECV: <TCP_connectID>,<msgID>,<topic>,<payload>
+ * 
+ * @param topic	: Topic that the client wants to subscribe to. The maximum length is 255 bytes. 
+ * @param qos	: Integer type. The QoS level at which the client wants to receive the messages.
+ * - 0 At most once
+ * - 1 At least once
+ * - 2 Exactly once
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_subscribe_mqtt( const char * topic, int qos )
+{
+	const uint8_t TCP_connectID = 0;
+	uint16_t msgID;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (strlen(topic) > BC66_MQTT_TOPIC_MAX_LEN) || (qos < 0) || (qos > 2) ) { 
+		return bc66_ret_out_of_range;
+	}
+	msgID = _bc66_mqtt_next_msg_id();
+
+	return _bc66_mqtt_packet(bc66_rsp_QMTSUB,bc66_cmd_list_QMTSUB,msgID,"%u,%u,\"%s\",%u",TCP_connectID,msgID,topic,qos);
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Unsubscribe from Topics. 
+ * 
+ * @param topic	: Topic that the client wants to unsubscribe from. The maximum length is 255 bytes. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_unsubscribe_mqtt( const char * topic )
+{
+	const uint8_t TCP_connectID = 0;
+	uint16_t msgID;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( strlen(topic) > BC66_MQTT_TOPIC_MAX_LEN ) { 
+		return bc66_ret_out_of_range;
+	}
+	msgID = _bc66_mqtt_next_msg_id();
+
+	return _bc66_mqtt_packet(bc66_rsp_QMTUNS,bc66_cmd_list_QMTUNS,msgID,"%u,%u,\"%s\"",TCP_connectID,msgID,topic);
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Publish Messages without blocking (see \p bc66_cmd_start(...)). 
+ * 
+ * @param done_cb	: function called when the publish ends (optional). 
+ * @param arg		: callback user argument. 
+ * @param topic		: Topic (not null terminated). The maximum length is 255 bytes. 
+ * @param topic_len	: Topic length. 
+ * @param msg 		: The message that needs to be published (not null terminated). The maximum length is 700 bytes. 
+ * @param msg_len	: Message length. 
+ * @param qos		: Integer type. The QoS level at which the client wants to publish the messages.
+ * 
+ * @return 
+ * bc66_ret_success if the command was sent, see \p bc66_ret_t return codes otherwise. 
+ */
+bc66_ret_t bc66_publish_msg_mqtt_start( bc66_done_cb_t done_cb, void * arg, const char * topic, size_t topic_len, const char * msg, size_t msg_len, int qos )
+{
+	const uint8_t TCP_connectID = 0;
+	uint16_t msgID;
+	int retain = 0;
+	char exp_rsp[24];
+	bc66_ret_t ret_code;
+
+	if( bc66 == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( (topic_len > BC66_MQTT_TOPIC_MAX_LEN) || (msg_len > BC66_MQTT_PUBLISH_MAX_LEN) || (qos < 0) || (qos > 2) ) { 
+		return bc66_ret_out_of_range;
+	}
+	if( bc66->drv.cmd.busy || _bc66_resync_busy() ) { 
+		return bc66_ret_busy;
+	}
+	msgID = qos ? _bc66_mqtt_next_msg_id() : 0;
+
+	ret_code = _bc66_send_at_line(BC66_CMD_WRITE,bc66_cmd_list_QMTPUB,"%u,%u,%u,%u,\"%.*s\",\"%.*s\"",TCP_connectID,msgID,qos,retain,(int)topic_len,topic,(int)msg_len,msg);
+	if( ret_code == bc66_ret_success ) { 
+		snprintf( exp_rsp, sizeof(exp_rsp), "+QMTPUB: %u,%u,", TCP_connectID, msgID );
+		_bc66_cmd_expect( exp_rsp, bc66_cmds_list[bc66_cmd_list_QMTPUB].rsp_timeout, true );
+		bc66->drv.cmd.pattern = &bc66->drv.rsp[bc66_rsp_QMTPUB];
+		bc66->drv.cmd.match = &bc66->drv.cmd.fields;
+		bc66->drv.cmd.done_cb = done_cb;
+		bc66->drv.cmd.arg = arg;
+	}
+	return ret_code;
+}
 
@@ -56,26 +56,19 @@
  *
  */
 
+#ifndef BC66_DRV_H_
+#define BC66_DRV_H_
+
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
 
-//*****************************************************************************
-/**
- * 
- */
-typedef struct {
-	void (*func_init_ptr)(); 								///< uart initialize function pointer
-	void (*func_delay)(uint32_t t);							///< delay function pointer
-	int (*func_w_bytes_ptr)(uint8_t * txc, uint16_t len); 	///< write bytes function pointer
-	int (*func_r_bytes_ptr)(uint8_t * rxc, uint16_t size ); ///< read bytes function pointer
-	struct  {
-		void (*MDM_PSM_EINT_N)(size_t pin_value);			///< Function pointer to interface: to handle PSM_EINT pin. 
-		void (*MDM_PWRKEY_N)(size_t pin_value);				///< Function pointer to interface: to handle PWRKEY pin. 
-		void (*MDM_RESET_N)(size_t pin_value);				///< Function pointer to interface: to handle RESET pin.
-		void (*MDM_RI)();									///< Function pointer to interface: to handle ring interrupt pin.
-	}control_lines;
-} bc66_obj_t ;
+#include "bc66_config.h"
+#include "bc66_cmds.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 //*****************************************************************************
 /// AT command posibility. Erch command can test and/or read and/or write and/or execute. Use with \p bc66_send_at_command(...) function.
@@ -86,44 +79,11 @@ typedef enum {
 	BC66_CMD_EXE					///< Send AT TEST command.
 } bc66_cmd_type_t ;
 
-/// This is the commands implemented list. 
+/// This is the commands implemented list (see bc66_cmds.h). 
 typedef enum { 
-	/* 1- AT command */
-	bc66_cmd_list_AT,				///< AT command. Use to sync baud rate. 
-	/* 2- Product Information Query Commands */
-	bc66_cmd_list_ATI,				///< Display Product Identification Information
-	/* 3- UART function commands */
-	bc66_cmd_list_ATE,				///< Set Command Echo Mode
-	/* 4- Network State Query Commands */
-	bc66_cmd_list_CEREG,			///< EPS Network Registration Status
-	bc66_cmd_list_CESQ,				///< Extended Signal Quality
-	bc66_cmd_list_CGATT,			///< PS Attachment or Detachment
-	bc66_cmd_list_CGPADDR,			///< Show PDP Addresses
-
-	/* PDN and APN Commands */
-	bc66_cmd_list_QCGDEFCONT,		///< Set Default PSD Connection Settings
-	/* 6- Other Network Commands */
-	bc66_cmd_list_QBAND,			///< Get and Set Mobile Operation Band
-	/* 7- USIM Related Commands */
-	bc66_cmd_list_CIMI,				///< Request International Mobile Subscriber Identity
-	bc66_cmd_list_CPIN,				///< Enter PIN
-	/* 8- Power Consumption Commands */ 
-	bc66_cmd_list_CPSMS,			///< Power Saving Mode Setting
-	bc66_cmd_list_QNBIOTEVENT,		///< Enable/Disable NB-IoT Related Event Report
-	bc66_cmd_list_QSCLK,			///< Configure Sleep Mode
-	/* 9- Platform Related Commands */ 
-	
-	/* 10- Time-related Commands */
-	
-	/* 11- Other Related Commands */ 
-	bc66_cmd_list_QMTCFG,			///< Configure Optional Parameters of MQTT
-	bc66_cmd_list_QMTOPEN,			///< Open a Network for MQTT Client
-	bc66_cmd_list_QMTCLOSE,			///< Close a Network for MQTT Client
-	bc66_cmd_list_QMTCONN,			///< Connect a Client to MQTT Server
-	bc66_cmd_list_QMTDISC,			///< Disconnect a Client from MQTT Server
-	bc66_cmd_list_QMTSUB,			///< Subscribe to Topics
-	bc66_cmd_list_QMTUNS,			///< Unsubscribe from Topics
-	bc66_cmd_list_QMTPUB,			///< Publish Messages
+#define BC66_CMD_ENUM( name, text, flags, timeout )		bc66_cmd_list_##name,
+	BC66_CMDS_TABLE( BC66_CMD_ENUM )
+#undef BC66_CMD_ENUM
 	/* No command - list size */
 	bc66_cmd_list_size				///< Is not a command. Only to know commands quantity.
 } bc66_cmd_list_t ;
@@ -143,222 +103,1454 @@ typedef enum
 	bc66_ret_packet_fail, 				///< Failed to send packet
 	bc66_ret_err_protocol,				///< Connection Refused: Unacceptable Protocol Version
 	bc66_ret_id_rejected,				///< Connection Refused: Identifier Rejected
-	bc66_ret_no_cmd_implemented			///< RSP_NO_CMD_IMPEMENTED
+	bc66_ret_no_cmd_implemented,		///< RSP_NO_CMD_IMPEMENTED
+	bc66_ret_no_time,					///< Network time not synchronized
+	bc66_ret_queue_full,				///< No room left in a driver queue
+	bc66_ret_cancelled,					///< Command cancelled by \p bc66_cmd_cancel()
+	bc66_ret_busy						///< A command is waiting its response
 } bc66_ret_t ;
 
 //*****************************************************************************
-/// Enumeration to specify the type of packet data protocol. 
-typedef enum {
-	pdp_type_ip, 					///< Internet Protocol (IETF STD 5).
-	pdp_type_ipv6,					///< Internet Protocol version 6 (IETF RFC 2460).
-	pdp_type_ipv4v6,				///< Dual IP stack (see 3GPP TS 24.301).
-	pdp_type_non_ip					///< Transfer of Non-IP data to external packet network (see 3GPP TS 24.301).
-} pdp_type_t ;
+/// Enumeration to specify the type of packet data protocol. 
+typedef enum {
+	pdp_type_ip, 					///< Internet Protocol (IETF STD 5).
+	pdp_type_ipv6,					///< Internet Protocol version 6 (IETF RFC 2460).
+	pdp_type_ipv4v6,				///< Dual IP stack (see 3GPP TS 24.301).
+	pdp_type_non_ip					///< Transfer of Non-IP data to external packet network (see 3GPP TS 24.301).
+} pdp_type_t ;
+
+/// Struct to store IP ADDRESS. 
+typedef struct {
+	uint8_t	a1;
+	uint8_t	a2;
+	uint8_t	a3;
+	uint8_t	a4;
+} bc66_ip_add_t ;
+
+/// Struct to store IPv6 ADDRESS (a[0] is the most significant byte). 
+typedef struct {
+	uint8_t	a[16];
+} bc66_ip6_add_t ;
+
+/// Addresses of a PDP context. 
+typedef struct {
+	uint8_t			cid;			///< context identifier
+	bool			ipv4;			///< \p v4 is valid
+	bool			ipv6;			///< \p v6 is valid
+	bc66_ip_add_t	v4;				///< IPv4 address
+	bc66_ip6_add_t	v6;				///< IPv6 address
+} bc66_pdp_addr_t ;
+
+#define BC66_CELL_NO_VALUE		INT16_MIN			///< Value not reported in \p bc66_cell_info_t
+
+/// Coverage enhancement level. 
+typedef enum {
+	bc66_ecl_0,						///< Normal coverage.
+	bc66_ecl_1,						///< Extended coverage (repetitions).
+	bc66_ecl_2,						///< Extreme coverage (max repetitions).
+	bc66_ecl_unknown = 0xFF			///< Not camped on a cell.
+} bc66_ecl_t ;
+
+/// Release assistance indication (AT+QNBIOTRAI). 
+typedef enum {
+	bc66_rai_none,					///< No information available.
+	bc66_rai_no_data,				///< No further uplink or downlink data expected.
+	bc66_rai_one_downlink			///< Only one downlink data expected after the uplink.
+} bc66_rai_t ;
+
+/// Firmware capabilities, see \p bc66_probe_capabilities(...). 
+typedef enum {
+	BC66_CAP_DATA_MODE	= 0x01,		///< MQTT publish in data mode (AT+QMTPUB without message, '>' prompt), assumed, not probed
+	BC66_CAP_RAI		= 0x02,		///< release assistance indication (AT+QNBIOTRAI)
+	BC66_CAP_QENG		= 0x04,		///< engineering mode (AT+QENG)
+	BC66_CAP_QLOCKF		= 0x08,		///< frequency lock (AT+QLOCKF)
+	BC66_CAP_CTZR		= 0x10		///< time zone report (AT+CTZR)
+} bc66_cap_t ;
+
+/// Product identification and firmware capabilities (ATI, AT+CGMR). 
+typedef struct {
+	bool		valid;							///< probe done
+	char		manufacturer[BC66_FW_ID_SIZE];	///< manufacturer, i.e. "Quectel_Ltd"
+	char		model[BC66_FW_ID_SIZE];			///< model, i.e. "Quectel_BC66"
+	char		revision[BC66_FW_ID_SIZE];		///< firmware revision, i.e. "BC66NBR01A07"
+	uint8_t		major;							///< revision number (R01 -> 1), 0 if unknown, informational
+	uint8_t		minor;							///< edition number (A07 -> 7), 0 if unknown, informational
+	uint16_t	publish_max;					///< MQTT message max length of \p bc66_publish_data_mqtt(...), assumed, not probed
+	uint32_t	caps;							///< \p bc66_cap_t flags
+} bc66_fw_info_t ;
+
+/// Neighbour cell (+QENG: 1,...). 
+typedef struct {
+	uint32_t		earfcn;			///< EARFCN
+	int16_t			earfcn_offset;	///< EARFCN offset
+	uint16_t		pci;			///< physical cell ID
+	int16_t			rsrp;			///< RSRP
+} bc66_ncell_t ;
+
+/// Engineering mode snapshot (AT+QENG=0). Radio values are the module ones (BC66: dBm, dB). 
+typedef struct {
+	bool			camped;			///< serving cell values are valid
+	uint32_t		earfcn;			///< serving cell EARFCN
+	int16_t			earfcn_offset;	///< serving cell EARFCN offset
+	uint16_t		pci;			///< serving cell physical cell ID
+	uint32_t		cell_id;		///< serving cell ID
+	int16_t			rsrp;			///< RSRP
+	int16_t			rsrq;			///< RSRQ
+	int16_t			rssi;			///< RSSI
+	int16_t			sinr;			///< SINR
+	uint8_t			band;			///< band
+	uint16_t		tac;			///< tracking area code
+	bc66_ecl_t		ecl;			///< coverage enhancement level
+	int16_t			tx_pwr;			///< UE transmit power
+	uint8_t			op_mode;		///< operation mode (in-band, guard-band, standalone)
+	uint8_t			ncell_count;	///< neighbour cells in \p ncell
+	bc66_ncell_t	ncell[BC66_MAX_NEIGHBOUR_CELLS];	///< neighbour cells
+} bc66_cell_info_t ;
+
+/// Network bring-up stages. 
+typedef enum {
+	bc66_attach_sim,				///< Waiting SIM ready (+CPIN: READY).
+	bc66_attach_reg,				///< Waiting registration (+CEREG: 1 or 5).
+	bc66_attach_pdp,				///< Waiting PDP context activation.
+	bc66_attach_ip,					///< Waiting IP address.
+	bc66_attach_done				///< Bring-up finished.
+} bc66_attach_stage_t ;
+
+/// Network bring-up configuration. 
+typedef struct {
+	uint32_t		timeout[bc66_attach_done];	///< stage timeouts [ms]
+	uint32_t		poll;						///< stage query period without URC [ms]
+	uint8_t			cid;						///< PDP context
+	bool			attach;						///< send AT+CGATT=1 (auto attach disabled)
+} bc66_attach_cfg_t ;
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Network bring-up progress. Called when a stage ends or fails. 
+ * 
+ * @param stage		: stage that ended, bc66_attach_done at the end. 
+ * @param ret_code	: bc66_ret_success, or bc66_ret_timeout / bc66_ret_error if the bring-up failed. 
+ * @param latency	: stage duration, whole bring-up for bc66_attach_done [ms]. 
+ * @param arg		: callback user argument. 
+ */
+typedef void (*bc66_attach_cb_t)( bc66_attach_stage_t stage, bc66_ret_t ret_code, uint32_t latency, void * arg );
+
+/// Last known good network, kept by the host between power cycles. 
+typedef struct {
+	bool			valid;					///< network is known
+	uint8_t			band;					///< band
+	uint32_t		earfcn;					///< EARFCN
+	int16_t			earfcn_offset;			///< EARFCN offset
+	char			plmn[BC66_PLMN_SIZE];	///< numeric PLMN, empty if unknown
+} bc66_net_cache_t ;
+
+/// Called to store a new last known good network. 
+typedef void (*bc66_net_cache_save_t)( const bc66_net_cache_t * cache, void * arg );
+
+/// Firmware update (DFOTA) phases. 
+typedef enum {
+	bc66_fota_idle,					///< No update.
+	bc66_fota_download,				///< Module downloading the image (+QIND: "FOTA","DOWNLOADING").
+	bc66_fota_update,				///< Module writing the new firmware (+QIND: "FOTA","UPDATING").
+	bc66_fota_verify,				///< Waiting the module to answer with the new revision.
+	bc66_fota_done,					///< New firmware running.
+	bc66_fota_failed				///< Update failed, see \p bc66_fota_state_t err.
+} bc66_fota_phase_t ;
+
+/// Firmware update state, kept by the host to resume the update after a reboot. 
+typedef struct {
+	bc66_fota_phase_t	phase;							///< current phase
+	char				url[BC66_FOTA_URL_SIZE];		///< image URL
+	char				from_rev[BC66_FW_ID_SIZE];		///< revision before the update, empty if unknown
+	uint32_t			image_size;						///< image size [bytes], 0 if unknown
+	uint8_t				progress;						///< current phase progress [%]
+	uint8_t				attempts;						///< download requests
+	int16_t				err;							///< module error code of the failure, 0 if none
+	uint32_t			phase_time[bc66_fota_done];		///< time in each phase [ms]
+} bc66_fota_state_t ;
+
+/// Called to store the firmware update state. 
+typedef void (*bc66_fota_save_t)( const bc66_fota_state_t * state, void * arg );
+
+/// Module recovery tiers, from the cheapest one. 
+typedef enum {
+	bc66_health_ok,					///< Module answers, no recovery running.
+	bc66_health_probe,				///< AT probe after command timeouts or idle time.
+	bc66_health_resync,				///< Escape a pending data prompt and resync with a marker command.
+	bc66_health_reset,				///< RESET pin pulse, see \p bc66_hw_reset().
+	bc66_health_power				///< Power cycle (PWRKEY or host hook).
+} bc66_health_tier_t ;
+
+/// Liveness monitor configuration. 
+typedef struct {
+	uint8_t		max_timeouts;				///< consecutive command timeouts that start a recovery
+	uint8_t		probes;						///< AT probes on each tier before escalating
+	uint32_t	idle;						///< time without received chars before a probe [ms]
+	uint32_t	boot;						///< wait after a reset or power cycle [ms]
+	uint32_t	retry;						///< power cycle period while the module does not answer [ms]
+	void		(*power_cycle)( void * arg );	///< host supply switch, NULL to use PWRKEY. Called with the callback user argument.
+} bc66_health_cfg_t ;
+
+/// Liveness monitor metrics. Time to recover runs from the first timeout (or the failed 
+/// idle probe) to the module answering again with its settings replayed. 
+typedef struct {
+	uint32_t	recoveries[bc66_health_power + 1];	///< recoveries per tier; bc66_health_ok counts idle probes answered at once
+	uint32_t	failures;					///< power cycles without answer
+	uint32_t	replay_errors;				///< cached settings refused after a restart
+	uint32_t	cfg_dropped;				///< settings that did not fit in the cache
+	uint32_t	last_ttr;					///< last time to recover [ms]
+	uint32_t	max_ttr;					///< worst time to recover [ms]
+	uint32_t	mttr;						///< mean time to recover [ms]
+	uint32_t	total_ttr;					///< time to recover of all recoveries [ms]
+} bc66_health_stats_t ;
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Liveness monitor progress. Called when a recovery tier ends. 
+ * 
+ * @param tier		: tier that ended. 
+ * @param ret_code	: bc66_ret_success if the module answers again, bc66_ret_fail if 
+ * the next tier follows. 
+ * @param elapsed	: time since the fault was detected [ms]. 
+ * @param arg		: callback user argument. 
+ */
+typedef void (*bc66_health_cb_t)( bc66_health_tier_t tier, bc66_ret_t ret_code, uint32_t elapsed, void * arg );
+
+/// Response pattern element kinds. 
+typedef enum {
+	bc66_pat_end,					///< End of pattern.
+	bc66_pat_lit,					///< Literal text.
+	bc66_pat_int,					///< %d: signed integer field.
+	bc66_pat_quoted,				///< %q: quoted string field, captured without quotes.
+	bc66_pat_alt,					///< (a|b): alternative literals, the index is the field value.
+	bc66_pat_opt					///< [: the rest may be missing at the end of the line.
+} bc66_pat_op_t ;
+
+/// Compiled response pattern element. 
+typedef struct {
+	uint8_t			op;				///< \p bc66_pat_op_t
+	uint8_t			count;			///< alternatives count
+	uint16_t		pos;			///< text position in the pattern source
+	uint16_t		len;			///< text length
+} bc66_pat_elem_t ;
+
+/// Compiled response pattern, see \p bc66_pattern_compile(...). 
+typedef struct {
+	const char		*src;							///< pattern source: literals are not copied, keep it
+	bc66_pat_elem_t	elem[BC66_PATTERN_MAX_ELEMS];	///< elements, bc66_pat_end terminated
+	uint8_t			fields;							///< fields captured
+} bc66_pattern_t ;
+
+/// Fields captured by a response pattern, in pattern order. 
+typedef struct {
+	uint8_t			count;			///< fields captured (fewer if an optional tail was missing)
+	struct {
+		const char	*str;			///< field text, not null terminated (in the last response)
+		uint16_t	len;			///< field text length
+		int32_t		num;			///< integer value or alternative index, 0 for quoted fields
+	} field[BC66_PATTERN_MAX_FIELDS];
+} bc66_match_t ;
+
+/// Driver response patterns list (see bc66_cmds.h). 
+typedef enum { 
+#define BC66_RSP_ENUM( name, src )		bc66_rsp_##name,
+	BC66_RSP_PATTERNS( BC66_RSP_ENUM )
+#undef BC66_RSP_ENUM
+	bc66_rsp_list_size				///< Is not a pattern. Only to know patterns quantity.
+} bc66_rsp_list_t ;
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Callback to report the end of an asynchronous command. 
+ * Use with \p bc66_cmd_start(...) function. 
+ * 
+ * @param ret_code	: command result (see \p bc66_ret_t return codes). 
+ * @param arg		: callback user argument. 
+ */
+typedef void (*bc66_done_cb_t)( bc66_ret_t ret_code, void * arg );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Result of the last command. See \p bc66_get_last_result(...). 
+ * 
+ * A failure with a short \p elapsed (ERROR, +CME ERROR) was answered by the module 
+ * and can be retried at once; a timeout or a slow failure means the module or 
+ * the network is busy and the retry should back off.
+ */
+typedef struct {
+	bc66_ret_t 		status;							///< command return code
+	int16_t 		err_code;						///< +CME ERROR / +CMS ERROR number, BC66_NO_ERR_CODE if none
+	bool 			cms;							///< err_code is a +CMS ERROR (message service) number
+	bc66_cmd_type_t cmd_type;						///< command type issued
+	bc66_cmd_list_t cmd;							///< command issued
+	uint32_t 		elapsed;						///< time from command sent to its end [ms]
+	uint8_t 		retransmissions;				///< MQTT packet retransmissions reported by the module
+	uint16_t 		seq;							///< command sequence number (one per command line sent)
+	uint16_t 		late_answers;					///< late answers of timed out commands dropped so far
+} bc66_result_t ;
+
+#define BC66_NO_ERR_CODE		(-1)				///< \p bc66_result_t err_code when there is not an error number
+
+/// Driver working data of one module. Private: use the driver API to access it.
+typedef struct {
+	uint8_t 	tx_buffer[BC66_TX_BUFFER_SIZE];		///< AT command line
+	uint8_t 	rx_buffer[BC66_RX_BUFFER_SIZE];		///< received chars (always null terminated)
+	size_t 		tx_len;								///< command line length in tx_buffer
+	size_t 		rx_len;								///< received chars in rx_buffer
+	union {
+		uint8_t buf[BC66_ARENA_SIZE];
+		void 	*align;
+	} arena;										///< per command scratch memory: arguments and responses found
+	size_t 		arena_top;							///< arena memory used
+	char 		*last_rsp;							///< last valid answer (allocated in arena)
+	uint16_t 	mqtt_msg_id;						///< last MQTT packet identifier used
+	uint16_t 	mqtt_session;						///< MQTT connection number, changes when the connection is closed
+	bool 		init;								///< module initialized
+	bc66_pattern_t 	rsp[bc66_rsp_list_size];		///< driver response patterns, compiled by \p bc66_init(...)
+	struct {
+		bool 			busy;						///< command waiting response
+		bool 			mqtt_result;				///< response carries a MQTT packet <result>
+		char 			exp_rsp[BC66_EXP_RSP_SIZE];	///< expected response
+		uint32_t 		start;						///< tick when command was sent [ms]
+		uint32_t 		polls;						///< response checks since command was sent (1 ms each when blocking)
+		uint32_t 		timeout;					///< response timeout or remaining polls [ms]
+		const bc66_pattern_t *pattern;				///< expected response pattern, NULL to find exp_rsp
+		bc66_match_t 	*match;						///< fields captured by \p pattern
+		bc66_match_t 	fields;						///< fields captured by an asynchronous command
+		bc66_done_cb_t 	done_cb;					///< asynchronous command end callback
+		void 			*arg;						///< callback user argument
+		uint16_t 		seq;						///< sequence number of the last command sent
+	} cmd;											///< running command
+	struct {
+		uint16_t 		seq;						///< sequence number of the stale command
+		bc66_cmd_list_t cmd;						///< stale command
+		char 			exp[BC66_EXP_RSP_SIZE];		///< late answer to drop, empty if none
+		bool 			frc;						///< final result code not received yet
+		bool 			prompt;						///< module may be waiting data after a prompt
+		uint32_t 		until;						///< late answer drop deadline [ms]
+		bool 			resync;						///< resync marker sent, its answer not received yet
+		uint8_t 		markers;					///< marker answers ("Revision:" lines) still expected
+		uint32_t 		start;						///< marker sent tick [ms]
+		uint32_t 		polls;						///< resync checks (1 ms each without tick)
+		bc66_done_cb_t 	ready_cb;					///< called by \p bc66_process() once idle
+		void 			*ready_arg;					///< ready callback user argument
+	} stale;										///< last timed out or cancelled command
+	struct {
+		bool 			armed;						///< echo of the command line not received yet
+		size_t 			pos;						///< command line chars echoed so far (dropped, they are in tx_buffer)
+	} echo;											///< command echo stripping
+	bc66_result_t 	result;							///< last command result
+	size_t 			urc_scan;						///< rx_buffer chars already checked for URCs
+	void (*urc_cb)( const char * line, uint16_t len, bool partial, void * arg );	///< lines not handled by the driver while idle (\p bc66_line_cb_t)
+	void 			*urc_arg;						///< \p urc_cb user argument
+	bc66_pdp_addr_t pdp_addr[BC66_PDP_CONTEXTS];	///< PDP addresses cache
+	uint8_t 		pdp_addr_count;					///< PDP contexts in cache
+	bool 			pdp_addr_valid;					///< cache is up to date
+	uint8_t 		pdp_addr_gen;					///< cache invalidations count
+	struct {
+		uint32_t 		utc;						///< UTC time at \p tick [s since 1970]
+		uint32_t 		tick;						///< tick of \p utc [ms]
+		int8_t 			tz;							///< time zone [quarters of an hour]
+		bool 			valid;						///< \p utc and \p tick are synchronized
+		bool 			tz_valid;					///< \p tz received
+	} time;											///< network time
+	struct {
+		bc66_net_cache_t 		lkg;				///< last known good network
+		bc66_net_cache_save_t 	save;				///< host store hook
+		void 					*arg;				///< hook user argument
+		uint8_t 				bands[BC66_MAX_LOCKED_BANDS];	///< bands before lock
+		uint8_t 				band_count;			///< bands before lock count (0 = all)
+		bool 					bands_saved;		///< \p bands hold the bands before lock
+		bool 					locked;				///< locked search running
+		bool 					cops_pending;		///< AT+COPS=1 running
+		bc66_ret_t 				cops_ret;			///< AT+COPS=1 result
+		uint32_t 				start;				///< lock tick [ms]
+		uint32_t 				deadline;			///< max search time [ms]
+		uint8_t 				cops_format;		///< last +COPS: <format>
+	} net_cache;									///< band / EARFCN / PLMN cache
+	bc66_fw_info_t 	fw;								///< firmware identification and capabilities
+	uint8_t 		reg_stat;						///< last +CEREG <stat>
+	struct {
+		bc66_fota_state_t 	state;					///< persistent state
+		bc66_fota_save_t 	save;					///< host store hook
+		void 				*arg;					///< hook user argument
+		bool 				active;					///< update running
+		bool 				dirty;					///< state to save
+		bool 				retry;					///< download to request again
+		uint8_t 			saved_progress;			///< progress of the last save [%]
+		uint32_t 			tick;					///< last phase time update [ms]
+		bool 				probe;					///< revision query due (module booted)
+		bool 				late_probe;				///< revision queried without boot indication
+		bool 				wait_quiet;				///< resumed download: wait its progress URCs first
+		uint32_t 			verify_start;			///< verify phase start tick [ms]
+		uint32_t 			last_urc;				///< last +QIND: "FOTA" tick [ms]
+	} fota;											///< firmware update
+	struct {
+		bool 			known;						///< a +CPIN line was received
+		bool 			ready;						///< +CPIN: READY
+		bool 			imsi_valid;					///< \p imsi read
+		bool 			iccid_valid;				///< \p iccid read
+		char 			imsi[BC66_IMSI_SIZE];		///< IMSI
+		char 			iccid[BC66_ICCID_SIZE];		///< ICCID
+	} sim;											///< SIM state and identity cache
+	struct {
+		bool 				active;					///< bring-up running
+		bc66_attach_stage_t stage;					///< current stage
+		bc66_attach_cfg_t 	cfg;					///< configuration
+		bc66_attach_cb_t 	cb;						///< progress callback
+		void 				*arg;					///< callback user argument
+		uint32_t 			start;					///< bring-up start tick [ms]
+		uint32_t 			stage_start;			///< stage start tick [ms]
+		uint32_t 			last_probe;				///< last stage query tick [ms]
+		uint32_t 			latency[bc66_attach_done + 1];	///< stage durations [ms]
+		bool 				attach_sent;			///< AT+CGATT=1 sent
+		bool 				pdp_active;				///< PDP context active
+		bool 				ip;						///< PDP context has an address
+	} attach;										///< network bring-up
+	struct {
+		bool 				active;					///< monitor running
+		bc66_health_cfg_t 	cfg;					///< configuration
+		bc66_health_cb_t 	cb;						///< progress callback
+		void 				*arg;					///< callback user argument
+		bc66_health_tier_t 	tier;					///< recovery tier running
+		bool 				idle_probe;				///< probe started by idle time, not by timeouts
+		uint8_t 			timeouts;				///< consecutive command timeouts
+		uint32_t 			last_rx;				///< last received chars tick [ms]
+		uint32_t 			fault_start;			///< first timeout or failed probe tick [ms]
+		uint32_t 			wait_until;				///< module restart wait end [ms]
+		bc66_health_stats_t stats;					///< metrics
+	} health;										///< liveness monitor
+	struct {
+		uint8_t 		buf[BC66_CFG_CACHE_SIZE];	///< entries: command, type, length, line without <CR><LF>
+		uint16_t 		len;						///< bytes used
+		bool 			replaying;					///< settings being sent again, do not cache
+	} cfg_cache;									///< settings sent, in order
+#if BC66_RX_RING_SIZE
+	struct {
+		uint8_t 			buf[BC66_RX_RING_SIZE];	///< received bytes
+		volatile uint32_t 	head;					///< bytes written, only by \p bc66_rx_feed()
+		volatile uint32_t 	tail;					///< bytes read, only by the driver
+		volatile uint32_t 	dropped;				///< bytes lost with the ring full, only by \p bc66_rx_feed()
+	} ring;											///< push input (single producer, single consumer)
+#endif
+} bc66_drv_t ;
+
+//*****************************************************************************
+/**
+ * 
+ */
+typedef struct {
+	void (*func_init_ptr)(); 								///< uart initialize function pointer
+	void (*func_delay)(uint32_t t);							///< delay function pointer
+	int (*func_w_bytes_ptr)(uint8_t * txc, uint16_t len); 	///< write bytes function pointer
+	int (*func_r_bytes_ptr)(uint8_t * rxc, uint16_t size ); ///< read bytes function pointer. Must return the number of bytes read. NULL to push bytes with \p bc66_rx_feed() (needs BC66_RX_RING_SIZE).
+	struct  {
+		void (*MDM_PSM_EINT_N)(size_t pin_value);			///< Function pointer to interface: to handle PSM_EINT pin. 
+		void (*MDM_PWRKEY_N)(size_t pin_value);				///< Function pointer to interface: to handle PWRKEY pin. 
+		void (*MDM_RESET_N)(size_t pin_value);				///< Function pointer to interface: to handle RESET pin.
+		void (*MDM_RI)();									///< Function pointer to interface: to handle ring interrupt pin.
+	}control_lines;
+	uint32_t (*func_get_tick)(void);						///< monotonic time [ms] function pointer (optional, needed by asynchronous commands).
+	void *user_ctx;											///< user context, i.e. UART port. See \p bc66_selected().
+	bc66_drv_t drv;											///< driver data, do not access.
+} bc66_obj_t ;
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Callback to receive each intermediate response line of a command. 
+ * Use with \p bc66_send_at_command_lines(...) function.
+ * 
+ * @param line		: response line, without <CR><LF> and not null terminated. 
+ * @param len		: line length. 
+ * @param partial	: true if the line is longer than RX buffer and continues in the next call. 
+ * @param arg		: callback user argument. 
+ */
+typedef void (*bc66_line_cb_t)( const char * line, uint16_t len, bool partial, void * arg );
+
+/// Caller buffer to collect response lines. Use with \p bc66_line_arena_collect(...) as line callback.
+typedef struct {
+	char 		*buf;			///< caller buffer. Lines are stored null terminated one after the other.
+	size_t 		size;			///< buffer size
+	size_t 		used;			///< bytes used
+	uint16_t 	lines;			///< lines stored
+	bool 		partial;		///< last line stored is not complete yet
+	bool 		overflow;		///< at least one line did not fit in buffer
+} bc66_line_arena_t ;
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to initialize bc66 object. 
+ * 
+ * @param bc66_obj 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_init(bc66_obj_t *bc66_obj);
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to release bc66 object. 
+ * 
+ * @param bc66_obj 
+ */
+void bc66_deinit(bc66_obj_t *bc66_obj);
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Push received bytes to a module, i.e. from the UART ISR or the DMA half/full 
+ * transfer callback, when \p func_r_bytes_ptr is NULL. Wait-free: bytes are copied 
+ * to the module receive ring, bytes that do not fit are dropped and counted. 
+ * Only one context may feed a module; the driver reads the ring when it polls. 
+ * Needs BC66_RX_RING_SIZE (0 by default: nothing is stored). 
+ * 
+ * @param bc66_obj	: initialized bc66 object (the selected module is not used). 
+ * @param bytes		: received bytes. 
+ * @param len		: bytes count. 
+ * 
+ * @return 
+ * Bytes stored.
+ */
+size_t bc66_rx_feed( bc66_obj_t * bc66_obj, const uint8_t * bytes, size_t len );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the received bytes dropped by \p bc66_rx_feed(...) because the ring was full. 
+ * 
+ * @param dropped : bytes dropped since \p bc66_init(...). 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_rx_dropped( uint32_t * dropped );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Select the module used by all the driver functions. 
+ * \p bc66_init(...) selects the module it initializes. Use to drive several modules.
+ * The selection is per thread when BC66_THREAD_LOCAL is defined (see bc66_config.h).
+ * 
+ * @param bc66_obj : initialized bc66 object.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_select(bc66_obj_t *bc66_obj);
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the selected module, i.e. from HAL functions to find their port through \p user_ctx. 
+ * 
+ * @return 
+ * Selected bc66 object or NULL.
+ */
+bc66_obj_t * bc66_selected( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to get any response stored in the RX buffer.
+ * 
+ * @param rsp	: response to get 
+ * 
+ * @return 
+ * Response if found, NULL otherwise
+ */
+char * bc66_get_at_response( char * rsp );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to send at command sentence to bc66 module through an external function communication. 
+ * 
+ * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
+ * @param cmd_lst 	: command to send (see command list). 
+ * @param rsp 		: pointer to expected response text. 
+ * @param arg_fmt 	: arguments format (like printf function) and must be sended all arguments too.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+bc66_ret_t bc66_send_at_command(bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char *exp_rsp, const char * arg_fmt, ...);
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to send at command sentence which start (i.e. "AT+QMTPUB=") was built by the caller. 
+ * Used by the C++ layer (bc66_cmds.hpp) to send command lines built at compile time.
+ * 
+ * @param cmd_type	: command type of \p prefix, for \p bc66_get_last_result(...). 
+ * @param cmd_lst 	: command to send (see command list), gives response and timeout. 
+ * @param prefix 	: command line start, not null terminated. 
+ * @param prefix_len: command line start length. 
+ * @param exp_rsp 	: pointer to expected response text or NULL to wait command response. 
+ * @param arg_fmt 	: arguments format (like printf function) or NULL.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+bc66_ret_t bc66_send_at_prefixed(bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char *prefix, size_t prefix_len, const char *exp_rsp, const char * arg_fmt, ...);
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to send at command sentence without blocking. 
+ * The response is processed by \p bc66_process(), which calls \p done_cb when 
+ * the expected response arrives or the command times out. Only one command per 
+ * module can be running.
+ * 
+ * Timeouts use \p func_get_tick. Without it, each \p bc66_process() call counts as 1 ms.
+ * 
+ * After a timed out or cancelled command the module is resynchronized first 
+ * (see \p bc66_resync()): the marker is sent and this call returns bc66_ret_busy 
+ * until \p bc66_process() receives its answer. 
+ * 
+ * @param done_cb	: function called when the command ends (optional). 
+ * @param arg		: callback user argument. 
+ * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
+ * @param cmd_lst 	: command to send (see command list). 
+ * @param exp_rsp 	: pointer to expected response text or NULL to wait command response. 
+ * @param arg_fmt 	: arguments format (like printf function) and must be sended all arguments too.
+ * 
+ * @return 
+ * bc66_ret_success if the command was sent, bc66_ret_busy while a command or a 
+ * resync runs (see \p bc66_cmd_wait_ready(...)), see \p bc66_ret_t return codes otherwise. 
+ */
+bc66_ret_t bc66_cmd_start(bc66_done_cb_t done_cb, void * arg, bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char *exp_rsp, const char * arg_fmt, ...);
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Process received chars of the selected module. 
+ * Ends the running asynchronous command, if any, calling its \p done_cb, or 
+ * advances the resync that follows a timed out command. 
+ * Call it periodically (i.e. every 1 ms) or when the UART has new chars.
+ * While idle, URCs handled by the driver are dropped and other lines (i.e. 
+ * +QMTRECV) go to the \p bc66_set_urc_callback(...) callback. Without callback 
+ * they stay in RX buffer for \p bc66_get_at_response(...). 
+ */
+void bc66_process( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set the callback of the received lines the driver does not handle, i.e. 
+ * +QMTRECV messages. Lines are delivered and dropped by \p bc66_process(...) 
+ * while no command runs. 
+ * 
+ * @param urc_cb	: line callback (partial is always false), NULL to keep the lines in RX buffer. 
+ * It must not send commands. 
+ * @param arg		: callback user argument. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_urc_callback( bc66_line_cb_t urc_cb, void * arg );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check if the selected module has a command waiting its response, or a resync 
+ * running: \p bc66_process(...) must be called and new asynchronous commands 
+ * get bc66_ret_busy. 
+ * 
+ * @return 
+ * true if a command or a resync is running.
+ */
+bool bc66_cmd_busy( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Call a function from \p bc66_process(...) once the selected module is idle 
+ * (no command and no resync running), i.e. to start again an asynchronous 
+ * command that got bc66_ret_busy. It is called once. 
+ * 
+ * @param ready_cb	: function called with bc66_ret_success, NULL to clear. 
+ * @param arg		: callback user argument. 
+ * 
+ * @return 
+ * bc66_ret_busy if another function is waiting, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_cmd_wait_ready( bc66_done_cb_t ready_cb, void * arg );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Cancel the running asynchronous command of the selected module. Its \p done_cb 
+ * is called with bc66_ret_cancelled. The module may still answer it: the late 
+ * final result code is drained before the next command and its late response 
+ * line is dropped when it arrives. 
+ * 
+ * @return 
+ * bc66_ret_fail if no command is running, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_cmd_cancel( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Resynchronize with the module: send ATI as marker and drop every answer received 
+ * before the marker answer. Done automatically before the next command after a 
+ * timeout or a cancel (asynchronous commands let \p bc66_process(...) run it 
+ * without blocking); call it after a host restart to drop answers of commands 
+ * sent by the previous run. Blocks up to BC66_RESYNC_TIMEOUT. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_resync( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to send at command sentence and collect all its response lines. 
+ * Each intermediate line is handed to \p line_cb until the final result code 
+ * (OK, ERROR, +CME ERROR or +CMS ERROR), so there is no max response size. 
+ * The final result code is available with \p bc66_get_last_response(). 
+ * 
+ * @param line_cb	: function called for each intermediate response line. 
+ * @param arg		: callback user argument (i.e. a \p bc66_line_arena_t). 
+ * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
+ * @param cmd_lst 	: command to send (see command list). 
+ * @param arg_fmt 	: arguments format (like printf function) and must be sended all arguments too.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+bc66_ret_t bc66_send_at_command_lines(bc66_line_cb_t line_cb, void * arg, bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char * arg_fmt, ...);
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Compile a response pattern. Call it once and keep the pattern: each match is 
+ * then a single pass over the line that also captures the fields. 
+ * - text: literal, matched from the line start 
+ * - %d: signed integer field 
+ * - %q: quoted string field 
+ * - (a|b|c): alternative literals, the first that matches; its index is the field value 
+ * - [...]: optional tail, at the end of the pattern: it may be missing at the end of the line 
+ * - %%, %(, %), %|, %[, %]: the char itself 
+ * 
+ * i.e. "+QMTCONN: 0,%d[,%d]" or "+CPIN: (READY|SIM PIN|SIM PUK)". 
+ * 
+ * @param pat	: compiled pattern. 
+ * @param src	: pattern source, must outlive \p pat (i.e. a string literal). 
+ * 
+ * @return 
+ * bc66_ret_out_of_range if the pattern is wrong or too long, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_pattern_compile( bc66_pattern_t * pat, const char * src );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Match a line against a compiled pattern. Text after the pattern is ignored. 
+ * 
+ * @param pat	: compiled pattern. 
+ * @param line	: line, without <CR><LF>. 
+ * @param len	: line length. 
+ * @param match	: fields captured, they point into \p line. 
+ * 
+ * @return 
+ * true if the line matches.
+ */
+bool bc66_pattern_match( const bc66_pattern_t * pat, const char * line, size_t len, bc66_match_t * match );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to send at command sentence and wait the first response line that 
+ * matches a compiled pattern. 
+ * 
+ * @param pat		: compiled response pattern. 
+ * @param match		: fields captured, they point into the last response. 
+ * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
+ * @param cmd_lst 	: command to send (see command list). 
+ * @param arg_fmt 	: arguments format (like printf function) and must be sended all arguments too.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+bc66_ret_t bc66_send_at_command_match(const bc66_pattern_t * pat, bc66_match_t * match, bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char * arg_fmt, ...);
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Line callback to store response lines in a caller buffer (\p bc66_line_arena_t). 
+ * 
+ * @param line		: response line. 
+ * @param len		: line length. 
+ * @param partial	: true if the line continues in the next call. 
+ * @param arg		: pointer to \p bc66_line_arena_t. 
+ */
+void bc66_line_arena_collect( const char * line, uint16_t len, bool partial, void * arg );
+
+//*****************************************************************************
+/**
+ * @brief
+ * Reset the module via Hardware PIN.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_hw_reset( void );
+
+//*****************************************************************************
+/**
+ * @brief
+ * Pull down PWRKEY to turn on the module
+ */
+void bc66_power_on();
+
+//*****************************************************************************
+/**
+ * @brief
+ * Pull up PWRKEY to turn off the module
+ */
+void bc66_power_off();
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Function to get last modem response. 
+ * If send a new AT command, the buffer which contain the last response will be erased.
+ * 
+ * @return 
+ * Pointer to RX buffer with last response. 
+ */
+char * bc66_get_last_response( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the result of the last command: status, error number, command, elapsed 
+ * time and retransmissions. 
+ * 
+ * @param result : where the result is copied. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_last_result( bc66_result_t * result );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Send AT command to sync baud rate. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes. 
+ */
+bool bc66_send_cmd_AT( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set Command Echo Mode. 
+ * 
+ * This Execution Command determines whether or not the UE echoes characters 
+ * received from external MCU during command state. 
+ * 
+ * The command takes effect immediately. Remain valid after deep-sleep wakeup. 
+ * The configuration will be saved to NVRAM (should execute AT&W after this command is issued).
+ * 
+ * @param echo 
+ * - false: Echo mode OFF
+ * - true: Echo mode ON
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_echo_mode( bool echo );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * EPS Network Registration Status. 
+ * Configures the different unsolicited result codes for EPS 
+ * Network Registration Status.
+ * 
+ * @param net : Disable or enable network registration URC. 
+ * - 0 Disable network registration URC 
+ * - 1 Enable network registration URC: +CEREG: <stat> 
+ * - 2 Enable network registration and location information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>]] 
+ * - 3 Enable network registration, location information and EMM cause value information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,<cause_type>,<reject_cause>]] 
+ * - 4 For a UE that requests PSM, enable network registration and location information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,,[,[<Active-Time>],[<Periodic-TAU>]]]]  
+ * - 5 For a UE that requests PSM, enable network registration, location information and EMM cause value information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,[<cause_type>],[<reject_cause>][,[<Active-Time>],[<Periodic-TAU>]]]]
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_eps( unsigned int set );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Power Saving Mode Setting. 
+ * 
+ * @param mode 
+ * Integer type. Disable or enable the use of PSM in the UE 
+ * - 0 Disable the use of PSM 
+ * - 1 Enable the use of PSM 
+ * - 2 Disable the use of PSM and discard all parameters for PSM or, if available, reset to the default values.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_power_saving_mode( int mode );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * This function returns the IPv4 address of the device (PDP context BC66_DEFAULT_CID). 
+ * See \p bc66_get_pdp_address(...).
+ * 
+ * @param ip : pointer to struct variable to return IP ADDRESS (a1 is the first octet).
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */ 
+bc66_ret_t bc66_get_ipv4_address(bc66_ip_add_t * ip );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * This function returns the IPv6 address of the device (PDP context BC66_DEFAULT_CID). 
+ * See \p bc66_get_pdp_address(...).
+ * 
+ * @param ip : pointer to struct variable to return IPv6 ADDRESS.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */ 
+bc66_ret_t bc66_get_ipv6_address(bc66_ip6_add_t * ip );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the addresses of a PDP context (AT+CGPADDR). 
+ * 
+ * Addresses of all contexts are read with one command and cached. The cache is 
+ * invalidated by +CEREG, +IP and +CGEV URCs (enable them, i.e. \p bc66_set_eps(1)) 
+ * and by AT+CGATT / AT+QCGDEFCONT writes, so repeated calls do not use the UART. 
+ * 
+ * @param cid	: PDP context identifier. 
+ * @param addr	: where addresses are copied. 
+ * 
+ * @return 
+ * bc66_ret_no_ip if the context has no address, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_pdp_address( uint8_t cid, bc66_pdp_addr_t * addr );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Time Zone Reporting. Time zone URCs update the zone returned by \p bc66_get_time_zone(...), 
+ * +CTZEU also synchronizes the network time. 
+ * 
+ * @param mode : 
+ * - 0 Disable time zone URC 
+ * - 1 Enable time zone URC: +CTZV: <tz> 
+ * - 2 Enable extended time zone and local time URC: +CTZE: <tz>,<dst>,<time> 
+ * - 3 Enable extended time zone and UTC time URC: +CTZEU: <tz>,<dst>,<utime> 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_time_zone_report( unsigned int mode );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Synchronize network time (AT+CCLK?). The UTC time is stored against \p func_get_tick 
+ * so \p bc66_get_utc_time(...) does not use the UART. 
+ * 
+ * @return 
+ * bc66_ret_no_time if the module has no network time yet (not attached) or 
+ * \p func_get_tick is missing, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_sync_network_time( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get UTC time from the last network time synchronization and \p func_get_tick. 
+ * No AT command is sent. Call it at least once every 49 days (tick wrap). 
+ * 
+ * @param utc : seconds since 1970-01-01 00:00:00 UTC. 
+ * 
+ * @return 
+ * bc66_ret_no_time if network time was never synchronized, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_utc_time( uint32_t * utc );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get network time zone (last AT+CCLK? or time zone URC). 
+ * 
+ * @param quarters : time zone in quarters of an hour, i.e. +32 for UTC+8. 
+ * 
+ * @return 
+ * bc66_ret_no_time if the time zone is not known, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_time_zone( int8_t * quarters );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set Default PSD Connection
+ * 
+ * This command sets the PSD connection settings for PDN connection on power-up. 
+ * When attaching to the NB-IoT network on power-on, a PDN connection setup must be performed. 
+ * In order to allow this to happen, PDN connection settings must be stored in NVRAM, 
+ * thus making it to be used by the modem during the attach procedure.
+ * 
+ * @param pdp_type 	: Specify the type of packet data protocol. 
+ * @param apn 		: A logical name that is used to select the GGSN or the external packet data network. The maximum configurable APN length is 99 bytes.
+ * @param user		: The user name for accessing to the IP network. (Optional)
+ * @param pass		: The password for accessing to the IP network. (Optional)
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_psd_conn(pdp_type_t pdp_type, const char * apn, const char * user, const char * pass );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set Mobile Operation Band.
+ * 
+ * @param band_numb : band quantity. 
+ * - 0 all bands. 
+ * - 1 to 16 Number of bands to be locked.
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_mobile_bands( int band_number, ... );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set Mobile Operation Band from a list. 
+ * 
+ * @param bands	: bands to lock. 
+ * @param count	: band quantity, 0 for all bands. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_mobile_band_list( const uint8_t * bands, uint8_t count );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get Mobile Operation Band (AT+QBAND?). 
+ * 
+ * @param bands	: buffer of BC66_MAX_LOCKED_BANDS bands. 
+ * @param count	: bands returned. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_mobile_bands( uint8_t * bands, uint8_t * count );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get EPS network registration status (AT+CEREG?). 
+ * 
+ * @param stat : 
+ * - 0 Not registered, not searching 
+ * - 1 Registered, home network 
+ * - 2 Not registered, searching 
+ * - 3 Registration denied 
+ * - 4 Unknown 
+ * - 5 Registered, roaming 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_registration( uint8_t * stat );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * PS Attach or Detach (AT+CGATT). Blocks until the module answers (up to 85 s). 
+ * 
+ * @param attach : true to attach, false to detach. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_attach( bool attach );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Start the network bring-up without blocking: SIM ready, registration, PDP context 
+ * active and IP address. Stages advance on URCs (+CPIN, +CEREG, +CGEV, +IP); while 
+ * a stage waits, its state is queried every \p poll ms in case the URC is disabled 
+ * or was missed. Progress is reported from \p bc66_process(), which must be called 
+ * periodically. Needs \p func_get_tick. 
+ * 
+ * @param cfg		: stage timeouts, poll period and PDP context, NULL for defaults 
+ * (SIM 10 s, registration 180 s, PDP 30 s, IP 30 s, poll 2 s, BC66_DEFAULT_CID). 
+ * @param cb		: progress callback. 
+ * @param arg		: callback user argument. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_attach_start( const bc66_attach_cfg_t * cfg, bc66_attach_cb_t cb, void * arg );
 
-/// Struct to store IP ADDRESS. 
-typedef struct {
-	uint8_t	a1;
-	uint8_t	a2;
-	uint8_t	a3;
-	uint8_t	a4;
-} bc66_ip_add_t ;
+//*****************************************************************************
+/**
+ * @brief 
+ * Stop the bring-up. The running query, if any, ends normally. 
+ */
+void bc66_attach_cancel( void );
 
 //*****************************************************************************
 /**
  * @brief 
- * Function to initialize bc66 object. 
+ * Get how long a bring-up stage took. 
  * 
- * @param bc66_obj 
+ * @param stage		: stage, bc66_attach_done for the whole bring-up. 
+ * @param latency	: stage duration [ms], 0 if the stage did not end. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_init(bc66_obj_t *bc66_obj);
+bc66_ret_t bc66_attach_get_latency( bc66_attach_stage_t stage, uint32_t * latency );
 
 //*****************************************************************************
 /**
  * @brief 
- * Function to get any response stored in the RX buffer.
+ * Set the last known good network (band, EARFCN, PLMN) kept by the host, i.e. 
+ * read from flash at power on, and the hook to store it when it changes. 
  * 
- * @param rsp	: response to get 
+ * @param stored	: last known good network, NULL if there is not. 
+ * @param save		: called when \p bc66_net_cache_capture() finds a new network (optional). 
+ * @param arg		: hook user argument. 
  * 
  * @return 
- * Response if found, NULL otherwise
+ * See \p bc66_ret_t return codes.
  */
-char * bc66_get_at_response( char * rsp );
+bc66_ret_t bc66_net_cache_init( const bc66_net_cache_t * stored, bc66_net_cache_save_t save, void * arg );
 
 //*****************************************************************************
 /**
  * @brief 
- * Function to send at command sentence to bc66 module through an external function communication. 
+ * Get the last known good network. 
  * 
- * @param cmd_type	: BC66_CMD_TEST, BC66_CMD_READ, BC66_CMD_WRITE or BC66_CMD_EXE type.
- * @param cmd_lst 	: command to send (see command list). 
- * @param rsp 		: pointer to expected response text. 
- * @param arg_fmt 	: arguments format (like printf function) and must be sended all arguments too.
+ * @param cache : last known good network copy. 
  * 
  * @return 
- * See \p bc66_ret_t return codes. 
+ * bc66_ret_fail if there is not a known network, see \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_send_at_command(bc66_cmd_type_t cmd_type, const bc66_cmd_list_t cmd_lst, const char *exp_rsp, const char * arg_fmt, ...);
+bc66_ret_t bc66_net_cache_get( bc66_net_cache_t * cache );
 
 //*****************************************************************************
 /**
- * @brief
- * Reset the module via Hardware PIN.
+ * @brief 
+ * Store the serving network as last known good (AT+QENG=0, AT+COPS?). Call it 
+ * once registered. The save hook is called if band, EARFCN or PLMN changed. 
+ * If the operator is not reported in numeric format, it is read again with 
+ * AT+COPS=3,2 and the previous format is restored. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_hw_reset( void );
+bc66_ret_t bc66_net_cache_capture( void );
 
 //*****************************************************************************
 /**
- * @brief
- * Pull down PWRKEY to turn on the module
+ * @brief 
+ * Lock the search to the last known good network: band (AT+QBAND), EARFCN 
+ * (AT+QLOCKF) and PLMN (AT+COPS=1, asynchronous). Poll with \p bc66_net_cache_poll(): 
+ * if the module is not registered before \p deadline, locks are released and 
+ * the module goes back to a full scan. 
+ * 
+ * @param deadline : max time to register on the locked network [ms]. 
+ * 
+ * @return 
+ * bc66_ret_fail if there is not a known network, see \p bc66_ret_t return codes.
  */
-void bc66_power_on();
+bc66_ret_t bc66_net_cache_lock( uint32_t deadline );
 
 //*****************************************************************************
 /**
- * @brief
- * Pull up PWRKEY to turn off the module
+ * @brief 
+ * Check a locked search. Once registered the network is captured again and locks 
+ * are kept; on deadline or PLMN selection error locks are released (full scan). 
+ * 
+ * @return 
+ * - bc66_ret_busy while the module is searching 
+ * - bc66_ret_success when registered (or no locked search) 
+ * - bc66_ret_timeout when the fallback to full scan was done 
  */
-void bc66_power_off();
+bc66_ret_t bc66_net_cache_poll( void );
 
 //*****************************************************************************
 /**
  * @brief 
- * Function to get last modem response. 
- * If send a new AT command, the buffer which contain the last response will be erased.
+ * Release band, EARFCN and PLMN locks: bands before \p bc66_net_cache_lock(...), 
+ * AT+QLOCKF=0 and automatic PLMN selection. 
  * 
  * @return 
- * Pointer to RX buffer with last response. 
+ * See \p bc66_ret_t return codes.
  */
-char * bc66_get_last_response( void );
+bc66_ret_t bc66_net_cache_unlock( void );
 
 //*****************************************************************************
 /**
  * @brief 
- * Send AT command to sync baud rate. 
+ * Engineering mode snapshot (AT+QENG=0): serving cell radio values, coverage 
+ * enhancement level and neighbour cells. Response lines are parsed while 
+ * they are received, no response buffer is needed. 
+ * 
+ * @param info : snapshot. Values not reported by the module are BC66_CELL_NO_VALUE. 
  * 
  * @return 
- * See \p bc66_ret_t return codes. 
+ * See \p bc66_ret_t return codes.
  */
-bool bc66_send_cmd_AT( void );
+bc66_ret_t bc66_get_cell_info( bc66_cell_info_t * info );
 
 //*****************************************************************************
 /**
  * @brief 
- * Set Command Echo Mode. 
+ * Get serving cell coverage enhancement level (ECL). Transmission energy grows 
+ * with the level: ECL2 uses many repetitions of ECL0 packets. 
  * 
- * This Execution Command determines whether or not the UE echoes characters 
- * received from external MCU during command state. 
+ * @param ecl : coverage enhancement level, bc66_ecl_unknown if not camped. 
  * 
- * The command takes effect immediately. Remain valid after deep-sleep wakeup. 
- * The configuration will be saved to NVRAM (should execute AT&W after this command is issued).
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_coverage_level( bc66_ecl_t * ecl );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Enter PIN AT command.
+ * Return bc66_ret_success if Modem is READY.
  * 
- * @param echo 
- * - false: Echo mode OFF
- * - true: Echo mode ON
+ * The SIM state is cached from +CPIN lines (URC or AT+CPIN? answer): once the 
+ * SIM is ready no command is sent until a +CPIN URC reports another state. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_set_echo_mode( bool echo );
+bc66_ret_t bc66_is_ready( void );
 
 //*****************************************************************************
 /**
  * @brief 
- * EPS Network Registration Status. 
- * Configures the different unsolicited result codes for EPS 
- * Network Registration Status.
+ * Get the International Mobile Subscriber Identity (AT+CIMI). Read once and 
+ * cached until the SIM state changes. 
  * 
- * @param net : Disable or enable network registration URC. 
- * - 0 Disable network registration URC 
- * - 1 Enable network registration URC: +CEREG: <stat> 
- * - 2 Enable network registration and location information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>]] 
- * - 3 Enable network registration, location information and EMM cause value information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,<cause_type>,<reject_cause>]] 
- * - 4 For a UE that requests PSM, enable network registration and location information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,,[,[<Active-Time>],[<Periodic-TAU>]]]]  
- * - 5 For a UE that requests PSM, enable network registration, location information and EMM cause value information URC: +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,[<cause_type>],[<reject_cause>][,[<Active-Time>],[<Periodic-TAU>]]]]
+ * @param imsi	: IMSI string buffer. 
+ * @param size	: buffer size, at least BC66_IMSI_SIZE. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_set_eps( unsigned int set );
+bc66_ret_t bc66_get_imsi( char * imsi, size_t size );
 
 //*****************************************************************************
 /**
  * @brief 
- * Power Saving Mode Setting. 
+ * Get the USIM card identification (AT+QCCID). Read once and cached until the 
+ * SIM state changes. 
  * 
- * @param mode 
- * Integer type. Disable or enable the use of PSM in the UE 
- * - 0 Disable the use of PSM 
- * - 1 Enable the use of PSM 
- * - 2 Disable the use of PSM and discard all parameters for PSM or, if available, reset to the default values.
+ * @param iccid	: ICCID string buffer. 
+ * @param size	: buffer size, at least BC66_ICCID_SIZE. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_set_power_saving_mode( int mode );
+bc66_ret_t bc66_get_iccid( char * iccid, size_t size );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Probe product identification (ATI, AT+CGMR if ATI has not the revision) and 
+ * firmware capabilities: optional commands are tested (AT+<cmd>=?). Call it 
+ * once the module answers. The revision numbers are informational only. Data 
+ * mode and publish_max are not probed (AT+QMTPUB=? answers the same with or 
+ * without it): they are set to the data mode values and only dropped the first 
+ * time the module answers the prompt request with +CME ERROR: 4 (not supported). 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_probe_capabilities( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the product identification and capabilities found by \p bc66_probe_capabilities(). 
+ * 
+ * @param info : firmware information. 
+ * 
+ * @return 
+ * bc66_ret_fail if the probe was not done, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_get_fw_info( bc66_fw_info_t * info );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check a firmware capability. Before the probe every capability is assumed. 
+ * 
+ * @param cap : capability (\p bc66_cap_t flag). 
+ * 
+ * @return 
+ * true if the firmware has the capability.
+ */
+bool bc66_has_cap( bc66_cap_t cap );
 
 //*****************************************************************************
 /**
  * @brief 
- * This function returns the IP address of the device. Show PDP Addresses.
+ * Start a firmware update (DFOTA): the module downloads the image from \p url 
+ * (AT+QFOTADL), writes it and restarts. Drive it with \p bc66_fota_poll(). 
+ * The revision before the update is taken from the capability probe, if done. 
  * 
- * @param ip : pointer to struct variable to return IP ADDRESS.
+ * @param url			: image URL (http:// or https://). 
+ * @param image_size	: image size [bytes] for the throughput report, 0 if unknown. 
+ * @param save			: hook to store the state (phase changes and every 
+ * BC66_FOTA_SAVE_STEP %), NULL if not needed. 
+ * @param arg			: hook user argument. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
- */ 
-bc66_ret_t bc66_get_ipv4_address(bc66_ip_add_t * ip );
+ */
+bc66_ret_t bc66_fota_start( const char * url, uint32_t image_size, bc66_fota_save_t save, void * arg );
 
 //*****************************************************************************
 /**
  * @brief 
- * Set Default PSD Connection
+ * Resume a firmware update from a saved state, i.e. after a host reboot. The 
+ * module has no download state query (AT+QFOTADL has no read command): the 
+ * revision is queried, and an interrupted download is requested again only when 
+ * no +QIND: "FOTA" came in BC66_FOTA_RESUME_QUIET. An interrupted update goes on 
+ * to wait the new revision. Time while the host was down is not added to the phases. 
  * 
- * This command sets the PSD connection settings for PDN connection on power-up. 
- * When attaching to the NB-IoT network on power-on, a PDN connection setup must be performed. 
- * In order to allow this to happen, PDN connection settings must be stored in NVRAM, 
- * thus making it to be used by the modem during the attach procedure.
+ * @param state	: state given to the save hook. 
+ * @param save	: hook to store the state, NULL if not needed. 
+ * @param arg	: hook user argument. 
  * 
- * @param pdp_type 	: Specify the type of packet data protocol. 
- * @param apn 		: A logical name that is used to select the GGSN or the external packet data network. The maximum configurable APN length is 99 bytes.
- * @param user		: The user name for accessing to the IP network. (Optional)
- * @param pass		: The password for accessing to the IP network. (Optional)
+ * @return 
+ * bc66_ret_success if the update is running or was done, bc66_ret_fail if it 
+ * had failed, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_fota_resume( const bc66_fota_state_t * state, bc66_fota_save_t save, void * arg );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Drive the firmware update: processes received chars, accounts phase times, 
+ * requests a failed download again, queries the new revision once the module 
+ * reports its boot after the update (RDY or +CPIN: READY, or half 
+ * BC66_FOTA_VERIFY_TIMEOUT without them) and saves the state when it changed. 
+ * 
+ * @return 
+ * - bc66_ret_busy while the update is running 
+ * - bc66_ret_success when the new firmware runs (or no update) 
+ * - bc66_ret_fail when the update failed 
+ */
+bc66_ret_t bc66_fota_poll( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the firmware update state. 
+ * 
+ * @param state : update state. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_set_psd_conn(pdp_type_t pdp_type, const char * apn, const char * user, const char * pass );
+bc66_ret_t bc66_fota_get_state( bc66_fota_state_t * state );
 
 //*****************************************************************************
 /**
  * @brief 
- * Set Mobile Operation Band.
+ * Get the image download throughput: downloaded bytes over the download phase 
+ * time (failed attempts included). 
  * 
- * @param band_numb : band quantity. 
- * - 0 all bands. 
- * - 1 to 16 Number of bands to be locked.
+ * @param throughput : download throughput [bytes/s]. 
+ * 
+ * @return 
+ * bc66_ret_fail if the image size is unknown, nothing was downloaded or the update 
+ * failed, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_fota_get_throughput( uint32_t * throughput );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Start the liveness monitor: after consecutive command timeouts, or a long time 
+ * without received chars, \p bc66_health_poll() probes the module with AT and 
+ * escalates from resync to RESET pin to power cycle until it answers. After a 
+ * restart the cached settings (commands flagged BC66_CMD_FLAG_CFG, in the order 
+ * they were sent) are sent again. 
+ * 
+ * @param cfg	: configuration, NULL for the BC66_HEALTH_... defaults. 
+ * @param cb	: progress callback, NULL if not needed. 
+ * @param arg	: callback and power cycle hook user argument. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_set_mobile_bands( int band_number, ... );
+bc66_ret_t bc66_health_start( const bc66_health_cfg_t * cfg, bc66_health_cb_t cb, void * arg );
 
 //*****************************************************************************
 /**
  * @brief 
- * Enter PIN AT command.
- * Return bc66_ret_success if Modem is READY.
+ * Stop the liveness monitor. Metrics are kept. 
+ */
+void bc66_health_stop( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Drive the liveness monitor. Call it periodically while no command is running; 
+ * it blocks while probing (AT and resync timeouts), never during a restart wait. 
+ * 
+ * @return 
+ * - bc66_ret_success while the module answers 
+ * - bc66_ret_busy while a recovery is running: do not send commands 
+ * - bc66_ret_fail if the monitor is not running 
+ */
+bc66_ret_t bc66_health_poll( void );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the liveness monitor metrics. 
+ * 
+ * @param stats : metrics. 
  * 
  * @return 
  * See \p bc66_ret_t return codes.
  */
-bc66_ret_t bc66_is_ready( void );
+bc66_ret_t bc66_health_get_stats( bc66_health_stats_t * stats );
 
 //*****************************************************************************
 /**
@@ -375,6 +1567,20 @@ bc66_ret_t bc66_is_ready( void );
  */
 bc66_ret_t bc66_set_nbiot_event_report(bool enable, bool event );
 
+//*****************************************************************************
+/**
+ * @brief 
+ * Configure NB-IoT Release Assistance Indication (AT+QNBIOTRAI). The indication 
+ * is sent with the next uplink packets, so the network releases the RRC connection 
+ * without waiting for its inactivity timer. 
+ * 
+ * @param rai : release assistance indication. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_set_release_assistance( bc66_rai_t rai );
+
 //*****************************************************************************
 /**
  * @brief 
@@ -470,6 +1676,18 @@ bc66_ret_t bc66_connect_mqtt_client(const char * client_id, const char * user, c
  */
 bc66_ret_t bc66_disconn_mqtt_client( void );
 
+//*****************************************************************************
+/**
+ * @brief 
+ * Get the MQTT connection number. It changes when the connection is closed: by 
+ * \p bc66_disconn_mqtt_client(...), \p bc66_close_net_mqtt_client(...), the server 
+ * (+QMTSTAT URC) or a module reset. Compare it to tell if a connection is still live. 
+ * 
+ * @return 
+ * Connection number, 0 if the driver is not initialized.
+ */
+uint16_t bc66_mqtt_session( void );
+
 //*****************************************************************************
 /**
  * @brief 
@@ -490,3 +1708,100 @@ bc66_ret_t bc66_disconn_mqtt_client( void );
  */
 bc66_ret_t bc66_publish_msg_mqtt( const char * topic, const char * msg, int qos );
 
+//*****************************************************************************
+/**
+ * @brief 
+ * Publish a message of a burst. The last message of the burst is sent with release 
+ * assistance (no further data for QoS 0, one downlink for the QoS 1/2 acknowledge), 
+ * so the radio is released straight after it. Release assistance is then disabled 
+ * again for the next burst. 
+ * 
+ * @param topic	: Topic. The maximum length is 255 bytes. 
+ * @param msg 	: The message that needs to be published. The maximum length is 700 bytes. 
+ * @param qos	: QoS level (0 to 2). 
+ * @param last	: last message of the burst. 
+ * 
+ * @return 
+ * Publish result, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_publish_msg_mqtt_burst( const char * topic, const char * msg, int qos, bool last );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Publish Messages in data mode. 
+ * The message is written to the module straight from \p msg, without copying it 
+ * to the TX buffer, so it can hold any byte and does not need to be null terminated.
+ * 
+ * Firmware that answers the prompt request with +CME ERROR: 4 (not supported) 
+ * loses the data mode capability; then printable messages without '"' up to 
+ * 700 bytes are sent in the command line, and other messages are refused with 
+ * bc66_ret_no_cmd_implemented. 
+ * 
+ * @param topic		: Topic (not null terminated). The maximum length is 255 bytes. 
+ * @param topic_len	: Topic length. 
+ * @param msg 		: The message that needs to be published. The maximum length is 
+ * \p bc66_fw_info_t publish_max (1024 bytes in data mode). 
+ * @param msg_len	: Message length. 
+ * @param qos		: Integer type. The QoS level at which the client wants to publish the messages.
+ * - 0 At most once
+ * - 1 At least once
+ * - 2 Exactly once
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_publish_data_mqtt( const char * topic, size_t topic_len, const uint8_t * msg, size_t msg_len, int qos );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Subscribe to Topics. 
+ * Received messages are reported by +QMTRECV: <TCP_connectID>,<msgID>,<topic>,<payload>
+ * 
+ * @param topic	: Topic that the client wants to subscribe to. The maximum length is 255 bytes. 
+ * @param qos	: Integer type. The QoS level at which the client wants to receive the messages.
+ * - 0 At most once
+ * - 1 At least once
+ * - 2 Exactly once
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_subscribe_mqtt( const char * topic, int qos );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Unsubscribe from Topics. 
+ * 
+ * @param topic	: Topic that the client wants to unsubscribe from. The maximum length is 255 bytes. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_unsubscribe_mqtt( const char * topic );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Publish Messages without blocking (see \p bc66_cmd_start(...)). 
+ * 
+ * @param done_cb	: function called when the publish ends (optional). 
+ * @param arg		: callback user argument. 
+ * @param topic		: Topic (not null terminated). The maximum length is 255 bytes. 
+ * @param topic_len	: Topic length. 
+ * @param msg 		: The message that needs to be published (not null terminated). The maximum length is 700 bytes. 
+ * @param msg_len	: Message length. 
+ * @param qos		: Integer type. The QoS level at which the client wants to publish the messages.
+ * 
+ * @return 
+ * bc66_ret_success if the command was sent, see \p bc66_ret_t return codes otherwise. 
+ */
+bc66_ret_t bc66_publish_msg_mqtt_start( bc66_done_cb_t done_cb, void * arg, const char * topic, size_t topic_len, const char * msg, size_t msg_len, int qos );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BC66_DRV_H_ */
@@ -0,0 +1,567 @@
+/**
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @copyright   Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @file    bc66_drv.hpp
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @brief
+ * C++17/20 header-only layer over the BC66 C driver.
+ *
+ * - bc66::Modem, bc66::MqttSession and bc66::Subscription release the module,
+ *   the MQTT connection and the subscription when they go out of scope.
+ * - Payloads are passed as std::string_view or std::span<const std::byte> and
+ *   written to the module straight from caller memory (data mode publish).
+ * - Every call returns bc66::Result<T>: std::expected<T, bc66_ret_t> when the
+ *   standard library has it, an equivalent minimal type otherwise.
+ *
+ * Nothing is allocated on the heap.
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @date    10/17/2026
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @author    Eng. Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @version    1.0.0
+ *
+ */
+
+#ifndef BC66_DRV_HPP_
+#define BC66_DRV_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <utility>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+#if defined(__cpp_lib_span)
+#include <span>
+#endif
+#if defined(__cpp_lib_expected)
+#include <expected>
+#endif
+
+#include "bc66_drv.h"
+
+namespace bc66 {
+
+//*****************************************************************************
+// Result type
+
+#if defined(__cpp_lib_expected)
+
+/// Operation result: value or bc66_ret_t error code.
+template <class T>
+using Result = std::expected<T, bc66_ret_t>;
+
+/// Build a failed result.
+inline std::unexpected<bc66_ret_t> error( bc66_ret_t code ) { return std::unexpected<bc66_ret_t>( code ); }
+
+#else
+
+/// Failed result holder, see \p error(...).
+struct Unexpected {
+	bc66_ret_t code;
+};
+
+/// Build a failed result.
+inline Unexpected error( bc66_ret_t code ) { return Unexpected{ code }; }
+
+/// Operation result: value or bc66_ret_t error code (subset of std::expected).
+template <class T>
+class Result {
+public:
+	Result( const T & value ) : has_value_( true ) { new ( &value_ ) T( value ); }
+	Result( T && value ) : has_value_( true ) { new ( &value_ ) T( std::move( value ) ); }
+	Result( Unexpected e ) : has_value_( false ), error_( e.code ) {}
+	Result( Result && other ) : has_value_( other.has_value_ ) {
+		if( has_value_ ) {
+			new ( &value_ ) T( std::move( other.value_ ) );
+		} else {
+			error_ = other.error_;
+		}
+	}
+	Result( const Result & ) = delete;
+	Result & operator=( const Result & ) = delete;
+	Result & operator=( Result && ) = delete;
+	~Result() {
+		if( has_value_ ) {
+			value_.~T();
+		}
+	}
+
+	bool has_value() const noexcept { return has_value_; }
+	explicit operator bool() const noexcept { return has_value_; }
+	T & value() & { return value_; }
+	T && value() && { return std::move( value_ ); }
+	T & operator*() & { return value_; }
+	T * operator->() { return &value_; }
+	bc66_ret_t error() const noexcept { return error_; }
+
+private:
+	bool has_value_;
+	union {
+		T value_;
+		bc66_ret_t error_;
+	};
+};
+
+/// Operation result without value.
+template <>
+class Result<void> {
+public:
+	Result() : error_( bc66_ret_success ) {}
+	Result( Unexpected e ) : error_( e.code ) {}
+
+	bool has_value() const noexcept { return error_ == bc66_ret_success; }
+	explicit operator bool() const noexcept { return has_value(); }
+	bc66_ret_t error() const noexcept { return error_; }
+
+private:
+	bc66_ret_t error_;
+};
+
+#endif
+
+/// Convert a driver return code into a result.
+inline Result<void> check( bc66_ret_t code )
+{
+	if( code == bc66_ret_success ) {
+		return {};
+	}
+	return error( code );
+}
+
+namespace detail {
+
+//*****************************************************************************
+/// Null terminated copy of a string view, on the stack.
+template <std::size_t N>
+class CString {
+public:
+	explicit CString( std::string_view str ) : ok_( str.size() < N ) {
+		std::size_t len = ok_ ? str.size() : 0;
+		std::memcpy( buf_, str.data(), len );
+		buf_[len] = '\0';
+	}
+	bool ok() const noexcept { return ok_; }
+	const char * c_str() const noexcept { return buf_; }
+
+private:
+	char buf_[N];
+	bool ok_;
+};
+
+} // namespace detail
+
+//*****************************************************************************
+/**
+ * @brief
+ * MQTT topic subscription. Unsubscribes when destroyed.
+ */
+class Subscription {
+public:
+	Subscription( Subscription && other ) noexcept : topic_( other.topic_ ), session_( other.session_ ), active_( std::exchange( other.active_, false ) ) {}
+	Subscription( const Subscription & ) = delete;
+	Subscription & operator=( const Subscription & ) = delete;
+	Subscription & operator=( Subscription && ) = delete;
+	~Subscription() { unsubscribe(); }
+
+	/// Subscribed topic.
+	const char * topic() const noexcept { return topic_.c_str(); }
+
+	/// Unsubscribe now, reporting the result. Nothing is sent once its connection was closed.
+	Result<void> unsubscribe() {
+		if( !std::exchange( active_, false ) || ( bc66_mqtt_session() != session_ ) ) {
+			return {};
+		}
+		return check( bc66_unsubscribe_mqtt( topic_.c_str() ) );
+	}
+
+private:
+	friend class MqttSession;
+	explicit Subscription( const detail::CString<BC66_MQTT_TOPIC_MAX_LEN + 1> & topic ) : topic_( topic ), session_( bc66_mqtt_session() ), active_( true ) {}
+
+	detail::CString<BC66_MQTT_TOPIC_MAX_LEN + 1> topic_;
+	uint16_t session_;	///< MQTT connection it belongs to
+	bool active_;
+};
+
+//*****************************************************************************
+/**
+ * @brief
+ * MQTT client connection. Disconnects the client and closes the network when destroyed.
+ */
+class MqttSession {
+public:
+	MqttSession( MqttSession && other ) noexcept : open_( std::exchange( other.open_, false ) ) {}
+	MqttSession( const MqttSession & ) = delete;
+	MqttSession & operator=( const MqttSession & ) = delete;
+	MqttSession & operator=( MqttSession && ) = delete;
+	~MqttSession() { close(); }
+
+	/// Publish a message in data mode, straight from caller memory.
+	Result<void> publish( std::string_view topic, const void * payload, std::size_t len, int qos = 0 ) {
+		return check( bc66_publish_data_mqtt( topic.data(), topic.size(), static_cast<const uint8_t *>( payload ), len, qos ) );
+	}
+
+	/// Publish a text message.
+	Result<void> publish( std::string_view topic, std::string_view payload, int qos = 0 ) {
+		return publish( topic, payload.data(), payload.size(), qos );
+	}
+
+#if defined(__cpp_lib_span)
+	/// Publish a binary message.
+	Result<void> publish( std::string_view topic, std::span<const std::byte> payload, int qos = 0 ) {
+		return publish( topic, payload.data(), payload.size(), qos );
+	}
+#endif
+
+	/// Publish the last message of a burst with release assistance, so the radio is released after it.
+	Result<void> publish_last( std::string_view topic, std::string_view payload, int qos = 0 ) {
+		if( !bc66_has_cap( BC66_CAP_RAI ) ) {
+			return publish( topic, payload.data(), payload.size(), qos );
+		}
+		bc66_ret_t ret_code = bc66_set_release_assistance( qos ? bc66_rai_one_downlink : bc66_rai_no_data );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		Result<void> result = publish( topic, payload.data(), payload.size(), qos );
+		bc66_set_release_assistance( bc66_rai_none );
+		return result;
+	}
+
+	/// Subscribe to a topic. Messages are reported by +QMTRECV URC.
+	Result<Subscription> subscribe( std::string_view topic, int qos = 0 ) {
+		detail::CString<BC66_MQTT_TOPIC_MAX_LEN + 1> name( topic );
+		if( !name.ok() ) {
+			return error( bc66_ret_out_of_range );
+		}
+		bc66_ret_t ret_code = bc66_subscribe_mqtt( name.c_str(), qos );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return Subscription( name );
+	}
+
+	/// Disconnect client and close network now, reporting the result.
+	Result<void> close() {
+		if( !std::exchange( open_, false ) ) {
+			return {};
+		}
+		bc66_ret_t ret_code = bc66_disconn_mqtt_client();
+		bc66_ret_t close_code = bc66_close_net_mqtt_client();
+		return check( ( ret_code != bc66_ret_success ) ? ret_code : close_code );
+	}
+
+private:
+	friend class Modem;
+	MqttSession() : open_( true ) {}
+
+	bool open_;
+};
+
+//*****************************************************************************
+/**
+ * @brief
+ * BC66 module. Initializes the driver with the HAL object and releases it when destroyed.
+ */
+class Modem {
+public:
+	explicit Modem( bc66_obj_t & obj ) : obj_( &obj ), init_( bc66_init( &obj ) ) {}
+	Modem( Modem && other ) noexcept : obj_( std::exchange( other.obj_, nullptr ) ), init_( other.init_ ) {}
+	Modem( const Modem & ) = delete;
+	Modem & operator=( const Modem & ) = delete;
+	Modem & operator=( Modem && ) = delete;
+	~Modem() {
+		if( obj_ && ( init_ == bc66_ret_success ) ) {
+			bc66_deinit( obj_ );
+		}
+	}
+
+	/// Driver initialization result.
+	Result<void> status() const { return check( init_ ); }
+
+	/// HAL object.
+	bc66_obj_t * native_handle() const noexcept { return obj_; }
+
+	/// Send any command, see \p bc66_send_at_command(...).
+	template <class... Args>
+	Result<void> command( bc66_cmd_type_t type, bc66_cmd_list_t cmd, const char * exp_rsp, const char * arg_fmt, Args... args ) {
+		return check( bc66_send_at_command( type, cmd, exp_rsp, arg_fmt, args... ) );
+	}
+
+	/// Last modem response.
+	std::string_view last_response() const { return bc66_get_last_response(); }
+
+	/// Last command result: status, CME/CMS error number, command, sequence number, elapsed time and retransmissions.
+	bc66_result_t last_result() const {
+		bc66_result_t result{};
+		bc66_get_last_result( &result );
+		return result;
+	}
+
+	/// Cancel the running asynchronous command (its late answers are dropped).
+	Result<void> cancel() { return check( bc66_cmd_cancel() ); }
+
+	/// Drop every pending answer of older commands (ATI marker).
+	Result<void> resync() { return check( bc66_resync() ); }
+
+	Result<void> ready() { return check( bc66_is_ready() ); }
+	Result<void> set_echo_mode( bool echo ) { return check( bc66_set_echo_mode( echo ) ); }
+	Result<void> set_eps( unsigned int set ) { return check( bc66_set_eps( set ) ); }
+	Result<void> set_power_saving_mode( int mode ) { return check( bc66_set_power_saving_mode( mode ) ); }
+	Result<void> set_sleep_mode( uint8_t mode ) { return check( bc66_set_sleep_mode( mode ) ); }
+
+	/// Device IPv4 address.
+	Result<bc66_ip_add_t> ipv4_address() {
+		bc66_ip_add_t ip{};
+		bc66_ret_t ret_code = bc66_get_ipv4_address( &ip );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return ip;
+	}
+
+	/// Device IPv6 address.
+	Result<bc66_ip6_add_t> ipv6_address() {
+		bc66_ip6_add_t ip{};
+		bc66_ret_t ret_code = bc66_get_ipv6_address( &ip );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return ip;
+	}
+
+	/// Addresses of a PDP context (cached until a registration/PDP URC).
+	Result<bc66_pdp_addr_t> pdp_address( uint8_t cid ) {
+		bc66_pdp_addr_t addr{};
+		bc66_ret_t ret_code = bc66_get_pdp_address( cid, &addr );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return addr;
+	}
+
+	/// Engineering mode snapshot: serving cell, ECL and neighbour cells (AT+QENG=0).
+	Result<bc66_cell_info_t> cell_info() {
+		bc66_cell_info_t info{};
+		bc66_ret_t ret_code = bc66_get_cell_info( &info );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return info;
+	}
+
+	/// Serving cell coverage enhancement level.
+	Result<bc66_ecl_t> coverage_level() {
+		bc66_ecl_t ecl = bc66_ecl_unknown;
+		bc66_ret_t ret_code = bc66_get_coverage_level( &ecl );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return ecl;
+	}
+
+	/// EPS registration status (AT+CEREG?).
+	Result<uint8_t> registration() {
+		uint8_t stat = 0;
+		bc66_ret_t ret_code = bc66_get_registration( &stat );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return stat;
+	}
+
+	/// Last known good network (band, EARFCN, PLMN).
+	Result<bc66_net_cache_t> net_cache() {
+		bc66_net_cache_t cache{};
+		bc66_ret_t ret_code = bc66_net_cache_get( &cache );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return cache;
+	}
+
+	/// Probe product identification and firmware capabilities (ATI, AT+CGMR, AT+<cmd>=?).
+	Result<void> probe_capabilities() { return check( bc66_probe_capabilities() ); }
+
+	/// Product identification and capabilities of the last probe.
+	Result<bc66_fw_info_t> fw_info() {
+		bc66_fw_info_t info{};
+		bc66_ret_t ret_code = bc66_get_fw_info( &info );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return info;
+	}
+
+	/// Firmware capability (assumed before the probe).
+	bool has_cap( bc66_cap_t cap ) { return bc66_has_cap( cap ); }
+
+	/// Start a firmware update (DFOTA), drive it with fota_poll().
+	Result<void> fota_start( const char * url, uint32_t image_size = 0, bc66_fota_save_t save = nullptr, void * arg = nullptr ) {
+		return check( bc66_fota_start( url, image_size, save, arg ) );
+	}
+
+	/// Resume a firmware update from the state given to the save hook.
+	Result<void> fota_resume( const bc66_fota_state_t & state, bc66_fota_save_t save = nullptr, void * arg = nullptr ) {
+		return check( bc66_fota_resume( &state, save, arg ) );
+	}
+
+	/// Drive the firmware update: bc66_ret_busy while it runs.
+	bc66_ret_t fota_poll() { return bc66_fota_poll(); }
+
+	/// Firmware update state: phase, progress and time in each phase.
+	Result<bc66_fota_state_t> fota_state() {
+		bc66_fota_state_t state{};
+		bc66_ret_t ret_code = bc66_fota_get_state( &state );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return state;
+	}
+
+	/// Start the liveness monitor (null cfg: BC66_HEALTH_... defaults), drive it with health_poll().
+	Result<void> health_start( const bc66_health_cfg_t * cfg = nullptr, bc66_health_cb_t cb = nullptr, void * arg = nullptr ) {
+		return check( bc66_health_start( cfg, cb, arg ) );
+	}
+
+	/// Stop the liveness monitor, metrics are kept.
+	void health_stop() { bc66_health_stop(); }
+
+	/// Drive the liveness monitor: bc66_ret_busy while a recovery runs.
+	bc66_ret_t health_poll() { return bc66_health_poll(); }
+
+	/// Liveness monitor metrics: recoveries per tier and time to recover.
+	Result<bc66_health_stats_t> health_stats() {
+		bc66_health_stats_t stats{};
+		bc66_ret_t ret_code = bc66_health_get_stats( &stats );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return stats;
+	}
+
+	/// Lines the driver does not handle (i.e. +QMTRECV messages), delivered while idle. Null keeps them for bc66_get_at_response().
+	Result<void> set_urc_callback( bc66_line_cb_t cb, void * arg = nullptr ) { return check( bc66_set_urc_callback( cb, arg ) ); }
+
+	/// Push received bytes from the UART ISR or DMA callback (func_r_bytes_ptr null, needs BC66_RX_RING_SIZE), returns bytes stored.
+	std::size_t rx_feed( const uint8_t * bytes, std::size_t len ) noexcept { return bc66_rx_feed( obj_, bytes, len ); }
+
+	/// Received bytes dropped by rx_feed() with the ring full.
+	Result<uint32_t> rx_dropped() {
+		uint32_t dropped = 0;
+		bc66_ret_t ret_code = bc66_get_rx_dropped( &dropped );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return dropped;
+	}
+
+	/// Release assistance indication for next uplink packets (AT+QNBIOTRAI).
+	Result<void> set_release_assistance( bc66_rai_t rai ) { return check( bc66_set_release_assistance( rai ) ); }
+
+	/// Time zone URC mode (AT+CTZR).
+	Result<void> set_time_zone_report( unsigned int mode ) { return check( bc66_set_time_zone_report( mode ) ); }
+
+	/// Synchronize network time (AT+CCLK?).
+	Result<void> sync_network_time() { return check( bc66_sync_network_time() ); }
+
+	/// UTC time [s since 1970] from last synchronization, no AT command.
+	Result<uint32_t> utc_time() {
+		uint32_t utc = 0;
+		bc66_ret_t ret_code = bc66_get_utc_time( &utc );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return utc;
+	}
+
+	/// Network time zone [quarters of an hour].
+	Result<int8_t> time_zone() {
+		int8_t quarters = 0;
+		bc66_ret_t ret_code = bc66_get_time_zone( &quarters );
+		if( ret_code != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		return quarters;
+	}
+
+	/// Set default PSD connection. Empty user/pass are not sent.
+	Result<void> set_psd_conn( pdp_type_t type, std::string_view apn, std::string_view user = {}, std::string_view pass = {} ) {
+		detail::CString<BC66_APN_MAX_LEN + 1> c_apn( apn );
+		detail::CString<BC66_PSD_USER_MAX_LEN + 1> c_user( user );
+		detail::CString<BC66_PSD_PASS_MAX_LEN + 1> c_pass( pass );
+		if( !c_apn.ok() || !c_user.ok() || !c_pass.ok() ) {
+			return error( bc66_ret_out_of_range );
+		}
+		return check( bc66_set_psd_conn( type, c_apn.c_str(), user.empty() ? nullptr : c_user.c_str(), pass.empty() ? nullptr : c_pass.c_str() ) );
+	}
+
+	Result<void> set_mqtt_parameters( uint16_t keepalive, bool dataformat, bool session, bool version ) {
+		return check( bc66_set_mqtt_parameters( keepalive, dataformat, session, version ) );
+	}
+
+	/// Open network and connect MQTT client. The session closes both when destroyed.
+	Result<MqttSession> mqtt_connect( std::string_view server, uint16_t port, std::string_view client_id,
+									  std::string_view user = {}, std::string_view pass = {} ) {
+		detail::CString<BC66_MQTT_SERVER_MAX_LEN + 1> c_server( server );
+		detail::CString<BC66_MQTT_CLIENT_ID_MAX_LEN + 1> c_id( client_id );
+		detail::CString<BC66_MQTT_USER_MAX_LEN + 1> c_user( user );
+		detail::CString<BC66_MQTT_PASS_MAX_LEN + 1> c_pass( pass );
+		bc66_ret_t ret_code;
+
+		if( !c_server.ok() || !c_id.ok() || !c_user.ok() || !c_pass.ok() ) {
+			return error( bc66_ret_out_of_range );
+		}
+		if( ( ret_code = bc66_open_net_mqtt_client( c_server.c_str(), port ) ) != bc66_ret_success ) {
+			return error( ret_code );
+		}
+		if( ( ret_code = bc66_connect_mqtt_client( c_id.c_str(), c_user.c_str(), c_pass.c_str() ) ) != bc66_ret_success ) {
+			bc66_close_net_mqtt_client();
+			return error( ret_code );
+		}
+		return MqttSession();
+	}
+
+private:
+	bc66_obj_t * obj_;
+	bc66_ret_t init_;
+};
+
+} // namespace bc66
+
+#endif /* BC66_DRV_HPP_ */
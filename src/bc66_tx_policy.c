@@ -0,0 +1,386 @@
+/**
+ *
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @copyright   Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @file    bc66_tx_policy.c
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @brief
+ * BC66 link quality transmit policy. See bc66_tx_policy.h.
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @date    10/17/2026
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @author    Eng. Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @version    1.0.0
+ *
+ */
+
+#include <string.h>
+#include "bc66_tx_policy.h"
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Energy of one transmission at a coverage enhancement level. 
+ * 
+ * @param policy	: transmit policy. 
+ * @param ecl		: coverage enhancement level (ECL0 to ECL2). 
+ * 
+ * @return 
+ * Relative energy cost.
+ */
+static uint32_t _bc66_tx_cost( const bc66_tx_policy_t * policy, uint8_t ecl )
+{
+	return policy->thresholds.ecl_cost[(ecl <= bc66_ecl_2) ? ecl : bc66_ecl_2];
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Check if no message after \p first will be published by this run. 
+ * 
+ * @param policy	: transmit policy. 
+ * @param first		: first queue index to check. 
+ * @param now		: current tick [ms]. 
+ * 
+ * @return 
+ * true if the message before \p first is the last of the burst.
+ */
+static bool _bc66_tx_last( const bc66_tx_policy_t * policy, uint8_t first, uint32_t now )
+{
+	bc66_obj_t * obj = bc66_selected();
+	uint8_t i;
+
+	if( policy->link_good || (obj->func_get_tick == NULL) ) { 
+		return first >= policy->count;
+	}
+	for( i = first; i < policy->count; i++ ) { 
+		uint32_t max_age = policy->classes[policy->queue[i].cls].max_age;
+		if( !max_age || ((uint32_t)(now - policy->queue[i].queued) >= max_age) ) { 
+			return false;
+		}
+	}
+	return true;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Initialize a transmit policy with default thresholds (RSRP -110 dBm, 
+ * hysteresis 5 dB, max ECL1, costs 1/4/16) and the default gate. All classes 
+ * are never held until \p bc66_tx_policy_set_class(...) is called. 
+ * 
+ * @param policy : transmit policy. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_tx_policy_init( bc66_tx_policy_t * policy )
+{
+	if( policy == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	memset( policy, 0, sizeof(*policy) );
+	policy->thresholds.rsrp_min = -110;
+	policy->thresholds.rsrp_hysteresis = 5;
+	policy->thresholds.ecl_max = bc66_ecl_1;
+	policy->thresholds.ecl_cost[bc66_ecl_0] = 1;
+	policy->thresholds.ecl_cost[bc66_ecl_1] = 4;
+	policy->thresholds.ecl_cost[bc66_ecl_2] = 16;
+	policy->gate = bc66_tx_gate_default;
+	policy->link_good = true;
+	policy->ecl = bc66_ecl_unknown;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set the max hold time of a message class. 
+ * 
+ * @param policy	: transmit policy. 
+ * @param cls		: class, lower than BC66_TX_CLASSES. 
+ * @param max_age	: max hold time [ms], 0 = never held. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_tx_policy_set_class( bc66_tx_policy_t * policy, uint8_t cls, uint32_t max_age )
+{
+	if( (policy == NULL) || (cls >= BC66_TX_CLASSES) ) { 
+		return bc66_ret_out_of_range;
+	}
+
+	policy->classes[cls].max_age = max_age;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Replace the link quality gate. 
+ * 
+ * @param policy	: transmit policy. 
+ * @param gate		: gate function, NULL for \p bc66_tx_gate_default. 
+ * @param arg		: gate user argument (\p policy->gate_arg). 
+ */
+void bc66_tx_policy_set_gate( bc66_tx_policy_t * policy, bc66_tx_gate_t gate, void * arg )
+{
+	policy->gate = gate ? gate : bc66_tx_gate_default;
+	policy->gate_arg = arg;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Default gate: good when camped, ECL <= ecl_max and RSRP >= rsrp_min 
+ * (rsrp_min + rsrp_hysteresis to leave a poor link state). 
+ * 
+ * @param cell		: current serving cell snapshot. 
+ * @param policy	: policy thresholds. 
+ * 
+ * @return 
+ * true if the link is good enough.
+ */
+bool bc66_tx_gate_default( const bc66_cell_info_t * cell, const bc66_tx_policy_t * policy )
+{
+	int16_t rsrp_min = policy->thresholds.rsrp_min;
+
+	if( !cell->camped || (cell->ecl > policy->thresholds.ecl_max) ) { 
+		return false;
+	}
+	if( cell->rsrp == BC66_CELL_NO_VALUE ) { 
+		return true;
+	}
+	if( !policy->link_good ) { 
+		rsrp_min += policy->thresholds.rsrp_hysteresis;
+	}
+	return cell->rsrp >= rsrp_min;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Queue a message. It is published by the next \p bc66_tx_policy_run(...). 
+ * 
+ * @param policy	: transmit policy. 
+ * @param topic		: topic, valid until sent. 
+ * @param msg		: payload, valid until sent. 
+ * @param qos		: QoS. 
+ * @param cls		: message class. 
+ * @param sent_cb	: sent callback (optional). 
+ * @param arg		: callback user argument. 
+ * 
+ * @return 
+ * bc66_ret_queue_full if there is not room, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_tx_policy_queue( bc66_tx_policy_t * policy, const char * topic, const char * msg, int qos, uint8_t cls, bc66_tx_sent_cb_t sent_cb, void * arg )
+{
+	bc66_obj_t * obj = bc66_selected();
+	bc66_tx_msg_t * m;
+
+	if( (policy == NULL) || (topic == NULL) || (msg == NULL) || (qos < 0) || (qos > 2) || (cls >= BC66_TX_CLASSES) ) { 
+		return bc66_ret_out_of_range;
+	}
+	if( policy->count >= BC66_TX_QUEUE_SIZE ) { 
+		return bc66_ret_queue_full;
+	}
+
+	m = &policy->queue[policy->count++];
+	m->topic = topic;
+	m->msg = msg;
+	m->sent_cb = sent_cb;
+	m->arg = arg;
+	m->queued = (obj && obj->func_get_tick) ? obj->func_get_tick() : 0;
+	m->qos = (uint8_t)qos;
+	m->cls = cls;
+	m->held = false;
+	m->held_ecl = bc66_ecl_unknown;
+	m->attempts = 0;
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Publish the queued messages the link allows, on the selected module. Call it 
+ * periodically and after new messages are queued. Messages of classes that are 
+ * never held and expired messages are always published. 
+ * 
+ * Message age needs \p func_get_tick: without it every message is published 
+ * at once. 
+ * 
+ * The last message published by a run carries release assistance, see 
+ * \p bc66_publish_msg_mqtt_burst(...). 
+ * 
+ * A failed publish ends the run. The message stays first in the queue and is 
+ * retried by the next runs, up to BC66_TX_MAX_RETRIES times, then it is removed 
+ * and its sent callback gets the error. 
+ * 
+ * @param policy	: transmit policy. 
+ * @param cell		: current serving cell, NULL to read it (AT+QENG=0) when needed. 
+ * 
+ * @return 
+ * Result of the first failed command, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_tx_policy_run( bc66_tx_policy_t * policy, const bc66_cell_info_t * cell )
+{
+	bc66_obj_t * obj = bc66_selected();
+	bc66_cell_info_t info;
+	bc66_ret_t ret_code;
+	uint32_t now;
+	uint8_t i;
+
+	if( policy == NULL ) { 
+		return bc66_ret_out_of_range;
+	}
+	if( obj == NULL ) { 
+		return bc66_ret_not_init;
+	}
+	if( obj->func_get_tick == NULL ) { 
+		cell = NULL;
+	}
+	now = obj->func_get_tick ? obj->func_get_tick() : 0;
+
+	// link quality is only needed for messages that can still wait 
+	for( i = 0; (cell == NULL) && obj->func_get_tick && (i < policy->count); i++ ) { 
+		uint32_t max_age = policy->classes[policy->queue[i].cls].max_age;
+		if( max_age && ((uint32_t)(now - policy->queue[i].queued) < max_age) ) { 
+			if( (ret_code = bc66_get_cell_info( &info )) != bc66_ret_success ) { 
+				return ret_code;
+			}
+			cell = &info;
+		}
+	}
+	if( cell ) { 
+		policy->link_good = policy->gate( cell, policy );
+		policy->ecl = cell->camped ? cell->ecl : bc66_ecl_unknown;
+	}
+
+	i = 0;
+	while( i < policy->count ) { 
+		bc66_tx_msg_t m = policy->queue[i];
+		uint32_t max_age = policy->classes[m.cls].max_age;
+		bool expired = !max_age || !obj->func_get_tick || ((uint32_t)(now - m.queued) >= max_age);
+		uint32_t cost = 0;
+
+		if( !expired && !policy->link_good ) { 
+			if( !policy->queue[i].held ) { 
+				policy->queue[i].held = true;
+				policy->queue[i].held_ecl = (uint8_t)policy->ecl;
+				policy->stats.deferred ++;
+			}
+			i++;
+			continue;
+		}
+
+		ret_code = bc66_publish_msg_mqtt_burst( m.topic, m.msg, m.qos, _bc66_tx_last( policy, i + 1, now ) );
+		if( (ret_code != bc66_ret_success) && (ret_code != bc66_ret_packet_retransmission) ) { 
+			// kept for the next run until the retries are used up 
+			if( ++policy->queue[i].attempts <= BC66_TX_MAX_RETRIES ) { 
+				policy->stats.retried ++;
+				return ret_code;
+			}
+			policy->stats.failed ++;
+			policy->count --;
+			memmove( &policy->queue[i], &policy->queue[i + 1], (policy->count - i) * sizeof(policy->queue[0]) );
+			if( m.sent_cb ) { 
+				m.sent_cb( ret_code, m.arg );
+			}
+			return ret_code;
+		}
+
+		// packet retransmission: the module keeps sending it, it is not published again 
+		policy->stats.sent ++;
+		if( policy->ecl != bc66_ecl_unknown ) { 
+			cost = _bc66_tx_cost( policy, (uint8_t)policy->ecl );
+			policy->stats.cost_sent += cost;
+		}
+		if( !m.held ) { 
+			policy->stats.sent_direct ++;
+		} else { 
+			if( policy->link_good ) { 
+				policy->stats.released_good ++;
+			} else { 
+				policy->stats.released_expired ++;
+			}
+			// energy is only compared between known coverage levels 
+			if( (m.held_ecl != bc66_ecl_unknown) && (policy->ecl != bc66_ecl_unknown) ) { 
+				uint32_t held_cost = _bc66_tx_cost( policy, m.held_ecl );
+				if( held_cost > cost ) { 
+					policy->stats.cost_avoided += held_cost - cost;
+				}
+			}
+		}
+
+		// remove before the callback, it can queue again 
+		policy->count --;
+		memmove( &policy->queue[i], &policy->queue[i + 1], (policy->count - i) * sizeof(policy->queue[0]) );
+		if( m.sent_cb ) { 
+			m.sent_cb( ret_code, m.arg );
+		}
+	}
+	return bc66_ret_success;
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Drop all queued messages. Sent callbacks get bc66_ret_fail. 
+ * 
+ * @param policy : transmit policy. 
+ */
+void bc66_tx_policy_flush( bc66_tx_policy_t * policy )
+{
+	while( policy->count ) { 
+		bc66_tx_msg_t m = policy->queue[0];
+		policy->count --;
+		memmove( &policy->queue[0], &policy->queue[1], policy->count * sizeof(policy->queue[0]) );
+		if( m.sent_cb ) { 
+			m.sent_cb( bc66_ret_fail, m.arg );
+		}
+	}
+}
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get policy statistics. 
+ * 
+ * @param policy	: transmit policy. 
+ * @param stats		: statistics copy. 
+ */
+void bc66_tx_policy_get_stats( const bc66_tx_policy_t * policy, bc66_tx_stats_t * stats )
+{
+	*stats = policy->stats;
+}
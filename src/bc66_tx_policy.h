@@ -0,0 +1,265 @@
+/**
+ *
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @copyright   Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @file    bc66_tx_policy.h
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @brief
+ * BC66 link quality transmit policy.
+ * 
+ * Deferrable messages are queued and published with \p bc66_publish_msg_mqtt(...) 
+ * only when the serving cell is good (RSRP, coverage enhancement level), or when 
+ * they reach the max age of their class. Repetitions at ECL1/ECL2 multiply the 
+ * energy of each packet, so waiting for a better link saves battery.
+ * 
+ * Messages are not copied: topic and payload must stay valid until the sent 
+ * callback is called.
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @date    10/17/2026
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @author    Eng. Juan Cruz Becerra
+ *
+ * ---------------------------------------------------------------------------------------------
+ *
+ * @version    1.0.0
+ *
+ */
+
+#ifndef BC66_TX_POLICY_H_
+#define BC66_TX_POLICY_H_
+
+#include "bc66_drv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bc66_tx_policy bc66_tx_policy_t;
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Link quality gate. Decides if deferrable messages can be sent now. 
+ * 
+ * @param cell		: current serving cell snapshot. 
+ * @param policy	: policy (thresholds, previous decision in \p link_good). 
+ * 
+ * @return 
+ * true if the link is good enough.
+ */
+typedef bool (*bc66_tx_gate_t)( const bc66_cell_info_t * cell, const bc66_tx_policy_t * policy );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Called when a queued message is published, fails after BC66_TX_MAX_RETRIES 
+ * retries, or is dropped by \p bc66_tx_policy_flush(). Topic and payload can be 
+ * released here. 
+ * 
+ * @param ret_code	: publish result: bc66_ret_success, bc66_ret_packet_retransmission 
+ * (handed to the module, which is still retransmitting it) or the last error 
+ * (see \p bc66_ret_t return codes). 
+ * @param arg		: message user argument. 
+ */
+typedef void (*bc66_tx_sent_cb_t)( bc66_ret_t ret_code, void * arg );
+
+/// Default gate thresholds. 
+typedef struct {
+	int16_t		rsrp_min;				///< hold below this RSRP (module units, BC66: dBm)
+	int16_t		rsrp_hysteresis;		///< release at rsrp_min + hysteresis
+	bc66_ecl_t	ecl_max;				///< hold above this coverage enhancement level
+	uint16_t	ecl_cost[3];			///< relative energy of one transmission at ECL0, ECL1, ECL2
+} bc66_tx_thresholds_t ;
+
+/// Message class. 
+typedef struct {
+	uint32_t	max_age;				///< max hold time [ms], 0 = never held
+} bc66_tx_class_t ;
+
+/// Transmit policy statistics. Costs use \p ecl_cost units. 
+typedef struct {
+	uint32_t	sent;					///< published messages
+	uint32_t	sent_direct;			///< published without being held
+	uint32_t	deferred;				///< messages held at least once
+	uint32_t	released_good;			///< held messages published after the link improved
+	uint32_t	released_expired;		///< held messages published at max age on a poor link
+	uint32_t	retried;				///< publish errors kept for the next run
+	uint32_t	failed;					///< messages dropped after BC66_TX_MAX_RETRIES retries
+	uint32_t	cost_sent;				///< energy of published messages (known ECL only)
+	uint32_t	cost_avoided;			///< energy saved: cost when held - cost when published (known ECL only)
+} bc66_tx_stats_t ;
+
+/// Queued message (policy internal). 
+typedef struct {
+	const char 			*topic;			///< topic
+	const char 			*msg;			///< payload
+	bc66_tx_sent_cb_t 	sent_cb;		///< sent callback
+	void 				*arg;			///< callback user argument
+	uint32_t 			queued;			///< tick when queued [ms]
+	uint8_t 			qos;			///< QoS
+	uint8_t 			cls;			///< class
+	bool 				held;			///< held at least once
+	uint8_t 			held_ecl;		///< ECL when first held
+	uint8_t 			attempts;		///< failed publish attempts
+} bc66_tx_msg_t ;
+
+/// Transmit policy. 
+struct bc66_tx_policy {
+	bc66_tx_thresholds_t 	thresholds;					///< default gate thresholds
+	bc66_tx_class_t 		classes[BC66_TX_CLASSES];	///< message classes
+	bc66_tx_gate_t 			gate;						///< link quality gate
+	void 					*gate_arg;					///< gate user argument
+	bool 					link_good;					///< last gate decision
+	bc66_ecl_t 				ecl;						///< last coverage enhancement level
+	bc66_tx_stats_t 		stats;						///< statistics
+	bc66_tx_msg_t 			queue[BC66_TX_QUEUE_SIZE];	///< held messages, oldest first
+	uint8_t 				count;						///< messages in queue
+};
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Initialize a transmit policy with default thresholds (RSRP -110 dBm, 
+ * hysteresis 5 dB, max ECL1, costs 1/4/16) and the default gate. All classes 
+ * are never held until \p bc66_tx_policy_set_class(...) is called. 
+ * 
+ * @param policy : transmit policy. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_tx_policy_init( bc66_tx_policy_t * policy );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Set the max hold time of a message class. 
+ * 
+ * @param policy	: transmit policy. 
+ * @param cls		: class, lower than BC66_TX_CLASSES. 
+ * @param max_age	: max hold time [ms], 0 = never held. 
+ * 
+ * @return 
+ * See \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_tx_policy_set_class( bc66_tx_policy_t * policy, uint8_t cls, uint32_t max_age );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Replace the link quality gate. 
+ * 
+ * @param policy	: transmit policy. 
+ * @param gate		: gate function, NULL for \p bc66_tx_gate_default. 
+ * @param arg		: gate user argument (\p policy->gate_arg). 
+ */
+void bc66_tx_policy_set_gate( bc66_tx_policy_t * policy, bc66_tx_gate_t gate, void * arg );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Default gate: good when camped, ECL <= ecl_max and RSRP >= rsrp_min 
+ * (rsrp_min + rsrp_hysteresis to leave a poor link state). 
+ * 
+ * @param cell		: current serving cell snapshot. 
+ * @param policy	: policy thresholds. 
+ * 
+ * @return 
+ * true if the link is good enough.
+ */
+bool bc66_tx_gate_default( const bc66_cell_info_t * cell, const bc66_tx_policy_t * policy );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Queue a message. It is published by the next \p bc66_tx_policy_run(...). 
+ * 
+ * @param policy	: transmit policy. 
+ * @param topic		: topic, valid until sent. 
+ * @param msg		: payload, valid until sent. 
+ * @param qos		: QoS. 
+ * @param cls		: message class. 
+ * @param sent_cb	: sent callback (optional). 
+ * @param arg		: callback user argument. 
+ * 
+ * @return 
+ * bc66_ret_queue_full if there is not room, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_tx_policy_queue( bc66_tx_policy_t * policy, const char * topic, const char * msg, int qos, uint8_t cls, bc66_tx_sent_cb_t sent_cb, void * arg );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Publish the queued messages the link allows, on the selected module. Call it 
+ * periodically and after new messages are queued. Messages of classes that are 
+ * never held and expired messages are always published. 
+ * 
+ * Message age needs \p func_get_tick: without it every message is published 
+ * at once. 
+ * 
+ * The last message published by a run carries release assistance, see 
+ * \p bc66_publish_msg_mqtt_burst(...). 
+ * 
+ * A failed publish ends the run. The message stays first in the queue and is 
+ * retried by the next runs, up to BC66_TX_MAX_RETRIES times, then it is removed 
+ * and its sent callback gets the error. 
+ * 
+ * @param policy	: transmit policy. 
+ * @param cell		: current serving cell, NULL to read it (AT+QENG=0) when needed. 
+ * 
+ * @return 
+ * Result of the first failed command, see \p bc66_ret_t return codes.
+ */
+bc66_ret_t bc66_tx_policy_run( bc66_tx_policy_t * policy, const bc66_cell_info_t * cell );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Drop all queued messages. Sent callbacks get bc66_ret_fail. 
+ * 
+ * @param policy : transmit policy. 
+ */
+void bc66_tx_policy_flush( bc66_tx_policy_t * policy );
+
+//*****************************************************************************
+/**
+ * @brief 
+ * Get policy statistics. 
+ * 
+ * @param policy	: transmit policy. 
+ * @param stats		: statistics copy. 
+ */
+void bc66_tx_policy_get_stats( const bc66_tx_policy_t * policy, bc66_tx_stats_t * stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BC66_TX_POLICY_H_ */